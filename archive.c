@@ -0,0 +1,192 @@
+#define _POSIX_C_SOURCE 200809L /* Required for mmap */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "./archive.h"
+#include "./object.h"
+
+/*
+  This file holds the functions that write the output archive and map it back from the disk.
+  The layout of the archive is described in archive.h.
+*/
+
+typedef char archiveHeaderSizeCheck[sizeof(archiveHeader) == 28 && sizeof(archiveMember) == 12 ? 1 : -1]; /* The mapped structs require 16 and 32 bit shorts and ints */
+
+static FILE *archive; /* The archive that is being written */
+static char *archiveFileName;
+static objectBuffer directory, names; /* The directory and the names of the members that were added so far */
+static unsigned long archiveSize, memberCount; /* archiveSize is the offset the next payload is written at */
+
+/*
+  Writes size bytes to the archive, exits if they cannot be written.
+*/
+static void archiveWrite(void *data, unsigned long size) {
+  if (size > 0 && fwrite(data, 1, size, archive) != size) {
+    printf("Cannot write to file %s\n", archiveFileName);
+    exit(0);
+  }
+  archiveSize += size;
+}
+
+/*
+  Writes the header with the given counts at the start of the archive.
+*/
+static void writeHeader(unsigned long directoryOffset, unsigned long namesOffset, unsigned long fileSize) {
+  objectBuffer header;
+
+  objectInit(&header);
+  objectReserve(&header, sizeof(archiveHeader));
+  memcpy(header.data, ARCHIVE_MAGIC, sizeof(((archiveHeader *) 0)->magic));
+  objectPut16(&header, offsetof(archiveHeader, version), ARCHIVE_VERSION);
+  objectPut16(&header, offsetof(archiveHeader, headerSize), sizeof(archiveHeader));
+  objectPut32(&header, offsetof(archiveHeader, memberCount), memberCount);
+  objectPut32(&header, offsetof(archiveHeader, directoryOffset), directoryOffset);
+  objectPut32(&header, offsetof(archiveHeader, namesOffset), namesOffset);
+  objectPut32(&header, offsetof(archiveHeader, namesSize), names.size);
+  objectPut32(&header, offsetof(archiveHeader, fileSize), fileSize);
+
+  fseek(archive, 0, SEEK_SET);
+  archiveSize = 0;
+  archiveWrite(header.data, header.size);
+  objectFree(&header);
+}
+
+/*
+  Accepts the name of the archive.
+  Creates the archive, replacing an archive from a previous run, and writes a header that is completed when it is closed.
+  Prints a message and returns -1 if the archive cannot be created.
+*/
+int archiveOpen(char *fileName) {
+  if ((archive = fopen(fileName, "wb")) == NULL) {
+    printf("Cannot open file %s\n", fileName);
+    return -1;
+  }
+
+  archiveFileName = fileName;
+  memberCount = 0;
+  objectInit(&directory);
+  objectInit(&names);
+  writeHeader(0, 0, 0);
+  return 0;
+}
+
+/*
+  Accepts the name of a member and its bytes.
+  Appends the bytes to the archive and adds the member to the directory.
+*/
+void archiveAdd(char *name, char *data, unsigned long size) {
+  unsigned long member = objectReserve(&directory, sizeof(archiveMember));
+
+  objectPut32(&directory, member + offsetof(archiveMember, name), objectAppend(&names, name, strlen(name) + 1));
+  objectPut32(&directory, member + offsetof(archiveMember, offset), archiveSize);
+  objectPut32(&directory, member + offsetof(archiveMember, size), size);
+
+  archiveWrite(data, size);
+  memberCount++;
+}
+
+/*
+  Writes the directory and the names after the last payload, completes the header and closes the archive.
+  Prints a message and returns -1 if the archive cannot be written.
+*/
+int archiveClose() {
+  static char padding[OBJECT_ALIGN];
+  unsigned long directoryOffset, namesOffset;
+
+  if (archive == NULL) {
+    return 0;
+  }
+
+  archiveWrite(padding, (OBJECT_ALIGN - archiveSize % OBJECT_ALIGN) % OBJECT_ALIGN);
+  directoryOffset = archiveSize;
+  archiveWrite(directory.data, directory.size);
+  namesOffset = archiveSize;
+  archiveWrite(names.data, names.size);
+
+  writeHeader(directoryOffset, namesOffset, namesOffset + names.size);
+
+  objectFree(&directory);
+  objectFree(&names);
+  if (fclose(archive) != 0) {
+    printf("Cannot write to file %s\n", archiveFileName);
+    archive = NULL;
+    return -1;
+  }
+  archive = NULL;
+  return 0;
+}
+
+/*
+  Accepts the name of an archive and a struct to fill.
+  Maps the archive to memory read only, validates the header, the directory and that every payload lies inside the file.
+  Prints a message and returns -1 if the archive cannot be mapped or is not valid, returns 0 on success.
+*/
+int archiveMap(char *fileName, archiveFile *ar) {
+  struct stat st;
+  archiveHeader *header;
+  int fd = open(fileName, O_RDONLY);
+  unsigned long i;
+  void *map;
+
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    printf("Cannot open file %s\n", fileName);
+    if (fd >= 0) {
+      close(fd);
+    }
+    return -1;
+  }
+  if (st.st_size < sizeof(archiveHeader)) {
+    printf("%s is not an archive\n", fileName);
+    close(fd);
+    return -1;
+  }
+
+  map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    printf("Cannot map file %s\n", fileName);
+    return -1;
+  }
+
+  header = map;
+  ar->header = header;
+  ar->size = st.st_size;
+  ar->members = (archiveMember *) ((char *) map + header->directoryOffset);
+  ar->names = (char *) map + header->namesOffset;
+
+  if (memcmp(header->magic, ARCHIVE_MAGIC, sizeof(header->magic)) != 0 || header->version != ARCHIVE_VERSION ||
+      header->headerSize != sizeof(archiveHeader) || header->fileSize != st.st_size || header->directoryOffset % OBJECT_ALIGN != 0 ||
+      header->directoryOffset > header->namesOffset ||
+      (header->namesOffset - header->directoryOffset) / sizeof(archiveMember) < header->memberCount ||
+      header->namesOffset + header->namesSize != header->fileSize ||
+      (header->namesSize > 0 && ar->names[header->namesSize - 1] != '\0')) {
+    printf("%s is not a valid archive\n", fileName);
+    munmap(map, st.st_size);
+    return -1;
+  }
+
+  for (i = 0; i < header->memberCount; i++) {
+    if (ar->members[i].name >= header->namesSize || ar->members[i].offset < header->headerSize ||
+        ar->members[i].offset > header->directoryOffset || ar->members[i].size > header->directoryOffset - ar->members[i].offset) {
+      printf("%s is not a valid archive\n", fileName);
+      munmap(map, st.st_size);
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+/*
+  Unmaps an archive that was mapped with archiveMap.
+*/
+void archiveUnmap(archiveFile *ar) {
+  munmap(ar->header, ar->size);
+  ar->header = NULL;
+}
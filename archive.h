@@ -0,0 +1,52 @@
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+/*
+  An archive of output files, written instead of a separate file for every output of every compiled file.
+  The payloads of the members are appended one after the other as each file finishes compiling, and the member
+  directory is written after the last payload when the archive is closed.
+
+  Layout, all fields little endian:
+  header      an archiveHeader, written again with the final counts when the archive is closed
+  payloads    the bytes of each member, exactly the bytes the individual file would have
+  directory   an archiveMember for each member in the order they were added, aligned to 4
+  names       the null terminated names of the members
+*/
+
+#define ARCHIVE_MAGIC "ASAR" /* The first 4 bytes of every archive */
+#define ARCHIVE_VERSION 1
+
+typedef struct archiveHeader {
+  char magic[4];
+  unsigned short version,
+  headerSize; /* The size of this struct, the first payload starts after it */
+  unsigned int memberCount,
+  directoryOffset,
+  namesOffset,
+  namesSize, /* The size of the names section in bytes */
+  fileSize; /* 0 until the archive is closed */
+} archiveHeader;
+
+typedef struct archiveMember {
+  unsigned int name, /* The offset of the name in the names section */
+  offset, /* The offset of the payload from the start of the archive */
+  size;
+} archiveMember;
+
+typedef struct archiveFile { /* An archive that was mapped to memory */
+  archiveHeader *header;
+  archiveMember *members;
+  char *names;
+  unsigned long size;
+} archiveFile;
+
+#define archivePayload(ar, member) ((char *) (ar)->header + (member)->offset) /* Returns the bytes of a member of a mapped archive */
+#define archiveName(ar, member) ((ar)->names + (member)->name) /* Returns the name of a member of a mapped archive */
+
+int archiveOpen(char *fileName); /* Creates the archive the outputs are written to, returns 0 on success */
+void archiveAdd(char *name, char *data, unsigned long size); /* Appends a member to the archive */
+int archiveClose(void); /* Writes the directory and closes the archive, returns 0 on success */
+int archiveMap(char *fileName, archiveFile *ar); /* Maps a closed archive to memory and validates it, returns 0 on success */
+void archiveUnmap(archiveFile *ar); /* Unmaps an archive that was mapped with archiveMap */
+
+#endif
@@ -15,148 +15,99 @@
 
   To create the program please use 'make' in the CLI at the correct working directory where a makefile is present.
   USAGE: 
-  eg: assembler FILENAME1 FILENAME2
+  eg: assembler [OPTIONS] FILENAME1 FILENAME2
+
+  OPTIONS:
+  --binary  Also writes the machine code to a compact binary object file(.bo), see object.h. The text outputs can be
+            created again from it with 'obconv'
+  --index FILE  Appends the labels of each file and its uses of externals to a shared symbol index, see symindex.h.
+            Parallel runs may append to the same index, it is queried with 'symidx'
+  --archive FILE  Writes the outputs of all the files to a single archive instead of separate files, see archive.h.
+            Its members are listed and extracted with 'obar'
+  --shm PREFIX  Writes the binary object of each file to a read only POSIX shared memory object, see shared.h
+  --memfd FD  Sends the binary object of each file in a sealed memfd over the inherited UNIX socket FD, see shared.h.
+            'obpipe' runs the assembler this way
+  --optimize  Removes the instructions that can't be reached and retargets the jumps to jumps with the control flow
+            analysis(see cfg.h), then removes and rewrites instructions that don't change what the program does with
+            the peephole optimizer, see peephole.h. Prints the amount of words saved for each file
+  --no-fold  Keeps array operands with a constant index(LABEL[2], LABEL[SIZE]) in the index address mode. By default
+            they are encoded as a single direct operand word that holds the address of the element, see peephole.h
+  --no-cfg  With --optimize, keeps the instructions that can't be reached and the jumps to jumps. Otherwise the control
+            flow analysis removes them and retargets the jumps, see cfg.h. A report is printed for every file it changed
+  --dead-data  Removes the .data and .string blocks whose label no instruction and no entry uses, see deadData.h.
+            Prints the removed labels and their words for each file
+  --pool-strings  Lays out a .string that is a suffix of another one(or equal to it) only once, inside the longer one,
+            see stringPool.h. Prints the amount of words saved for each file
+  --size-report  Writes the words and the estimated cycles of each label and of each basic block, ranked, and how much
+            of the memory the file takes to NAME.size and to NAME.size.json, see sizeReport.h
+  --watch DIR  Compiles the sources of DIR(NAME.as) and compiles each of them again whenever it changes, until it is
+            interrupted, see watch.h. No files are given with it, the outputs are only written when they change
+  --preload SNAPSHOT  Adds the macros and the externals of a definition source that was precompiled with 'obsnap' to
+            every file before it is scanned, see snapshot.h. Fails if the source changed after the snapshot was created
 
   NOTE: The assembly files to be compiled must be supplied without the '.as' file extension
 */
 #include <stdio.h>
 #include <stdlib.h>
 #include "./files.h"
-#include "./utils.h"
-#include "./data.h"
-#include "./scan.h"
-#include "./strings.h"
-#include "./output.h"
 #include "./status.h"
-
-/* Initialization of global variables for the project, in data.h they are initialized as extern for usage in other files of the project */
-int DC;
-int IC;
-int error;
-int scanCount;
-symbolNodePtr symbolHead;
-dataNodePtr dataHead;
-
-/* 
-  Prototypes for functions that are available only for this file.
-*/
-void updateSymbolIndex(void);
-void writeData(void);
-int compileFile(char *fileName);
+#include "./profile.h"
+#include "./options.h"
+#include "./archive.h"
+#include "./compile.h"
+#include "./watch.h"
+#include "./snapshot.h"
 
 /*
   The compiler begins execution here.
-  This function loops through the command line arguments other than the program name and for
-  each argument triggers the compile function supplying it the name of the file.
+  This function parses the options from the command line arguments, and loops through the rest of the arguments other than
+  the program name and for each argument triggers the compile function supplying it the name of the file.
 */
 int main(int argc, char *argv[]) {
-  if (argc < MIN_ARGUMENTS) { /* When 0 files are been supplied it prints an instructional message to the user */
-    printf("Please insert files to compile\n");
-  } else {
-    while (argc >= MIN_ARGUMENTS) {
-      argc--;
-      compileFile(argv[argc]);
-    }
-  }
-
-  return OK_STATUS;
-}
+  char **files = malloc(sizeof(char *) * argc); /* The arguments that are not options */
+  int count;
 
-/*
-  Triggers the entire compilation flow for a given file name.
-  Initializes the global variables.
-  Frees memory of symbols and data from previous files compilation.
-  Triggers a function to open the given file name.
-  Triggers the scan functions on that file.
-  Prints messages to notify the user wether the file completed compilation.
-  If scans completed successfully deletes old files.
-  Returns a status wether file compiled successfully.
-*/
-int compileFile(char *fileName) {
-  char *fileExt = addExtension(fileName, ASSEMBLY_EXT); /* The file name given doesn't include the '.as' extension. We create it here. */
-  FILE *fp;
-
-  /* Frees the symbol and data tables */
-  symbolNodeFree(symbolHead);
-  dataNodeFree(dataHead);
-
-  /* Init of global variables */
-  DC = DATA_BASE;
-  IC = MEMORY_BASE;
-  error = OK;
-  scanCount = OK;
-  symbolHead = NULL;
-  dataHead = NULL;
-
-  setCurrentWorkingFile(fileName); /* Initializes variables in files.c, closes previous opened files */
-  fp = openFile(fileExt, "r");     /* Opens the '.as' file to be compiled */
-  free(fileExt);
-
-  if (fp == NULL) { /* Returns if file was not found or couldn't be opened */
+  if (files == NULL) {
+    printf("Cannot allocate memory\n");
     return BAD_STATUS;
   }
 
-  scanCount = FIRST;
-  scan(fp, scanFirst); /* Triggers first scan */
-
-  if (error != OK) { /* If first scan had an error it returns */
-    printf("An error has been found on the first scan, failed to compile %s\n", fileName);
+  if ((count = parseOptions(argc, argv, files)) < 0) {
+    free(files);
     return BAD_STATUS;
   }
 
-  updateSymbolIndex(); /* Increments each guidance symbol in the symbol table with the instruction count */
-  initOutputVars(); /* Initializes variables that will store the words to be compiled until the second scan will be finished */
-
-  IC = MEMORY_BASE;
-
-  scanCount = SECOND;
-  scan(fp, scanSecond); /* Triggers second scan */
-
-  fclose(fp); /* Closes the source code file */
-
-  if (error != OK) { /* If an error has occoured on the second scan notifies the user */
-    freeOutputVars(); /* Frees the variables that stoered the output */
-    printf("\nAn error has been found on second scan, failed to compile %s\n", fileName);
+  if (hasOption(WATCH_OPTION) && (count > 0 || hasOption(ARCHIVE_OPTION | MEMFD_OPTION))) { /* Before the archive is created */
+    printf("--watch compiles the sources of its directory, it can't be given files, --archive or --memfd\n");
+    free(files);
     return BAD_STATUS;
-  } else {
-    deleteFiles(); /* Delete files from previous compilations */
-    createOutput();   /* Creates the compiled files */
-    writeData();      /* Write the data from the data table to the object file */
-    freeOutputVars(); /* Frees the variables that stoered the output */
-    printf("\n%s Compiled successfully\n", fileName);
   }
 
-  return OK_STATUS;
-}
+  if ((hasOption(PRELOAD_OPTION) && snapshotLoad(preloadPath) != 0) ||
+      (hasOption(ARCHIVE_OPTION) && archiveOpen(archivePath) != 0)) {
+    free(files);
+    return BAD_STATUS;
+  }
 
-/*
-  Should be called after the first scan once the instruction count is known.
-  Loops thorugh all of the symbol table and for each symbol that is of type guidance increments it
-  with the value of the instruction count.
-  This is because in the result machine code the data is located after the instructions.
-*/
-void updateSymbolIndex() {
-  symbolNodePtr cur = symbolHead;
+  if (hasOption(WATCH_OPTION)) {
+    free(files);
+    return watchDirectory(watchDir) == 0 ? OK_STATUS : BAD_STATUS;
+  }
 
-  while (cur) {
-    if (cur->type == GUIDANCE) {
-      cur->val = cur->val + IC;
+  if (count < MIN_ARGUMENTS - 1) { /* When 0 files are been supplied it prints an instructional message to the user */
+    printf("Please insert files to compile\n");
+  } else {
+    while (count > 0) {
+      count--;
+      compileFile(files[count]);
     }
-    cur = cur->next;
   }
-}
 
-/*
-  After all of the instructions in the program has been written to the object file the data variables of the assembly program
-  also needs to be translated into machine code.
-  Loops thorugh the data table and for each node in the table creates a line in the object file with the value of the node.
-*/
-void writeData() {
-  dataNodePtr cur = dataHead;
-
-  while (cur != NULL) {
-    writeObject(cur->val); /* Writes to the object file a line with the encoded value of 'val' */
-    IC++; /* The IC is used in the object file to write the correct corresponding line for each word. Even though this is data it still needs to be incremented */
-    cur = cur->next;
+  free(files);
+  if (hasOption(ARCHIVE_OPTION) && archiveClose() != 0) { /* Writes the directory of the archive after the outputs of all the files */
+    return BAD_STATUS;
   }
+  profileWrite(); /* When compiled with PROFILE writes the trace of all the compiled files */
+
+  return OK_STATUS;
 }
@@ -0,0 +1,284 @@
+/*
+  End-to-end benchmark driver.
+  For each scale it generates a corpus with corpusgen(once, the corpus is kept for the next runs), assembles
+  all of its files with the assembler and records the time, throughput and peak memory usage.
+  The results are written as JSON lines to a results file, and optionally compared with a stored baseline.
+
+  USAGE:
+  benchrun [-o results] [-b baseline] [-t threshold] [-r runs] SCALE...
+  A scale is written as FILESxLINES, eg: 100x1000 is 100 files of 1000 lines each.
+  The threshold is the percentage a scale may be slower or bigger than the baseline before it is flagged as a regression.
+  Returns 1 if a regression was found.
+*/
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE /* Required for wait4 */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#define CORPUS_DIR "bench_corpus" /* The directory the corpora are generated into */
+#define ASSEMBLER "./assembler"
+#define CORPUSGEN "./corpusgen"
+#define BATCH 512 /* The maximum amount of files passed to a single run of the assembler */
+#define MAX_PATH 256
+#define MAX_RESULTS 64 /* The maximum amount of scales in a single run or baseline */
+#define MAX_SCALE 64 /* The maximum length of a scale name */
+
+typedef struct result { /* The measurements of a single scale */
+  char name[MAX_SCALE];
+  long files, lines;
+  double seconds;
+  long peakRss; /* In kilobytes */
+} result;
+
+/*
+  Returns the current time in seconds.
+*/
+static double now() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+  Runs the given program with the given arguments, its output is discarded.
+  Returns the peak resident set size of the program in kilobytes, or -1 if it could not run.
+*/
+static long run(char **argv) {
+  struct rusage usage;
+  int status;
+  pid_t pid = fork();
+
+  if (pid < 0) {
+    return -1;
+  }
+  if (pid == 0) {
+    int devNull = open("/dev/null", O_WRONLY);
+
+    dup2(devNull, STDOUT_FILENO);
+    execv(argv[0], argv);
+    _exit(127);
+  }
+
+  if (wait4(pid, &status, 0, &usage) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) == 127) {
+    return -1;
+  }
+
+  return usage.ru_maxrss;
+}
+
+/*
+  Generates the corpus of the given scale unless it was already generated.
+*/
+static int generate(char *dir, long files, long lines) {
+  char prefix[MAX_PATH], last[MAX_PATH + 32], filesArg[32], linesArg[32];
+  char *argv[8];
+  struct stat st;
+
+  sprintf(prefix, "%s/gen", dir);
+  sprintf(last, "%s%ld.as", prefix, files - 1);
+  if (stat(last, &st) == 0) { /* The last file exists so the whole corpus was generated */
+    return 0;
+  }
+
+  mkdir(CORPUS_DIR, 0755);
+  mkdir(dir, 0755);
+
+  sprintf(filesArg, "%ld", files);
+  sprintf(linesArg, "%ld", lines);
+  argv[0] = CORPUSGEN;
+  argv[1] = "-f";
+  argv[2] = filesArg;
+  argv[3] = "-l";
+  argv[4] = linesArg;
+  argv[5] = prefix;
+  argv[6] = NULL;
+
+  return run(argv) < 0 ? -1 : 0;
+}
+
+/*
+  Assembles every file of the corpus in batches and fills the time and memory of the result.
+*/
+static int assemble(char *dir, result *res) {
+  char **argv = malloc(sizeof(char *) * (BATCH + 2));
+  char *names = malloc(MAX_PATH * BATCH);
+  long i, j, rss;
+  double start;
+
+  if (argv == NULL || names == NULL) {
+    printf("Cannot allocate memory\n");
+    exit(1);
+  }
+
+  res->peakRss = 0;
+  start = now();
+
+  for (i = 0; i < res->files; i += BATCH) {
+    argv[0] = ASSEMBLER;
+    for (j = 0; j < BATCH && i + j < res->files; j++) {
+      argv[j + 1] = names + j * MAX_PATH;
+      sprintf(argv[j + 1], "%s/gen%ld", dir, i + j);
+    }
+    argv[j + 1] = NULL;
+
+    if ((rss = run(argv)) < 0) {
+      free(argv);
+      free(names);
+      return -1;
+    }
+    if (rss > res->peakRss) {
+      res->peakRss = rss;
+    }
+  }
+
+  res->seconds = now() - start;
+  free(argv);
+  free(names);
+  return 0;
+}
+
+/*
+  Reads the results of a previous run from the given file.
+  Returns the amount of results read.
+*/
+static int readResults(char *fileName, result *results) {
+  FILE *fp = fopen(fileName, "r");
+  char buf[1024];
+  int count = 0;
+
+  if (fp == NULL) {
+    return 0;
+  }
+
+  while (count < MAX_RESULTS && fgets(buf, sizeof(buf), fp) != NULL) {
+    result *res = &results[count];
+
+    if (sscanf(buf, "{\"name\":\"%63[^\"]\",\"files\":%ld,\"lines\":%ld,\"seconds\":%lf,%*[^,],\"peakRssKb\":%ld",
+               res->name, &res->files, &res->lines, &res->seconds, &res->peakRss) == 5) {
+      count++;
+    }
+  }
+
+  fclose(fp);
+  return count;
+}
+
+/*
+  Compares a result with the baseline result of the same scale.
+  Returns 1 if the result is a regression.
+*/
+static int compare(result *res, result *baseline, int count, double threshold) {
+  int i, regression = 0;
+
+  for (i = 0; i < count; i++) {
+    if (strcmp(res->name, baseline[i].name) == 0) {
+      double timeDiff = (res->seconds / baseline[i].seconds - 1) * 100,
+      rssDiff = ((double) res->peakRss / baseline[i].peakRss - 1) * 100;
+
+      if (timeDiff > threshold || rssDiff > threshold) {
+        regression = 1;
+      }
+      printf("  %-12s time %+.1f%%, peak RSS %+.1f%%%s\n", res->name, timeDiff, rssDiff, regression ? "  REGRESSION" : "");
+      return regression;
+    }
+  }
+
+  printf("  %-12s no baseline\n", res->name);
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  char *resultsFile = "bench_results.json", *baselineFile = NULL, dir[MAX_PATH];
+  double threshold = 10;
+  int runs = 3, i, r, count = 0, baseCount = 0, regressions = 0;
+  result results[MAX_RESULTS], baseline[MAX_RESULTS];
+  FILE *out;
+
+  for (i = 1; i < argc - 1 && argv[i][0] == '-'; i += 2) {
+    switch (argv[i][1]) {
+      case 'o': resultsFile = argv[i + 1]; break;
+      case 'b': baselineFile = argv[i + 1]; break;
+      case 't': threshold = atof(argv[i + 1]); break;
+      case 'r': runs = atoi(argv[i + 1]); break;
+      default:
+        printf("Unknown option %s\n", argv[i]);
+        return 1;
+    }
+  }
+
+  if (i == argc) {
+    printf("USAGE: benchrun [-o results] [-b baseline] [-t threshold] [-r runs] SCALE...\n");
+    return 1;
+  }
+
+  for (; i < argc && count < MAX_RESULTS; i++, count++) {
+    result *res = &results[count];
+
+    if (sscanf(argv[i], "%ldx%ld", &res->files, &res->lines) != 2 || res->files <= 0 || res->lines <= 0) {
+      printf("Invalid scale %s, expected FILESxLINES\n", argv[i]);
+      return 1;
+    }
+    sprintf(res->name, "%ldx%ld", res->files, res->lines);
+    sprintf(dir, "%s/%s", CORPUS_DIR, res->name);
+
+    if (generate(dir, res->files, res->lines) != 0) {
+      printf("Cannot generate the corpus %s\n", dir);
+      return 1;
+    }
+
+    for (r = 0; r < runs; r++) { /* Keeps the fastest run, the slower ones are noise from the rest of the machine */
+      result cur = *res;
+
+      if (assemble(dir, &cur) != 0) {
+        printf("Cannot run %s\n", ASSEMBLER);
+        return 1;
+      }
+      if (r == 0 || cur.seconds < res->seconds) {
+        res->seconds = cur.seconds;
+      }
+      if (r == 0 || cur.peakRss < res->peakRss) {
+        res->peakRss = cur.peakRss;
+      }
+    }
+
+    printf("%-12s %10.3fs %14.0f lines/s %8ld KB\n", res->name, res->seconds,
+           res->files * res->lines / res->seconds, res->peakRss);
+  }
+
+  if ((out = fopen(resultsFile, "w")) == NULL) {
+    printf("Cannot open file %s\n", resultsFile);
+    return 1;
+  }
+  for (i = 0; i < count; i++) {
+    fprintf(out, "{\"name\":\"%s\",\"files\":%ld,\"lines\":%ld,\"seconds\":%.6f,\"linesPerSecond\":%.0f,\"peakRssKb\":%ld}\n",
+            results[i].name, results[i].files, results[i].lines, results[i].seconds,
+            results[i].files * results[i].lines / results[i].seconds, results[i].peakRss);
+  }
+  fclose(out);
+
+  if (baselineFile != NULL) {
+    baseCount = readResults(baselineFile, baseline);
+
+    if (baseCount == 0) {
+      printf("No baseline found in %s, run 'make bench-baseline' to store one\n", baselineFile);
+    } else {
+      printf("Compared with %s (threshold %.0f%%):\n", baselineFile, threshold);
+      for (i = 0; i < count; i++) {
+        regressions += compare(&results[i], baseline, baseCount, threshold);
+      }
+    }
+  }
+
+  return regressions ? 1 : 0;
+}
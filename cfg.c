@@ -0,0 +1,244 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "./cfg.h"
+#include "./command.h"
+#include "./commandUtils.h"
+#include "./data.h"
+#include "./strings.h"
+#include "./files.h"
+
+/*
+  This file holds the control flow analysis, see cfg.h.
+  The analysis works on the lines recorded by peephole.c, a removed block has the words of its lines set to 0 and a
+  threaded jump is a rewritten line, so the second scan encodes them the way it encodes the optimizer's changes.
+*/
+
+typedef struct cfgBlock { /* A basic block, a run of lines that is always executed from its first line to its last */
+  int first, last, /* The indexes of the first and the last line of the block */
+  successors[2], /* The blocks that may run after the block */
+  successorCount,
+  reachable;
+} cfgBlock;
+
+static peepholeLine *lines; /* The lines of the current file, set by cfgOptimize */
+static int lineCount;
+
+/*
+  Accepts a line and a flag(enum COMMAND_FLAG).
+  Returns wether the command of the line has the flag.
+*/
+static int hasFlag(peepholeLine *cur, int flag) {
+  commandPtr comm = getCommand(cur->command);
+
+  return comm != NULL && (comm->flags & flag) != 0;
+}
+
+/*
+  Checks wether a line is a jump with an operand: jmp, bne and jsr.
+*/
+static int isJump(peepholeLine *cur) {
+  return hasFlag(cur, BRANCH);
+}
+
+/*
+  Checks wether a line ends a basic block, a jump, rts or stop.
+*/
+static int endsBlock(peepholeLine *cur) {
+  return hasFlag(cur, ENDS_BLOCK);
+}
+
+/*
+  Checks wether the next line runs after a line, which is false for jmp, rts and stop.
+*/
+static int fallsThrough(peepholeLine *cur) {
+  return !hasFlag(cur, NO_FALLTHROUGH);
+}
+
+/*
+  Accepts an operand and returns the index of the line at its address when it is a label of an instruction of the
+  file, otherwise returns -1.
+*/
+static int targetLine(char *arg) {
+  symbolNodePtr node;
+  int low = 0, high = lineCount;
+
+  if (getArgType(arg) != LABEL || (node = peepholeSymbol(arg)) == NULL || node->type != COMMAND) {
+    return -1;
+  }
+
+  while (low < high) { /* The lines are in the order of their addresses */
+    int mid = (low + high) / 2;
+
+    if (lines[mid].address < node->val) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low < lineCount && lines[low].address == node->val ? low : -1;
+}
+
+/*
+  Checks wether the address of an instruction is used as data, by an operand that is not the target of a jump.
+*/
+static int codeUsedAsData() {
+  int i, k;
+
+  for (i = 0; i < lineCount; i++) {
+    for (k = 0; k < lines[i].argCount; k++) {
+      symbolNodePtr node = peepholeSymbol(lines[i].args[k]);
+
+      if (node != NULL && node->type == COMMAND && !(isJump(&lines[i]) && getArgType(lines[i].args[k]) == LABEL)) {
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+/*
+  Checks wether a jump has a computed target: a register, or an immediate value or a macro, which jump to a numeric
+  address.
+*/
+static int jumpsToAddress() {
+  int i, type;
+
+  for (i = 0; i < lineCount; i++) {
+    if (isJump(&lines[i]) && lines[i].argCount == 1 &&
+        ((type = getArgType(lines[i].args[0])) == REG || type == IVAL || type == MAC)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/*
+  Gives every jump to a jmp LABEL the last label of the chain of jumps instead.
+  Returns the amount of jumps that were threaded.
+*/
+static int threadJumps() {
+  int i, target, steps, threaded = 0;
+
+  for (i = 0; i < lineCount; i++) {
+    char *final = NULL;
+
+    if (!isJump(&lines[i]) || lines[i].argCount != 1) {
+      continue;
+    }
+    target = targetLine(lines[i].args[0]);
+    for (steps = 0; target >= 0 && steps < lineCount && strcmp(lines[target].command, "jmp") == 0 &&
+         targetLine(lines[target].args[0]) >= 0; steps++) { /* A loop of jumps ends after every line was visited */
+      final = lines[target].args[0];
+      target = targetLine(final);
+    }
+
+    if (final != NULL && strcmp(final, lines[i].args[0]) != 0) {
+      free(lines[i].args[0]);
+      lines[i].args[0] = copyString(final);
+      lines[i].rewritten = 1;
+      threaded++;
+    }
+  }
+  return threaded;
+}
+
+/*
+  Accepts the labels given to .entry and their amount, and pointers to the counters of the report.
+  Builds the basic blocks and removes the ones that can't be reached from the first instruction or from an entry.
+  Returns the amount of words saved.
+*/
+static int removeUnreachable(char *entries[], int entryCount, int *removed, int *branches) {
+  cfgBlock *blocks;
+  int *blockOf, *stack, blockCount = 0, stackSize = 0, saved = 0, i, j;
+
+  if ((blocks = malloc(sizeof(cfgBlock) * lineCount)) == NULL || (blockOf = malloc(sizeof(int) * lineCount)) == NULL ||
+      (stack = malloc(sizeof(int) * lineCount)) == NULL) {
+    printf("Cannot allocate memory\n");
+    exit(0);
+  }
+
+  for (i = 0; i < lineCount; i++) { /* Splits the lines into blocks */
+    if (i == 0 || lines[i].label != NULL || endsBlock(&lines[i - 1])) {
+      blocks[blockCount].first = i;
+      blocks[blockCount].successorCount = blocks[blockCount].reachable = 0;
+      blockCount++;
+    }
+    blocks[blockCount - 1].last = i;
+    blockOf[i] = blockCount - 1;
+  }
+
+  for (i = 0; i < blockCount; i++) { /* Connects each block to the blocks that may run after it */
+    peepholeLine *last = &lines[blocks[i].last];
+    int target = isJump(last) && last->argCount == 1 ? targetLine(last->args[0]) : -1;
+
+    if (target >= 0) {
+      blocks[i].successors[blocks[i].successorCount++] = blockOf[target];
+    }
+    if (fallsThrough(last) && i + 1 < blockCount) {
+      blocks[i].successors[blocks[i].successorCount++] = i + 1;
+    }
+  }
+
+  blocks[0].reachable = 1; /* The roots, the first instruction and the entries */
+  stack[stackSize++] = 0;
+  for (i = 0; i < lineCount; i++) {
+    for (j = 0; lines[i].label != NULL && j < entryCount; j++) {
+      if (strcmp(lines[i].label, entries[j]) == 0 && !blocks[blockOf[i]].reachable) {
+        blocks[blockOf[i]].reachable = 1;
+        stack[stackSize++] = blockOf[i];
+      }
+    }
+  }
+  while (stackSize > 0) { /* Every block is pushed once, when it is first reached */
+    cfgBlock *cur = &blocks[stack[--stackSize]];
+
+    for (j = 0; j < cur->successorCount; j++) {
+      if (!blocks[cur->successors[j]].reachable) {
+        blocks[cur->successors[j]].reachable = 1;
+        stack[stackSize++] = cur->successors[j];
+      }
+    }
+  }
+
+  for (i = 0; i < blockCount; i++) {
+    for (j = blocks[i].first; !blocks[i].reachable && j <= blocks[i].last; j++) {
+      saved += lines[j].words;
+      (*removed)++;
+      *branches += endsBlock(&lines[j]);
+      lines[j].words = 0;
+    }
+  }
+
+  free(blocks);
+  free(blockOf);
+  free(stack);
+  return saved;
+}
+
+/*
+  Accepts the recorded lines of a file, the labels given to .entry and the amount of each.
+  Threads the jumps and removes the blocks that can't be reached. Prints a report when anything changed.
+  Returns the amount of words saved.
+*/
+int cfgOptimize(peepholeLine fileLines[], int fileLineCount, char *entries[], int entryCount) {
+  int threaded, saved = 0, removed = 0, branches = 0;
+
+  lines = fileLines;
+  lineCount = fileLineCount;
+  if (lineCount == 0 || codeUsedAsData()) {
+    return 0;
+  }
+
+  threaded = threadJumps();
+  if (!jumpsToAddress()) { /* A register or a number may be the address of any block, removing words moves them */
+    saved = removeUnreachable(entries, entryCount, &removed, &branches);
+  }
+
+  if (removed > 0 || threaded > 0) {
+    printf("\n%s: the control flow analysis removed %d unreachable instruction%s (%d word%s, %d branch%s) and threaded %d jump%s\n",
+           fileName, removed, removed == 1 ? "" : "s", saved, saved == 1 ? "" : "s", branches, branches == 1 ? "" : "es",
+           threaded, threaded == 1 ? "" : "s");
+  }
+  return saved;
+}
@@ -0,0 +1,24 @@
+#ifndef CFG_H
+#define CFG_H
+
+#include "./peephole.h" /* Included here so I can use peepholeLine in the prototype */
+
+/*
+  The control flow analysis, a stage of peephole.h that runs after the first scan with --optimize, unless --no-cfg is
+  given.
+  The recorded instructions are split into basic blocks: a block starts at the first instruction, at an instruction
+  with a label and after jmp, bne, jsr, rts and stop, which are the only instructions that change where the program
+  continues. Each block leads to the target of its last instruction when that is a label of the file, and to the next
+  block unless it ends with jmp, rts or stop. jsr leads to the next block too, that is where its rts returns.
+
+  Jumps to a jmp are threaded first: jmp, bne and jsr to an instruction that is jmp LABEL are given LABEL instead,
+  following a chain of jumps to its last one. After that the blocks that can't be reached from the first instruction
+  or from an entry(the only labels another file can reach) are removed.
+  A file that uses the address of an instruction as data(an operand other than the target of a jump, which may
+  read, write or index the instructions) is left as it is, and one that jumps to a register, an immediate value or
+  a macro keeps its blocks since the target may be any address, and removing a block moves the instructions after it.
+*/
+
+int cfgOptimize(peepholeLine lines[], int lineCount, char *entries[], int entryCount); /* Threads jumps and removes the unreachable blocks of the recorded lines, returns the amount of words saved */
+
+#endif
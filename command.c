@@ -10,6 +10,8 @@
 #include "./status.h"
 #include "./output.h"
 #include "./strings.h"
+#include "./profile.h"
+#include "./peephole.h"
 
 /*
   This file holds logic regarding assembly code lines that are instructions and the way to treat them.
@@ -22,7 +24,7 @@
 */
 void argToBinary(char *arg, enum ARG_TYPE type, int *bin, int isSrc, int curW);
 void updateCommandAddress(int *bin, enum ARG_TYPE type, int isSrc);
-void handleArgument(char *arg, enum ARG_TYPE type, int words[], int *curW, int isSrc);
+void handleArgument(char *arg, enum ARG_TYPE type, int words[], int *curW, int isSrc, int folded);
 
 /*
   Each line of source code that is of type command/instruction that is in the first scan is treated with this function.
@@ -47,7 +49,9 @@ int handleFirstCommand(char *line, char *commandName, char *label) {
 
   if (comm != NULL) { /* Checks if the command was found */
     int args = countArgs(line); /* Finds the amount of arguments passed in the source code */
-    
+
+    profileOpcode(comm->opcode, comm->name); /* Counts the instruction for the per-opcode histogram */
+
     if (args < 0) { /* A value less than 0 for args means there was a syntax error */
       return args;
     }
@@ -108,11 +112,22 @@ void updateCommandAddress(int *bin, enum ARG_TYPE type, int isSrc) {
 void argToBinary(char *arg, enum ARG_TYPE type, int *bin, int isSrc, int curW) {
   switch(type) { /* Switches of the type and handles it accordingly */
     case IVAL:
-      if (*arg == '#') { /* An immediate value as an argument starts with #, we point arg forward to later use atoi */
-        arg++;
+      {
+        int val = 0;
+        char *end;
+
+        if (*arg == '#') { /* An immediate value as an argument starts with #, we point arg forward to parse the number */
+          arg++;
+        }
+
+        if (parseNumber(arg, IMMEDIATE_MIN, IMMEDIATE_MAX, &val, &end) != OK_STATUS || *end != '\0') { /* The value was validated on the first scan */
+          printe("Immediate value %s must be a whole number between %d and %d", 0, arg, IMMEDIATE_MIN, IMMEDIATE_MAX);
+          break;
+        }
+
+        *bin += (val << ADDRESS_DIST) + ABS; /* Update the correct bits in the word and set the encoding type(absolute) */
+        break;
       }
-      *bin += (atoi(arg) << ADDRESS_DIST) + ABS; /* Update the correct bits in the word and set the encoding type(absolute) */
-      break;
     case MAC:
       {
         symbolNodePtr node;
@@ -132,8 +147,14 @@ void argToBinary(char *arg, enum ARG_TYPE type, int *bin, int isSrc, int curW) {
         break;
       }
     case REG:
-      *bin += (atoi(arg + 1) << (isSrc ? REG_SOURCE_DIST : REG_DESTINATION_DIST)) + ABS; /* For a register the encoding of its index position in the word vary wether it is a source/destination operand */
-      break;
+      {
+        int reg = 0;
+        char *end;
+
+        parseNumber(arg + 1, 0, REGISTER_AMOUNT - 1, &reg, &end); /* The register index was validated on the first scan */
+        *bin += (reg << (isSrc ? REG_SOURCE_DIST : REG_DESTINATION_DIST)) + ABS; /* For a register the encoding of its index position in the word vary wether it is a source/destination operand */
+        break;
+      }
     case LABEL:
     {
       symbolNodePtr node = symbolNodeByLabel(arg); /* Fetch the label from the symbol table */
@@ -148,6 +169,7 @@ void argToBinary(char *arg, enum ARG_TYPE type, int *bin, int isSrc, int curW) {
         addExternal(node->label, IC + curW); /* Update the external file about the usage of an external in the correct instruction line */
       } else {
         *bin += (node->val << ADDRESS_DIST) + REL; /* In any other case we use val for the bits of the word and set encoding type to relocatable */
+        addRelocation(IC + curW); /* The word holds an address of this file so it changes when the file is loaded at another base */
       }
     }
     break;
@@ -162,15 +184,31 @@ void argToBinary(char *arg, enum ARG_TYPE type, int *bin, int isSrc, int curW) {
   that correspond to the current command.
   Accepts a string of the argument, the type of the arguemnt, the array of the words
   that needs to be written, a pointer to an int that represents the amount of words that
-  needs to be written in result of the entire command, and an int that represent wether
-  the argument is a source operand.
-  In the case of an argument that is an array 2 extra words need to be written.
+  needs to be written in result of the entire command, an int that represent wether
+  the argument is a source operand and an int that indicates wether an array is folded(see peephole.h).
+  In the case of an argument that is an array 2 extra words need to be written, unless it is folded.
 */
-void handleArgument(char *arg, enum ARG_TYPE type, int words[], int *curW, int isSrc) {
+void handleArgument(char *arg, enum ARG_TYPE type, int words[], int *curW, int isSrc, int folded) {
   if (type == ARR) {
     char *index = getIndexFromArr(arg); /* Gets a string of the index of the array */
     enum ARG_TYPE indexType = checkNumeric(index) ? MAC : IVAL; /* Checks wether the index is a number or macro */
 
+    if (folded) { /* A single word with the address of the element, the label is of this file */
+      int indexWord = 0, address;
+
+      argToBinary(index, indexType, &indexWord, isSrc, *curW); /* The index is encoded as an absolute value above the encoding type */
+      address = symbolNodeByLabel(arg)->val + indexWord / (1 << ADDRESS_DIST);
+
+      if (address < 0) {
+        printe("The element %s[%s] is before the start of the memory", 0, arg, index);
+      } else {
+        words[*curW] += (address << ADDRESS_DIST) + REL;
+        addRelocation(IC + *curW); /* Like the label, the address changes when the file is loaded at another base */
+      }
+      (*curW)++;
+      return;
+    }
+
     argToBinary(arg, LABEL, &words[*curW], isSrc, *curW); /* Encodes the label of the array, the result is in words[] */
     (*curW)++;
     argToBinary(index, indexType, &words[*curW], isSrc, *curW); /* Encodes the index */
@@ -205,17 +243,19 @@ int handleSecondCommand(char *line, char *commandName) {
     for (i = 0; i < args; i++) { /* Loop over the arguments */
       char *arg;
       enum ARG_TYPE type;
+      int folded;
 
       arg = getArg(&line);
       type = getArgType(arg);
+      folded = type == ARR && peepholeFolds(arg, comm, isSrc); /* A folded array is encoded as a label */
 
-      updateCommandAddress(&words[COMMAND_WORD_INDEX], type, isSrc || args == 1); /* Updates the word corresponds to the command about the argument type, in the case where there is 1 argument it is always a source operand */
+      updateCommandAddress(&words[COMMAND_WORD_INDEX], folded ? LABEL : type, isSrc || args == 1); /* Updates the word corresponds to the command about the argument type, in the case where there is 1 argument it is always a source operand */
 
       if (isFirstReg && type == REG) { /* In the case where 2 arguments are register they share a word, this handles this edge case */
         curW--;
       }
 
-      handleArgument(arg, type, words, &curW, isSrc); /* Encodes the current argument */
+      handleArgument(arg, type, words, &curW, isSrc, folded); /* Encodes the current argument */
 
       if (type == REG) {
         isFirstReg++;
@@ -1,17 +1,8 @@
 #ifndef COMMAND_H
 #define COMMAND_H
 
-#define MAX_ADDRESS_MODE 4 /* The maximum amount of address mode types */
-#define OPCODE_DIST 6 /* The distance from the right(in bits) of the opcode in the binary encoding of a word */
-#define ADDRESS_DIST 2 /* The distance form the right(in bits) from the binary encoding of the address mode */
+#include "./isa.h" /* Generated from commands.isa: the fields of the words(OPCODE_DIST...), MAX_WORDS, enum ADDRESS_MODE and enum COMMAND_FLAG */
 
-#define DESTINATION_DIST 4 /* The distance from the right(in bits) of the destination operand in a command word */
-#define SOURCE_DIST 2 /* The distance from the right(in bits) of the source operand in a command word  */
-
-#define REG_DESTINATION_DIST 5 /* The distance from the right(in bits) of the register index encoding in the argument word */
-#define REG_SOURCE_DIST 2      /* The distance from the right(in bits) of the register index encoding in the argument word */
-
-#define MAX_WORDS 5 /* The maximum of words that can be written in result of a single source code line */
 #define COMMAND_WORD_INDEX 0 /* The index of the command word in the array of words that correspond to a single source code line */
 
 enum ARG_TYPE /* Types of an argument passed to command line in the source code */
@@ -24,14 +15,6 @@ enum ARG_TYPE /* Types of an argument passed to command line in the source code
   IVAL
 };
 
-enum ADDRESS_MODE /* Types of address mode encoding */
-{
-  IMMED,
-  DIRECT,
-  INDEX,
-  REGISTER_MODE
-};
-
 enum ARE /* Types of encoding of address mode of an argument in its word, the order is important because it determines the value of each of them */
 {
   ABS, /* Absolute */
@@ -45,8 +28,11 @@ typedef struct command { /* A struct that holds data about a command */
   char *name; /* The string representation of a command */
   int opcode, /* The OPCODE of the command, it needs to be encoded in the command word */
       args,   /* Expected amount of arguments to be passed to the command */
-      dest[MAX_ADDRESS_MODE], /* In case a destination operand exists, an array that holds the available address modes(enum ADDRESS_MODE) */
-      src[MAX_ADDRESS_MODE];  /* In case a source operand exists, an array that holds the available address modes(enum ADDRESS_MODE) */
+      dest,   /* The address modes the first(or single) operand accepts, a bit(1 << enum ADDRESS_MODE) for each */
+      src,    /* The address modes the second operand accepts */
+      flags,  /* enum COMMAND_FLAG */
+      compatDest, /* The modes of dest that are accepted only for compatibility(see commands.isa), programs don't use them */
+      compatSrc;  /* The modes of src that are accepted only for compatibility */
 } command;
 
 int handleFirstCommand(char *line, char *command, char *label); /* Searches for syntax errors in a line of command, updates symbol table about labels, updates instruction count */
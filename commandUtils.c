@@ -10,48 +10,10 @@
 
 /*
   This files holds utilities regarding commands and their arguments.
-  Holds an array of all of the different commands and data about them.
+  The array of all of the different commands and the functions that look them up(getCommand, getCommandByOpcode and
+  decodeCommandWord) are generated from commands.isa to isa.c, see isagen.c.
 */
 
-/*
-  An array of all of the avilable commands, their opcode, expected argument count, and address types of their arguemnts.
-*/
-static command commands[] = {
-  { "mov", 0, 2, {DIRECT, INDEX, REGISTER_MODE}, {IMMED, DIRECT, INDEX, REGISTER_MODE} },
-  { "cmp", 1, 2, {IMMED, DIRECT, INDEX, REGISTER_MODE}, {IMMED, DIRECT, INDEX, REGISTER_MODE} },
-  { "add", 2, 2, {DIRECT, INDEX, REGISTER_MODE}, {IMMED, DIRECT, INDEX, REGISTER_MODE} },
-  { "sub", 3, 2, {DIRECT, INDEX, REGISTER_MODE}, {IMMED, DIRECT, INDEX, REGISTER_MODE} },
-  { "not", 4, 1, {DIRECT, INDEX, REGISTER_MODE} },
-  { "clr", 5, 1, {DIRECT, INDEX, REGISTER_MODE} },
-  { "lea", 6, 2, {DIRECT, INDEX, REGISTER_MODE}, {DIRECT, ARR} },
-  { "inc", 7, 1, {DIRECT, INDEX, REGISTER_MODE} },
-  { "dec", 8, 1, {DIRECT, INDEX, REGISTER_MODE} },
-  { "jmp", 9, 1, {DIRECT, REGISTER_MODE} },
-  { "bne", 10, 1, {DIRECT, REGISTER_MODE} },
-  { "red", 11, 1, {DIRECT, INDEX, REGISTER_MODE} },
-  { "prn", 12, 1, {IMMED, DIRECT, INDEX, REGISTER_MODE} },
-  { "jsr", 13, 1, {DIRECT, REGISTER_MODE} },
-  { "rts", 14, 0 },
-  { "stop", 15, 0 }
-};
-
-/*
-  Takes a string of a name of a command and returns a pointer to a struct of that command with data about it
-  from the commands array.
-  If the command is not present in the array returns NULL.
-*/
-commandPtr getCommand(char *commandName) {
-  int i = 0;
-
-  for (i = 0; i < sizeof(commands) / sizeof(command); i++) { /* Loops over the commands structs array */
-    if (strcmp(commandName, commands[i].name) == 0) {
-      return &commands[i];
-    }
-  }
-
-  return NULL;
-}
-
 /*
   Takes a string of an argument as a parameter.
   Returns an int that represents its type(enum ARG_TYPE)
@@ -101,26 +63,8 @@ int argTypeToMode(int type) {
 
 /*
   Takes an int as a parameter that represents a type of an argument(enum ARG_TYPE) and increments the
-  instruction count accordingly, all are incremented by 1 except in the case of an array.
+  instruction count by the amount of words of its address mode(modeWords).
 */
 void incIC(int type) {
-  switch(type) {
-    case IVAL:
-      IC++;
-      break;
-    case MAC:
-      IC++;
-      break;
-    case REG:
-      IC++;
-      break;
-    case ARR:
-      IC += 2;
-      break;
-    case LABEL:
-      IC++;
-      break;
-    default:
-      return;
-  }
+  IC += modeWords[argTypeToMode(type)];
 }
@@ -4,6 +4,8 @@
 struct command; /* States the a struct command exists, it is declared in command.h */
 
 struct command *getCommand(char *commandName); /* Takes a string of a name of a command are returns a pointer to a struct that holds data about the given command */
+struct command *getCommandByOpcode(int opcode); /* Takes an opcode and returns a pointer to the struct of the command with that opcode, or NULL */
+struct command *decodeCommandWord(int word, int modes[], int *length); /* Decodes an instruction word to its command, the address modes of its operands and its amount of words, returns NULL if the word is not valid */
 int getArgType(char *arg); /* Takes an argument as a string and returns an int that represents its type(enum ARG_TYPE) */
 void incIC(int type); /* Takes a type of an argument as a parameter and increments the instruction count */
 int argTypeToMode(int type); /* Takes an int that represents a type of an argument(enum ARG_TYPE) and returns an int that represents an address mode(enum ADDRESS_MODE) */
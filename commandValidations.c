@@ -7,6 +7,7 @@
 #include "./status.h"
 #include "./data.h"
 #include "./utils.h"
+#include "./strings.h"
 
 /*
   Holds the function valArg that is used by handleFirstCommand which is used for every comamnd in the first
@@ -24,6 +25,7 @@ int valMac(char *label);
 int valReg(char *num);
 int valArr(char *label);
 int valIndex(char *index);
+int valImmediate(char *num);
 
 /*
   Takes a string of an argument, the argument type, a pointer to the command that got that argument, and the
@@ -38,7 +40,7 @@ int valArg(char *arg, int type, commandPtr comm, int argIndex) {
   }
   switch (type) {
     case IVAL:
-      return OK_STATUS; /* No validations for immediate values */
+      return valImmediate(arg + 1); /* Immediate values starts with '#', we pass a char * that points to the start of the value */
     case MAC:
       return valMac(arg + 1); /* Macro arguments starts with '#', we pass a char * that points to the start of the value */
     case REG:
@@ -60,21 +62,13 @@ int valArg(char *arg, int type, commandPtr comm, int argIndex) {
   Returns an int that indicates wether the address mode is valid.
 */
 int valAddressMode(int mode, commandPtr comm, int argIndex) {
-  int i, *modes; /* modes will point to an int array that will hold the valid address modes the argument can have */
+  int modes = argIndex == comm->args ? comm->dest : comm->src; /* The valid address modes of the argument, either destination or source */
 
-  if (argIndex == comm->args) { /* Points modes to the correct int array of address modes, either destination or source */
-    modes = comm->dest;
-  } else {
-    modes = comm->src;
-  }
-
-  for (i = 0; i < MAX_ADDRESS_MODE; i++) { /* Loops over the address modes and if a correct one is found returns an ok status */
-    if (mode == *(modes + i)) {
-      return OK_STATUS;
-    }
+  if (modes & (1 << mode)) {
+    return OK_STATUS;
   }
 
-  printe("Invalid address mode", 0); /* If the address mode was not found in the loop then it's of the wrong type */
+  printe("Invalid address mode", 0); /* If the address mode is not one of the valid modes then it's of the wrong type */
   return INVALID_ARGUMENT;
 }
 
@@ -93,6 +87,10 @@ int valMac(char *label) {
       printe("Argument %s is not a macro", 0, label);
       return INVALID_ARGUMENT;
     }
+    if (mac->val < IMMEDIATE_MIN || mac->val > IMMEDIATE_MAX) { /* A macro used as an operand is encoded in the 12 bits of the operand word */
+      printe("Macro %s value %d does not fit in an operand, it must be between %d and %d", 0, label, mac->val, IMMEDIATE_MIN, IMMEDIATE_MAX);
+      return OUT_OF_RANGE;
+    }
     return OK_STATUS;
   }
 }
@@ -102,10 +100,31 @@ int valMac(char *label) {
   Returns an int that represents if it is valid.
 */
 int valReg(char *num) {
-  int val = atoi(num);
+  int val;
+  char *end;
+
+  if (parseNumber(num, 0, REGISTER_AMOUNT - 1, &val, &end) != OK_STATUS || *end != '\0') { /* Checks if index is a number in range */
+    printe("Invalid register index %s, index must be between 0 and %d", 0, num, REGISTER_AMOUNT - 1);
+    return INVALID_ARGUMENT;
+  }
+
+  return OK_STATUS;
+}
+
+/*
+  Takes a string of an immediate value(without the '#') and validates that it fits in the 12 bits of an operand word.
+  Returns an int that represents if it is valid.
+*/
+int valImmediate(char *num) {
+  int val, status;
+  char *end;
 
-  if (val < 0 || val >= REGISTER_AMOUNT) { /* Checks if index is in range */
-    printe("Invalid register index %d, index must be between 0 and %d", 0, val, REGISTER_AMOUNT - 1);
+  if ((status = parseNumber(num, IMMEDIATE_MIN, IMMEDIATE_MAX, &val, &end)) == OUT_OF_RANGE) {
+    printe("Immediate value %s is out of range, it must be between %d and %d", 0, num, IMMEDIATE_MIN, IMMEDIATE_MAX);
+    return OUT_OF_RANGE;
+  }
+  if (status != OK_STATUS || *end != '\0') { /* The whole operand must be the number */
+    printe("Invalid immediate value %s", 0, num);
     return INVALID_ARGUMENT;
   }
 
@@ -165,12 +184,17 @@ int valIndex(char *index) {
     }
   }
 
-  *(index + strlen(index)) = ']';
-
   if (i == 0) { /* If the loop had 0 iterations it means the braces were empty */
+    *(index + strlen(index)) = ']';
     printe("No index inserted", 0);
     return NOT_ENOUGH_ARGS;
   }
 
+  if (valImmediate(index) != OK_STATUS) { /* The index is encoded in its own operand word */
+    *(index + strlen(index)) = ']';
+    return OUT_OF_RANGE;
+  }
+
+  *(index + strlen(index)) = ']';
   return OK_STATUS;
 }
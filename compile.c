@@ -0,0 +1,181 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "./compile.h"
+#include "./files.h"
+#include "./utils.h"
+#include "./data.h"
+#include "./scan.h"
+#include "./strings.h"
+#include "./output.h"
+#include "./status.h"
+#include "./profile.h"
+#include "./peephole.h"
+#include "./include.h"
+#include "./snapshot.h"
+
+/*
+  This file holds the compilation flow of a single file, it is used by the assembler, by the incremental
+  reassembly(see incremental.h) and by the language server(see xref.h).
+*/
+
+static int scanSource(char *fileName, FILE *fp, int first(char *), int second(char *));
+
+/*
+  Triggers the entire compilation flow for a given file name.
+  Triggers a function to open the given file name.
+  Triggers the scans on that file.
+  Returns a status wether file compiled successfully.
+*/
+int compileFile(char *fileName) {
+  char *fileExt = addExtension(fileName, ASSEMBLY_EXT); /* The file name given doesn't include the '.as' extension. We create it here. */
+  FILE *fp = openFile(fileExt, "r"); /* Opens the '.as' file to be compiled */
+  int status;
+
+  free(fileExt);
+
+  if (fp == NULL) { /* Returns if file was not found or couldn't be opened */
+    return BAD_STATUS;
+  }
+
+  status = compileSource(fileName, fp, scanFirst, scanSecond);
+  fclose(fp); /* Closes the source code file */
+  return status;
+}
+
+/*
+  Accepts the name of the file without its extension, the opened source code and the functions that treat each line in
+  the first and the second scan(scanFirst and scanSecond, or functions that call them).
+  Scans the source code and if the scans completed successfully deletes old files and writes the outputs.
+  Prints messages to notify the user wether the file completed compilation.
+  Returns a status wether file compiled successfully.
+*/
+int compileSource(char *fileName, FILE *fp, int first(char *), int second(char *)) {
+  int status;
+
+  profileBegin(fileName);
+  if ((status = scanSource(fileName, fp, first, second)) == OK_STATUS) {
+    writeOutputs();
+  }
+  profileEnd(fileName);
+  profileSnapshot(); /* Records the counters after every file so their growth can be seen in the trace */
+  return status;
+}
+
+/*
+  Accepts the name of the file without its extension, the opened source code and the functions that treat each line in
+  the first and the second scan.
+  Scans the source code like compileSource but doesn't write any output, the symbol and data tables are kept until the
+  next file is scanned. Used by the language server(see xref.h).
+  Returns a status wether file compiled successfully.
+*/
+int checkSource(char *fileName, FILE *fp, int first(char *), int second(char *)) {
+  int status = scanSource(fileName, fp, first, second);
+
+  if (status == OK_STATUS) {
+    freeOutputVars(); /* Frees the words the second scan encoded */
+  }
+  return status;
+}
+
+/*
+  Accepts the name of the file without its extension, the opened source code and the functions that treat each line in
+  the first and the second scan.
+  Initializes the global variables.
+  Frees memory of symbols and data from previous files compilation.
+  Triggers the scan functions on the source code, the words of the second scan are kept in the output variables.
+  Returns a status wether both scans completed successfully.
+*/
+static int scanSource(char *fileName, FILE *fp, int first(char *), int second(char *)) {
+  /* Frees the symbol and data tables */
+  symbolNodeFree(symbolHead);
+  dataNodeFree(dataHead);
+  peepholeFree();
+  includeReset(); /* The files the previous source included can be included again */
+
+  /* Init of global variables */
+  DC = DATA_BASE;
+  IC = MEMORY_BASE;
+  error = OK;
+  scanCount = OK;
+  symbolHead = NULL;
+  dataHead = NULL;
+  snapshotSeed(); /* Adds the symbols of --preload */
+
+  setCurrentWorkingFile(fileName); /* Initializes variables in files.c, closes previous opened files */
+
+  profileBegin("first scan");
+  scanCount = FIRST;
+  scan(fp, first); /* Triggers first scan */
+  profileEnd("first scan");
+
+  if (error != OK) { /* If first scan had an error it returns */
+    printf("An error has been found on the first scan, failed to compile %s\n", fileName);
+    return BAD_STATUS;
+  }
+
+  peepholeOptimize(); /* Folds constant indexes, runs the control flow analysis, applies the rules of --optimize, moves the labels of the instructions back by the words it saved and updates IC */
+
+  updateSymbolIndex(); /* Increments each guidance symbol in the symbol table with the instruction count */
+  initOutputVars(); /* Initializes variables that will store the words to be compiled until the second scan will be finished */
+
+  IC = MEMORY_BASE;
+
+  profileBegin("second scan");
+  scanCount = SECOND;
+  scan(fp, second); /* Triggers second scan */
+  profileEnd("second scan");
+
+  if (error != OK) { /* If an error has occoured on the second scan notifies the user */
+    freeOutputVars(); /* Frees the variables that stoered the output */
+    printf("\nAn error has been found on second scan, failed to compile %s\n", fileName);
+    return BAD_STATUS;
+  }
+  return OK_STATUS;
+}
+
+/*
+  Should be called once the words of the instructions were added to the output(by the second scan).
+  Writes the outputs of the current file and notifies the user.
+*/
+void writeOutputs() {
+  profileBegin("output");
+  deleteFiles(); /* Delete files from previous compilations */
+  createOutput();   /* Creates the compiled files */
+  writeData();      /* Write the data from the data table to the object file */
+  finishFiles();    /* Closes the compiled files, or adds them to the archive */
+  freeOutputVars(); /* Frees the variables that stoered the output */
+  profileEnd("output");
+  printf("\n%s Compiled successfully\n", fileName);
+}
+
+/*
+  Should be called after the first scan once the instruction count is known.
+  Loops thorugh all of the symbol table and for each symbol that is of type guidance increments it
+  with the value of the instruction count.
+  This is because in the result machine code the data is located after the instructions.
+*/
+void updateSymbolIndex() {
+  symbolNodePtr cur = symbolHead;
+
+  while (cur) {
+    if (cur->type == GUIDANCE) {
+      cur->val = cur->val + IC;
+    }
+    cur = cur->next;
+  }
+}
+
+/*
+  After all of the instructions in the program has been written to the object file the data variables of the assembly program
+  also needs to be translated into machine code.
+  Loops thorugh the data table and for each node in the table creates a line in the object file with the value of the node.
+*/
+void writeData() {
+  dataNodePtr cur = dataHead;
+
+  while (cur != NULL) {
+    writeObject(cur->val); /* Writes to the object file a line with the encoded value of 'val' */
+    IC++; /* The IC is used in the object file to write the correct corresponding line for each word. Even though this is data it still needs to be incremented */
+    cur = cur->next;
+  }
+}
@@ -0,0 +1,13 @@
+#ifndef COMPILE_H
+#define COMPILE_H
+
+#include <stdio.h> /* Incldued here so I can use FILE in some functions prototypes */
+
+int compileFile(char *fileName); /* Opens the .as file of the given name and compiles it, returns a status wether it compiled successfully */
+int compileSource(char *fileName, FILE *fp, int first(char *), int second(char *)); /* Compiles an opened source code with the functions of the first and second scan, returns a status wether it compiled successfully */
+int checkSource(char *fileName, FILE *fp, int first(char *), int second(char *)); /* Scans an opened source code like compileSource without writing the outputs, returns a status wether it compiled successfully */
+void writeOutputs(void); /* Writes the outputs of the current file after its second scan */
+void updateSymbolIndex(void); /* Adds the instruction count to the labels of the data */
+void writeData(void); /* Writes the data table to the object file */
+
+#endif
@@ -0,0 +1,317 @@
+/*
+  Synthetic corpus generator.
+  Emits valid assembly programs of a configurable size and shape, used by the benchmarks.
+  All the programs are generated from a seed so the same arguments always produce the same corpus.
+
+  USAGE:
+  corpusgen [options] PREFIX
+  eg: corpusgen -f 10 -l 1000 bench_corpus/gen
+  Creates bench_corpus/gen0.as ... bench_corpus/gen9.as, the directory must exist.
+
+  Options (percentages are of the body lines):
+  -f N  amount of files (default 1)
+  -l N  amount of lines per file (default 1000)
+  -L N  percentage of instructions that have a label (default 20)
+  -m N  amount of .define macros per file (default 8)
+  -d N  percentage of .data lines (default 10)
+  -s N  percentage of .string lines (default 5)
+  -a N  percentage of operands that are array indexed (default 15)
+  -e N  amount of externals per file (default 4)
+  -n N  amount of entries per file (default 4)
+  -S N  seed (default 1)
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "./command.h"
+#include "./commandUtils.h"
+
+#define MAX_NAME 256 /* The maximum length of a generated file name */
+#define DATA_VALUES 6 /* The maximum amount of values in a single .data line */
+#define STRING_CHARS 20 /* The maximum amount of characters in a single .string line */
+#define IMMED_MAX 2047 /* Immediate values must fit in the 12 bits of an operand word */
+#define DATA_MAX 8191 /* Data values must fit in the 14 bits of a word */
+
+enum LINE_KIND /* Types of body lines */
+{
+  INSTRUCTION,
+  DATA,
+  STRING
+};
+
+typedef struct genCommand { /* The commands the generator emits and the operand types they accept */
+  char *name;
+  int args, flags;
+  int src[MAX_ADDRESS_MODE], srcCount; /* Operand types for the first operand of a 2 operand command */
+  int dest[MAX_ADDRESS_MODE], destCount; /* Operand types for the last operand */
+} genCommand;
+
+static genCommand genCommands[COMMAND_COUNT]; /* In the order of their opcodes, see loadCommands */
+static int genCommandCount;
+
+static int files = 1, lines = 1000, labelPct = 20, macros = 8, dataPct = 10, stringPct = 5, arrPct = 15,
+  externs = 4, entries = 4;
+static unsigned long seed = 1;
+
+static int codeLabels, dataLabels; /* The amount of code and data labels of the file that is being generated */
+
+/*
+  A small linear congruential generator, used instead of rand() so the corpus is identical on every platform.
+  Returns a number between 0 and max - 1.
+*/
+static int rnd(int max) {
+  seed = seed * 1103515245UL + 12345UL;
+  seed &= 0xffffffffUL;
+  return max > 0 ? (int) ((seed >> 8) % max) : 0;
+}
+
+/*
+  Accepts an operand mask of a command of the instruction set and the modes of it that are kept for compatibility.
+  Stores the address modes that programs use in types, in the order of their codes, and returns their amount.
+*/
+static int operandTypes(int mask, int compat, int types[]) {
+  int mode, count = 0;
+
+  for (mode = 0; mode < MAX_ADDRESS_MODE; mode++) {
+    if ((mask & ~compat) & (1 << mode)) {
+      types[count++] = mode;
+    }
+  }
+  return count;
+}
+
+/*
+  Fills genCommands from the commands table of the instruction set(see commands.isa) in the order of the opcodes, the
+  operands of a 2 operand command are the src and the dest of the generator.
+*/
+static void loadCommands() {
+  int opcode;
+
+  for (opcode = 0, genCommandCount = 0; opcode < 1 << OPCODE_WIDTH; opcode++) {
+    commandPtr comm = getCommandByOpcode(opcode);
+    genCommand *gen = &genCommands[genCommandCount];
+
+    if (comm == NULL) {
+      continue;
+    }
+    gen->name = comm->name;
+    gen->args = comm->args;
+    gen->flags = comm->flags;
+    gen->srcCount = comm->args == 2 ? operandTypes(comm->dest, comm->compatDest, gen->src) : 0;
+    gen->destCount = comm->args == 2 ? operandTypes(comm->src, comm->compatSrc, gen->dest) :
+                     comm->args == 1 ? operandTypes(comm->dest, comm->compatDest, gen->dest) : 0;
+    genCommandCount++;
+  }
+}
+
+/*
+  Writes an operand of the given type to the file.
+  Labels referenced in operands are always ones that are defined in the same file or declared as externals.
+*/
+static void writeOperand(FILE *fp, int type, int allowExtern) {
+  switch (type) {
+    case IMMED:
+      if (macros > 0 && rnd(4) == 0) {
+        fprintf(fp, "#M%d", rnd(macros));
+      } else {
+        fprintf(fp, "#%d", rnd(IMMED_MAX * 2 + 1) - IMMED_MAX);
+      }
+      break;
+    case DIRECT:
+      if (allowExtern && externs > 0 && rnd(8) == 0) {
+        fprintf(fp, "X%d", rnd(externs));
+      } else if (dataLabels > 0 && rnd(2) == 0) {
+        fprintf(fp, "D%d", rnd(dataLabels));
+      } else {
+        fprintf(fp, "L%d", rnd(codeLabels));
+      }
+      break;
+    case INDEX:
+      if (macros > 0 && rnd(2) == 0) {
+        fprintf(fp, "D%d[M%d]", rnd(dataLabels), rnd(macros));
+      } else {
+        fprintf(fp, "D%d[%d]", rnd(dataLabels), rnd(DATA_VALUES));
+      }
+      break;
+    default:
+      fprintf(fp, "r%d", rnd(8));
+  }
+}
+
+/*
+  Picks an operand type out of the given options, array operands are picked by the array percentage.
+*/
+static int pickOperand(int *options, int count) {
+  int i, type;
+
+  for (i = 0; i < count; i++) {
+    if (options[i] == INDEX && dataLabels > 0 && rnd(100) < arrPct) {
+      return INDEX;
+    }
+  }
+
+  do {
+    type = options[rnd(count)];
+  } while (type == INDEX && dataLabels == 0);
+
+  return type;
+}
+
+/*
+  Writes a single instruction line(without a label).
+*/
+static void writeInstruction(FILE *fp) {
+  genCommand *comm = &genCommands[rnd(genCommandCount - 1)]; /* stop, the last opcode, ends the program */
+  int branch = (comm->flags & BRANCH) != 0;
+
+  fprintf(fp, " %s", comm->name);
+
+  if (comm->args == 2) {
+    putc(' ', fp);
+    writeOperand(fp, pickOperand(comm->src, comm->srcCount), 1);
+    fprintf(fp, ", ");
+  } else if (comm->args == 1) {
+    putc(' ', fp);
+  }
+
+  if (comm->args > 0) {
+    if (branch && codeLabels > 0 && rnd(8) != 0) {
+      fprintf(fp, "L%d", rnd(codeLabels)); /* Branches mostly go to code labels */
+    } else {
+      writeOperand(fp, pickOperand(comm->dest, comm->destCount), 1);
+    }
+  }
+
+  putc('\n', fp);
+}
+
+/*
+  Generates a single file with the given name.
+  The kinds of the body lines are picked first so the amount of labels is known before any of them is referenced.
+*/
+static void generateFile(char *name) {
+  FILE *fp = fopen(name, "w");
+  char *kinds;
+  int *labeled, i, j, body, code = 0, data = 0;
+
+  if (fp == NULL) {
+    printf("Cannot open file %s\n", name);
+    exit(1);
+  }
+
+  body = lines - macros - externs - entries - 1; /* The final line is a stop */
+  if (body < 1) {
+    body = 1;
+  }
+
+  kinds = malloc(body);
+  labeled = malloc(sizeof(int) * body);
+  if (kinds == NULL || labeled == NULL) {
+    printf("Cannot allocate memory\n");
+    exit(1);
+  }
+
+  codeLabels = dataLabels = 0;
+  for (i = 0; i < body; i++) { /* Plans the kind of each line */
+    int r = rnd(100);
+
+    kinds[i] = i == 0 ? INSTRUCTION : r < dataPct ? DATA : r < dataPct + stringPct ? STRING : INSTRUCTION;
+    labeled[i] = kinds[i] != INSTRUCTION || rnd(100) < labelPct || i == 0; /* The first line is always a labeled instruction */
+
+    if (labeled[i]) {
+      if (kinds[i] == INSTRUCTION) {
+        codeLabels++;
+      } else {
+        dataLabels++;
+      }
+    }
+  }
+
+  for (i = 0; i < macros; i++) {
+    fprintf(fp, ".define M%d = %d\n", i, rnd(DATA_VALUES));
+  }
+  for (i = 0; i < externs; i++) {
+    fprintf(fp, ".extern X%d\n", i);
+  }
+  for (i = 0; i < entries && i < codeLabels; i++) {
+    fprintf(fp, ".entry L%d\n", i);
+  }
+
+  for (i = 0; i < body; i++) {
+    if (labeled[i]) {
+      fprintf(fp, "%c%d: ", kinds[i] == INSTRUCTION ? 'L' : 'D', kinds[i] == INSTRUCTION ? code++ : data++);
+    }
+
+    if (kinds[i] == DATA) {
+      int values = rnd(3) + DATA_VALUES; /* Array operands index up to DATA_VALUES - 1, more values would not fit in a line */
+
+      fprintf(fp, ".data ");
+      for (j = 0; j < values; j++) {
+        fprintf(fp, "%s%d", j ? ", " : "", rnd(DATA_MAX * 2 + 1) - DATA_MAX);
+      }
+      putc('\n', fp);
+    } else if (kinds[i] == STRING) {
+      int chars = rnd(STRING_CHARS) + DATA_VALUES;
+
+      fprintf(fp, ".string \"");
+      for (j = 0; j < chars; j++) {
+        putc('a' + rnd(26), fp);
+      }
+      fprintf(fp, "\"\n");
+    } else {
+      writeInstruction(fp);
+    }
+  }
+
+  fprintf(fp, " stop\n");
+
+  free(kinds);
+  free(labeled);
+  fclose(fp);
+}
+
+/*
+  Parses the options, and generates each of the files.
+*/
+int main(int argc, char *argv[]) {
+  int i;
+  char name[MAX_NAME];
+
+  for (i = 1; i < argc - 1 && argv[i][0] == '-'; i += 2) {
+    int val = atoi(argv[i + 1]);
+
+    switch (argv[i][1]) {
+      case 'f': files = val; break;
+      case 'l': lines = val; break;
+      case 'L': labelPct = val; break;
+      case 'm': macros = val; break;
+      case 'd': dataPct = val; break;
+      case 's': stringPct = val; break;
+      case 'a': arrPct = val; break;
+      case 'e': externs = val; break;
+      case 'n': entries = val; break;
+      case 'S': seed = val; break;
+      default:
+        printf("Unknown option %s\n", argv[i]);
+        return 1;
+    }
+  }
+
+  if (i != argc - 1) {
+    printf("USAGE: corpusgen [options] PREFIX\n");
+    return 1;
+  }
+
+  loadCommands();
+
+  for (i = 0; i < files; i++) {
+    if (strlen(argv[argc - 1]) + 16 > MAX_NAME) {
+      printf("Prefix %s is too long\n", argv[argc - 1]);
+      return 1;
+    }
+    sprintf(name, "%s%d.as", argv[argc - 1], i);
+    generateFile(name);
+  }
+
+  return 0;
+}
@@ -0,0 +1,14 @@
+#include <stdio.h>
+#include "./data.h"
+
+/*
+  Initialization of global variables for the project, in data.h they are initialized as extern for usage in other files of the project.
+  They are defined here and not in assembler.c so the benchmarks and tools that reuse the assembler files can link without its main.
+*/
+int DC;
+int IC;
+int error;
+int scanCount;
+symbolNodePtr symbolHead;
+dataNodePtr dataHead;
+dataNodePtr dataTail;
@@ -5,6 +5,11 @@
 #define MEMORY_BASE 100 /* Defines to what base memory address the machine code needs to be loaded to */
 #define DATA_BASE 0 /* Defines in which memory address the data starts */
 
+#define WORD_MIN -8192 /* The smallest value that fits in a 14 bit word */
+#define WORD_MAX 8191 /* The largest value that fits in a 14 bit word */
+#define IMMEDIATE_MIN -2048 /* The smallest value that fits in the 12 bits of an operand word */
+#define IMMEDIATE_MAX 2047 /* The largest value that fits in the 12 bits of an operand word */
+
 enum SYMBOL_TYPE /* Different types of instructions */
 {
   GUIDANCE,
@@ -40,6 +45,7 @@ typedef struct dataNode /* The data table is defined in the code as a linked lis
 } dataNode;
 
 extern dataNodePtr dataHead; /* This will point to the first node of the data table */
+extern dataNodePtr dataTail; /* The last node of the data table, addDataNode adds after it. It is only valid when dataHead is not NULL */
 extern symbolNodePtr symbolHead; /* This will point to the first node of the symbol table */
 extern int DC; /* The data count */
 extern int IC; /* The instruction count */
@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "./deadData.h"
+#include "./data.h"
+#include "./utils.h"
+#include "./files.h"
+
+/*
+  This file holds the dead data elimination, see deadData.h.
+*/
+
+static int *starts, /* The addresses in the data table of the data labels in ascending order, the start of each block */
+*live, /* Wether each block is used */
+*shift, /* The amount of words removed before each block */
+blockCount;
+
+/*
+  Compares 2 ints for qsort.
+*/
+static int compareInts(const void *a, const void *b) {
+  return *(const int *) a - *(const int *) b;
+}
+
+/*
+  Returns the index of the block that holds an address of the data table, -1 for the data before the first block.
+*/
+static int blockAt(int address) {
+  int low = 0, high = blockCount;
+
+  while (low < high) { /* Finds the first block that starts after the address */
+    int mid = (low + high) / 2;
+
+    if (starts[mid] <= address) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low - 1;
+}
+
+/*
+  Accepts an operand of an instruction.
+  When it is a data label or an array of one marks the block of the label and the block of the element as used.
+*/
+static void markOperand(char *arg) {
+  symbolNodePtr node = peepholeSymbol(arg);
+
+  if (node != NULL && node->type == GUIDANCE) {
+    live[blockAt(node->val)] = 1;
+    if (blockAt(node->val + peepholeIndex(arg)) >= 0) {
+      live[blockAt(node->val + peepholeIndex(arg))] = 1;
+    }
+  }
+}
+
+/*
+  Accepts the recorded lines of a file, the labels given to .entry and the amount of each.
+  Removes the data blocks that are not used by an instruction that is still encoded or by an entry, moves the data
+  labels back and updates DC. Prints the removed labels and their sizes.
+  Returns the amount of words removed.
+*/
+int deadDataRemove(peepholeLine lines[], int lineCount, char *entries[], int entryCount) {
+  symbolNodePtr node;
+  dataNodePtr cur, prev = NULL, next;
+  int i, k, removed = 0;
+
+  for (node = symbolHead, blockCount = 0; node != NULL; node = node->next) {
+    blockCount += node->type == GUIDANCE;
+  }
+  if (blockCount == 0) {
+    return 0;
+  }
+  if ((starts = malloc(sizeof(int) * blockCount)) == NULL || (live = calloc(blockCount, sizeof(int))) == NULL ||
+      (shift = malloc(sizeof(int) * blockCount)) == NULL) {
+    printf("Cannot allocate memory\n");
+    exit(0);
+  }
+  for (node = symbolHead, i = 0; node != NULL; node = node->next) {
+    if (node->type == GUIDANCE) {
+      starts[i++] = node->val;
+    }
+  }
+  qsort(starts, blockCount, sizeof(int), compareInts);
+
+  for (i = 0; i < lineCount; i++) {
+    for (k = 0; lines[i].words > 0 && k < lines[i].argCount; k++) {
+      markOperand(lines[i].args[k]);
+    }
+  }
+  for (i = 0; i < entryCount; i++) {
+    if ((node = symbolNodeByLabel(entries[i])) != NULL && node->type == GUIDANCE) {
+      live[blockAt(node->val)] = 1;
+    }
+  }
+
+  for (i = 0; i < blockCount; i++) {
+    shift[i] = removed;
+    removed += live[i] ? 0 : (i + 1 < blockCount ? starts[i + 1] : DC) - starts[i];
+  }
+  if (removed == 0) {
+    free(starts);
+    free(live);
+    free(shift);
+    return 0;
+  }
+
+  for (cur = dataHead; cur != NULL; cur = next) { /* Unlinks the words of the removed blocks */
+    int block = blockAt(cur->index);
+
+    next = cur->next;
+    if (block >= 0 && !live[block]) {
+      if (prev == NULL) {
+        dataHead = next;
+      } else {
+        prev->next = next;
+      }
+      free(cur->label);
+      free(cur);
+    } else {
+      cur->index -= block >= 0 ? shift[block] : 0;
+      prev = cur;
+    }
+  }
+  dataTail = prev;
+
+  printf("\n%s: dead data elimination removed %d words", fileName, removed);
+  for (node = symbolHead; node != NULL; node = node->next) {
+    if (node->type == GUIDANCE) {
+      int block = blockAt(node->val);
+
+      if (!live[block]) {
+        printf(", %s(%d)", node->label, (block + 1 < blockCount ? starts[block + 1] : DC) - starts[block]);
+      }
+      node->val -= shift[block]; /* The label of a removed block moves to the words after it */
+    }
+  }
+  printf("\n");
+  DC -= removed;
+
+  free(starts);
+  free(live);
+  free(shift);
+  return removed;
+}
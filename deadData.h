@@ -0,0 +1,18 @@
+#ifndef DEAD_DATA_H
+#define DEAD_DATA_H
+
+#include "./peephole.h" /* Included here so I can use peepholeLine in the prototype */
+
+/*
+  Dead data elimination, an optional stage of peephole.h that runs after the first scan(--dead-data).
+  The data table is split into blocks, each starts at a data label(.data or .string with a label) and holds the words
+  up to the next one. A block is kept when its label is an entry or when an instruction that is still encoded uses it,
+  an array operand keeps the block that holds its element(LIST[5] may reach past the words of LIST). The other blocks
+  are removed from the data table, the data labels are moved back by the words removed before them and DC is updated,
+  all before updateSymbolIndex adds IC to the data labels.
+  Data before the first data label is always kept.
+*/
+
+int deadDataRemove(peepholeLine lines[], int lineCount, char *entries[], int entryCount); /* Removes the data blocks no instruction or entry uses and prints them, returns the amount of words removed */
+
+#endif
@@ -1,9 +1,14 @@
+#define _POSIX_C_SOURCE 200809L /* Required for open_memstream */
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "./files.h"
 #include "./strings.h"
 #include "./utils.h"
 #include "./data.h"
+#include "./options.h"
+#include "./archive.h"
 
 /*
   This file holds functions that helps deal with files, open, and write to them.
@@ -25,11 +30,22 @@
   Prototypes for functions that are only used within this file, the rest of the prototypes for the other functions of this file
   can be found on files.h so they can be used in other files.
 */
+typedef struct memoryFile { /* The content of an output file that is written to memory and then added to the archive */
+  char *data;
+  size_t size;
+} memoryFile;
+
 void writeLine(FILE *fp, int line);
-void createFileIfNotExists(FILE **file, char *ext, char *mode);
+void createFileIfNotExists(FILE **file, memoryFile *mem, char *ext, char *mode);
+void finishFile(FILE **file, memoryFile *mem, char *ext);
+static int updateFile(char *name, char *data, size_t size);
+static void removeOutput(char *ext);
 
 static FILE *obFile, *entFile, *extFile; /* File pointers for each of the result compiled files (.ent, .ext, .ob). It is static so it can be accessed only within this file */
+static FILE *sizeFile, *sizeJsonFile; /* The size report files(.size, .size.json), see sizeReport.h */
+static memoryFile obMem, entMem, extMem, sizeMem, sizeJsonMem; /* When the outputs are archived(or watched) each of the files above is written to one of these */
 char *fileName; /* The name of the file that is currently being proccessed without the extension */
+int changedOutputs; /* The outputs of the current file that were replaced or removed, only counted with --watch */
 
 /*
   Points fileName to a string of the name of the current file that needs to be proccessed. 
@@ -38,6 +54,7 @@ char *fileName; /* The name of the file that is currently being proccessed witho
 */
 void setCurrentWorkingFile(char *name) {
   fileName = name;
+  changedOutputs = 0;
 
   if (obFile != NULL) {
     fclose(obFile);
@@ -48,8 +65,14 @@ void setCurrentWorkingFile(char *name) {
   if (extFile != NULL) {
     fclose(extFile);
   }
+  if (sizeFile != NULL) {
+    fclose(sizeFile);
+  }
+  if (sizeJsonFile != NULL) {
+    fclose(sizeJsonFile);
+  }
 
-  obFile = entFile = extFile = NULL;
+  obFile = entFile = extFile = sizeFile = sizeJsonFile = NULL;
 }
 
 /*
@@ -75,15 +98,41 @@ FILE * openFile(char *fName, char *mode) {
   just do nothing.
   Also if for example a previous compilation had entries, but now it doesn't we want to no longer have
   an entry file, so this is required.
+  The outputs of --binary and --size-report are only deleted when the option is given, so a default compilation makes
+  a single remove call for each of its own 3 outputs.
 */
 void deleteFiles() {
-  char *obFileName = addExtension(fileName, OBJECT_EXT), /* Takes the name of the file and returns a string that holds the same name but with the proper file extenstion */
-  *extFileName = addExtension(fileName, EXTERNAL_EXT),
-  *entFileName = addExtension(fileName, ENTRY_EXT);
+  char *obFileName, *extFileName, *entFileName;
+
+  if (hasOption(ARCHIVE_OPTION)) { /* The outputs are written to the archive, there are no files to delete */
+    return;
+  }
+  if (hasOption(WATCH_OPTION)) { /* The outputs are only replaced when they change, finishFiles removes the ones that aren't written again */
+    if (!hasOption(BINARY_OPTION)) {
+      removeOutput(BINARY_EXT);
+    }
+    return;
+  }
+
+  obFileName = addExtension(fileName, OBJECT_EXT); /* Takes the name of the file and returns a string that holds the same name but with the proper file extenstion */
+  extFileName = addExtension(fileName, EXTERNAL_EXT);
+  entFileName = addExtension(fileName, ENTRY_EXT);
 
   remove(obFileName); /* Deletes the old compiled files */
   remove(extFileName);
   remove(entFileName);
+
+  free(obFileName);
+  free(extFileName);
+  free(entFileName);
+
+  if (hasOption(BINARY_OPTION)) {
+    removeOutput(BINARY_EXT);
+  }
+  if (hasOption(SIZE_REPORT_OPTION)) {
+    removeOutput(SIZE_EXT);
+    removeOutput(SIZE_JSON_EXT);
+  }
 }
 
 /*
@@ -107,9 +156,7 @@ void writeLine(FILE *fp, int line) {
   This function creates the .ob file and writes these numbers to the first line of it.
 */
 void writeObjectMeta() {
-  char *newFileName = addExtension(fileName, OBJECT_EXT); /* Creates a string of the .ob file name eg: FILENAME.ob */
-  obFile = openFile(newFileName, "w"); /* Creates file in write mode */
-  free(newFileName);
+  createFileIfNotExists(&obFile, &obMem, OBJECT_EXT, "w"); /* Creates the .ob file in write mode */
 
   writeCheck(fprintf(obFile, "\t%d\t%d\n", IC - MEMORY_BASE, DC))
   IC = MEMORY_BASE;
@@ -138,25 +185,126 @@ void writeObject(int bin) {
 }
 
 /*
-  This function takes a pointer to a pointer to a FILE struct(it will be used with obFile, extFile and entFile), a string that represents a file extension and
-  a string that represents the mode to open the file with.
+  This function takes a pointer to a pointer to a FILE struct(it will be used with obFile, extFile and entFile), the memory the file is written to
+  when the outputs are archived, a string that represents a file extension and a string that represents the mode to open the file with.
   Creates a string of the fileName with the given extension and opens it with the given mode and points the first paramater value to the result.
+  When the outputs are archived, or only replaced when they change(--watch), no file is created, the FILE writes to the
+  memory instead.
 */
-void createFileIfNotExists(FILE **file, char *ext, char *mode) {
-  if (*file == NULL) {
+void createFileIfNotExists(FILE **file, memoryFile *mem, char *ext, char *mode) {
+  if (*file == NULL && hasOption(ARCHIVE_OPTION | WATCH_OPTION)) {
+    if ((*file = open_memstream(&mem->data, &mem->size)) == NULL) {
+      printf("Cannot allocate memory\n");
+      exit(0);
+    }
+  } else if (*file == NULL) {
     char *extFileName = addExtension(fileName, ext);
     *file = openFile(extFileName, mode);
     free(extFileName);
   }
 }
 
+/*
+  Closes one of the output files if it was created.
+  When the outputs are archived the content the file was written with is added to the archive as a member with the name the file would have.
+  With --watch the file is replaced only if its content changed, and an output that wasn't created this time is removed.
+*/
+void finishFile(FILE **file, memoryFile *mem, char *ext) {
+  if (*file == NULL) {
+    if (hasOption(WATCH_OPTION)) { /* A previous compilation may have created it */
+      removeOutput(ext);
+    }
+    return;
+  }
+
+  fclose(*file);
+  *file = NULL;
+
+  if (hasOption(ARCHIVE_OPTION | WATCH_OPTION)) {
+    char *outputName = addExtension(fileName, ext);
+
+    if (hasOption(ARCHIVE_OPTION)) {
+      archiveAdd(outputName, mem->data, mem->size);
+    } else {
+      changedOutputs += updateFile(outputName, mem->data, mem->size);
+    }
+    free(outputName);
+    free(mem->data);
+    mem->data = NULL;
+  }
+}
+
+/*
+  Accepts the name of an output file and the content it should have.
+  Compares the content with the file and replaces the file only if it differs, so whatever depends on the outputs isn't
+  rebuilt for nothing. The content is written to a temporary file that is renamed over the output, a reader never sees
+  it half written.
+  Returns 1 if the file was replaced, 0 if it already had the content.
+*/
+static int updateFile(char *name, char *data, size_t size) {
+  char buf[BUFSIZ], *tmpName;
+  size_t offset = 0, n;
+  FILE *fp = fopen(name, "rb");
+  int same = fp != NULL;
+
+  if (fp != NULL) {
+    while (same && (n = fread(buf, 1, sizeof(buf), fp)) > 0) {
+      same = offset + n <= size && memcmp(buf, data + offset, n) == 0;
+      offset += n;
+    }
+    fclose(fp);
+    if (same && offset == size) {
+      return 0;
+    }
+  }
+
+  tmpName = addExtension(name, ".tmp");
+  if ((fp = openFile(tmpName, "wb")) == NULL) {
+    free(tmpName);
+    return 0;
+  }
+  if (size > 0 && fwrite(data, 1, size, fp) != size) {
+    printf("Cannot write to file\n");
+    exit(0);
+  }
+  fclose(fp);
+  if (rename(tmpName, name) != 0) {
+    printf("Cannot replace file %s\n", name);
+    remove(tmpName);
+  }
+  free(tmpName);
+  return 1;
+}
+
+/*
+  Accepts an extension and removes the output of the current file with it, counts it if it existed.
+*/
+static void removeOutput(char *ext) {
+  char *outputName = addExtension(fileName, ext);
+
+  changedOutputs += remove(outputName) == 0;
+  free(outputName);
+}
+
+/*
+  Called after all of the outputs of the current file were written.
+  Closes the output files, when the outputs are archived this is when they are added to the archive.
+*/
+void finishFiles() {
+  finishFile(&obFile, &obMem, OBJECT_EXT);
+  finishFile(&entFile, &entMem, ENTRY_EXT);
+  finishFile(&extFile, &extMem, EXTERNAL_EXT);
+  finishFile(&sizeFile, &sizeMem, SIZE_EXT);
+  finishFile(&sizeJsonFile, &sizeJsonMem, SIZE_JSON_EXT);
+}
+
 /*
   Takes as parameters a string that represents an external label, and the current line that is proccessed.
   Creates the .ext file if it does not exists.
   Write to the .ext file the label that was used with the given line.
 */
 void writeExternal(char *ext, int line) {
-  createFileIfNotExists(&extFile, EXTERNAL_EXT, "w");
+  createFileIfNotExists(&extFile, &extMem, EXTERNAL_EXT, "w");
 
   writeCheck(fprintf(extFile, "%s\t", ext))
   writeLine(extFile, line);
@@ -172,7 +320,7 @@ void createEntries() {
 
   while (cur) {
     if (cur->type == ENTRY) {
-      createFileIfNotExists(&entFile, ENTRY_EXT, "w");
+      createFileIfNotExists(&entFile, &entMem, ENTRY_EXT, "w");
       writeCheck(fprintf(entFile, "%s\t", cur->label))
       writeLine(entFile, cur->val);
       writeCheck(putc('\n', entFile))
@@ -180,3 +328,50 @@ void createEntries() {
     cur = cur->next;
   }
 }
+
+/*
+  Accepts a binary object that was built in memory and its size in bytes.
+  Creates the .bo file and writes the object to it as is, or adds it to the archive when the outputs are archived.
+*/
+void writeBinaryObject(unsigned char *data, unsigned long size) {
+  char *binFileName = addExtension(fileName, BINARY_EXT);
+  FILE *fp;
+
+  if (hasOption(ARCHIVE_OPTION)) {
+    archiveAdd(binFileName, (char *) data, size);
+    free(binFileName);
+    return;
+  }
+  if (hasOption(WATCH_OPTION)) {
+    changedOutputs += updateFile(binFileName, (char *) data, size);
+    free(binFileName);
+    return;
+  }
+
+  fp = openFile(binFileName, "wb");
+
+  free(binFileName);
+  if (fp == NULL) {
+    return;
+  }
+
+  if (fwrite(data, 1, size, fp) != size) {
+    printf("Cannot write to file\n");
+    exit(0);
+  }
+  fclose(fp);
+}
+
+/*
+  Accepts wether the JSON report is requested.
+  Creates the .size file(or the .size.json file) the way the other outputs are created and returns it, it is closed by
+  finishFiles. Returns NULL if the file couldn't be created.
+*/
+FILE * createSizeReport(int json) {
+  if (json) {
+    createFileIfNotExists(&sizeJsonFile, &sizeJsonMem, SIZE_JSON_EXT, "w");
+    return sizeJsonFile;
+  }
+  createFileIfNotExists(&sizeFile, &sizeMem, SIZE_EXT, "w");
+  return sizeFile;
+}
@@ -10,6 +10,9 @@
 #define ENTRY_EXT ".ent"  /* Entries file */
 #define OBJECT_EXT ".ob" /* Object file(machine code) */
 #define ASSEMBLY_EXT ".as" /* Assembly file (source code) */
+#define BINARY_EXT ".bo" /* Binary object file, see object.h */
+#define SIZE_EXT ".size" /* Size report, see sizeReport.h */
+#define SIZE_JSON_EXT ".size.json" /* Size report as JSON, see sizeReport.h */
 
 #define LINE_CHARS 4 /* In the entry, object and external output files lines are being written, some have leading zeros, this definition defines how many characters a line should have */
 #define CPU_BIT_SIZE 14 /* The characters count of the binary representation of each word */
@@ -22,7 +25,11 @@ void writeObjectMeta(); /* Creates the object file and writes to it the instruct
 void writeObject(int bin); /* Writes a single word with the current line to the object file */
 void writeExternal(char *ext, int line); /* Writes a label of an external and the line it was used to the external file */
 void createEntries(); /* Creates the entries file if needed, loops through the symbol table and adds the entries to it and their usage line */
+void finishFiles(); /* Closes the output files of the current file, or adds them to the archive */
+void writeBinaryObject(unsigned char *data, unsigned long size); /* Writes a binary object that was built in memory to the .bo file */
+FILE * createSizeReport(int json); /* Creates the .size file, or the .size.json file, and returns it */
 
 extern char *fileName; /* The current file that is being processed */
+extern int changedOutputs; /* The outputs of the current file that changed on the disk, only counted with --watch */
 
 #endif
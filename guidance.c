@@ -7,6 +7,9 @@
 #include "./data.h"
 #include "./status.h"
 #include "./strings.h"
+#include "./structural.h"
+#include "./stringPool.h"
+#include "./include.h"
 
 /*
   Functions that handles source code line that are of type guidance.
@@ -30,7 +33,8 @@ guidance guidances[] = {
   { "string", createString },
   { "entry", createEntry },
   { "extern", createExtern },
-  { "define", createDefinition }
+  { "define", createDefinition },
+  { "include", createInclude }
 };
 
 /*
@@ -75,8 +79,8 @@ guidancePtr getGuidance(char *str) {
   Creates a label in the symbol table if a label was given.
 */
 int createData(char *line, char *label) {
-  int args;
-  char *arg;
+  int args, val = 0, status;
+  char *arg, *end;
 
   if (label != NULL) { /* If a label was given adds it to the symbol table */
     addSymbolNode(label, DC, GUIDANCE);
@@ -94,9 +98,13 @@ int createData(char *line, char *label) {
 
   while (args--) { /* Loops through the arguments */
     arg = getArg(&line);
+    status = parseNumber(arg, WORD_MIN, WORD_MAX, &val, &end); /* Validates, converts and checks the range in a single pass */
 
-    if (checkNumeric(arg) == OK_STATUS) { /* If argument was a number adds it immediately */
-      addDataNode(label, atoi(arg));
+    if (status == OK_STATUS && *end == '\0') { /* If argument was a number adds it immediately */
+      addDataNode(label, val);
+    } else if (status == OUT_OF_RANGE && *end == '\0') { /* A number that does not fit in a word */
+      printe("%s is out of range, a word can hold values between %d and %d", 0, arg, WORD_MIN, WORD_MAX);
+      return OUT_OF_RANGE;
     } else { /* Else the argument is a macro */
       symbolNodePtr mac = symbolNodeByLabel(arg);
 
@@ -123,7 +131,7 @@ int createData(char *line, char *label) {
 */
 int createString(char *line, char *label) {
   char ch;
-  int i, 
+  int i, pos,
   start = 0; /* Used later in a loop */
 
   if (label != NULL) { /* Checks if a label was given and if so adds it to symbol table */
@@ -144,6 +152,11 @@ int createString(char *line, char *label) {
   line++;
   i = strlen(line) - 1; /* We need to subtract 1 to point the last character that is not \0 */
 
+  if ((pos = indexedPosition(&lineStructure, line)) >= 0) { /* Jumps over the trailing spaces using the structural index */
+    i = lastNonStructural(&lineStructure, pos + i + 1, classBit(WHITESPACE_CLASS)) - pos;
+    i = i < 0 ? -1 : i; /* The opening quote and the characters before it are not part of the string */
+  }
+
   while (i >= 0) { /* Loops throguh all of the characters from the end to the beginning */
     ch = *(line + i);
     if (!isspace(ch)) {
@@ -169,6 +182,10 @@ int createString(char *line, char *label) {
     addDataNode(label, (int) *(line + i));
   }
 
+  if (label != NULL) { /* Interns the string for --pool-strings */
+    stringPoolAdd(label, strlen(line) + 1);
+  }
+
   return OK_STATUS;
 }
 
@@ -181,6 +198,8 @@ int createString(char *line, char *label) {
 int createExtern(char *line, char *label) {
   char *ext = lalloc(), *check = lalloc();
 
+  *ext = *check = '\0'; /* sscanf leaves the buffers untouched when there are not enough words in the line */
+
   if (label != NULL) { /* Checks if a label was given */
     warning("A label in an extern guidance is meaningless");
   }
@@ -209,8 +228,10 @@ int createExtern(char *line, char *label) {
   Sends an error if a label was given.
 */
 int createDefinition(char *line, char *label) {
-  char *macro = lalloc(), *num = lalloc(), *token, *del = "=", *check = lalloc();
-  int val;
+  char *macro = lalloc(), *token, *del = "=", *check = lalloc(), *end;
+  int val = 0, status;
+
+  *macro = *check = '\0'; /* sscanf leaves the buffers untouched when there are not enough words in the line */
 
   if (label != NULL) { /* Checks if a label was given */
     printe("Cannot add a label to a macro definition", 0);
@@ -219,39 +240,49 @@ int createDefinition(char *line, char *label) {
   token = strtok(line, del); /* Seperate the line with the '=' sign */
 
   if (token == NULL) { /* Checks if an argument was passed to .define */
-    printe("No argument passed to .define statement", 3, macro, num, check);
+    printe("No argument passed to .define statement", 2, macro, check);
     return NOT_ENOUGH_ARGS;
   }
 
   sscanf(token, "%s %s", macro, check);/* Extracts macro name and value from the source code line */
 
   if (strlen(check)) { /* Checks if a '=' was not present  */
-    printe("Macro name needs to be followed by a '='", 3, macro, num, check);
+    printe("Macro name needs to be followed by a '='", 2, macro, check);
     return INVALID_SYNTAX;
   }
 
   token = strtok(NULL, del);
 
   if (token == NULL) {
-    printe("Macro name needs to be followed by a '='", 3, macro, num, check);
+    printe("Macro name needs to be followed by a '='", 2, macro, check);
     return INVALID_SYNTAX;
   }
 
-  sscanf(token, "%s %s", num, check);
+  skipSpace(&token);
+  status = parseNumber(token, WORD_MIN, WORD_MAX, &val, &end); /* Reads the macro value in a single pass */
 
-  if (strlen(check)) { /* Checks if to many values were passed to .define */
-    printe("Macro value cannot be followed by another value", 3, macro, num, check);
+  if (status != INVALID_ARGUMENT && !isspace(*end) && *end != '\0') { /* A number followed by other characters, eg: 12ab */
+    status = INVALID_ARGUMENT;
+  }
+  if (status == INVALID_ARGUMENT) { /* Checks if the macro value is numeric */
+    printe("Macro value must be a whole number", 2, macro, check);
+    return INVALID_ARGUMENT;
+  }
+
+  skipSpace(&end);
+
+  if (*end != '\0') { /* Checks if to many values were passed to .define */
+    printe("Macro value cannot be followed by another value", 2, macro, check);
     return TOO_MANY_ARGS;
   }
-  
-  if (checkNumeric(num) != OK_STATUS) { /* Checks if the macro value is numeric */
-    printe("Macro value must be a whole number", 0);
+  if (status == OUT_OF_RANGE) { /* The macro value must fit in a word */
+    frees(2, macro, check);
+    printe("Macro value must be between %d and %d", 0, WORD_MIN, WORD_MAX);
+    return OUT_OF_RANGE;
   }
-  
-  val = atoi(num);
-  
+
   addSymbolNode(macro, val, MACRO); /* Adds macro to symbol table */
-  frees(3, macro, num, check);
+  frees(2, macro, check);
   return OK_STATUS;
 }
 
@@ -0,0 +1,339 @@
+#define _XOPEN_SOURCE 700 /* Required for realpath and the nanoseconds of the modification time */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <sys/stat.h>
+#include "./include.h"
+#include "./guidance.h"
+#include "./scan.h"
+#include "./data.h"
+#include "./utils.h"
+#include "./strings.h"
+#include "./files.h"
+#include "./status.h"
+#include "./profile.h"
+
+/*
+  This file holds the .include guidance and the cache of the included files, see include.h.
+*/
+
+typedef struct includeModule *includeModulePtr;
+
+typedef struct includeSymbol { /* A macro or an external of a module */
+  char *label;
+  int val, type;
+} includeSymbol;
+
+typedef struct includeEdge { /* A module that a module includes after its first 'position' symbols */
+  includeModulePtr module;
+  int position;
+} includeEdge;
+
+typedef struct includeModule { /* An included file that was parsed */
+  char *path; /* The real path of the file, the key of the cache */
+  char *name; /* The name it was first included with without its extension, the messages of its lines use it */
+  long seconds, nanoseconds, size; /* The modification time and the size of the file when it was parsed */
+  includeSymbol *symbols;
+  int symbolCount;
+  includeEdge *includes;
+  int includeCount;
+  int valid; /* It was parsed without errors */
+  int active; /* It is being parsed or merged, including it again is a cycle */
+  int mergedIn; /* The last source it was merged into, see includeReset */
+  includeModulePtr next;
+} includeModule;
+
+enum REFRESH /* The results of refresh */
+{
+  MISSING_FILE = -1,
+  FAILED_FILE,
+  VALID_FILE
+};
+
+static int scanModule(char *line);
+static int merge(includeModulePtr module, symbolNodePtr *tail);
+
+static includeModulePtr modules; /* The cache */
+static includeModulePtr parsing; /* The module whose file is being parsed, NULL while the source itself is scanned */
+static int source = 1; /* The current source, counted by includeReset */
+
+/*
+  Reallocates memory and checks that it was allocated.
+*/
+static void *grow(void *p, size_t size) {
+  if ((p = realloc(p, size)) == NULL) {
+    printf("Cannot allocate memory\n");
+    exit(0);
+  }
+  return p;
+}
+
+/*
+  Should be called before a source is scanned, every module may be merged into it once again.
+*/
+void includeReset(void) {
+  source++;
+}
+
+/*
+  Accepts the name an .include gave.
+  Returns a new string of the name relative to the directory of the file that is scanned(fileName).
+*/
+static char *relativeName(char *name) {
+  char *slash = strrchr(fileName, '/');
+  size_t dirLength = slash == NULL ? 0 : slash - fileName + 1;
+  char *result = grow(NULL, dirLength + strlen(name) + 1);
+
+  strncpy(result, fileName, dirLength);
+  strcpy(result + dirLength, name);
+  return result;
+}
+
+/*
+  Accepts a module and the status of its file.
+  Scans the file into the module with scanModule, the symbols its lines add are moved from a symbol table of its own to
+  the module and the modules it includes are recorded in it(see createInclude). The state of the scan of the including
+  file is kept and restored.
+  Returns wether the file was parsed without errors.
+*/
+static int parse(includeModulePtr module, struct stat *info) {
+  symbolNodePtr savedHead = symbolHead, cur;
+  includeModulePtr savedParsing = parsing;
+  char *savedName = fileName, *savedLine = copyString(line);
+  int savedIndex = lineIndex, savedError = error, i;
+  FILE *fp = fopen(module->path, "r");
+
+  if (fp == NULL) {
+    free(savedLine);
+    return 0;
+  }
+
+  module->symbolCount = module->includeCount = 0;
+  symbolHead = NULL;
+  parsing = module;
+  fileName = module->name;
+  lineIndex = 0;
+  error = OK;
+  module->active = 1;
+
+  scan(fp, scanModule);
+  fclose(fp);
+
+  module->active = 0;
+  module->valid = error == OK;
+  for (cur = symbolHead; cur != NULL; cur = cur->next) {
+    module->symbolCount++;
+  }
+  module->symbols = grow(module->symbols, sizeof(includeSymbol) * (module->symbolCount + 1));
+  for (cur = symbolHead, i = 0; cur != NULL; cur = cur->next, i++) { /* The module keeps the labels */
+    module->symbols[i].label = cur->label;
+    module->symbols[i].val = cur->val;
+    module->symbols[i].type = cur->type;
+  }
+  symbolNodeFree(symbolHead);
+  module->seconds = info->st_mtim.tv_sec;
+  module->nanoseconds = info->st_mtim.tv_nsec;
+  module->size = info->st_size;
+
+  symbolHead = savedHead;
+  parsing = savedParsing;
+  fileName = savedName;
+  lineIndex = savedIndex;
+  error = savedError;
+  strcpy(line, savedLine);
+  free(savedLine);
+  return module->valid;
+}
+
+/*
+  Accepts a module.
+  Parses its file again if it changed since it was parsed, or if it had errors.
+  Returns enum REFRESH.
+*/
+static int refresh(includeModulePtr module) {
+  struct stat info;
+
+  if (stat(module->path, &info) != 0) {
+    return MISSING_FILE;
+  }
+  if (module->valid && info.st_mtim.tv_sec == module->seconds && info.st_mtim.tv_nsec == module->nanoseconds &&
+      info.st_size == module->size) {
+    profileCount(INCLUDE_HITS, 1);
+    return VALID_FILE;
+  }
+  profileCount(INCLUDE_PARSES, 1);
+  return parse(module, &info) ? VALID_FILE : FAILED_FILE;
+}
+
+/*
+  Accepts a module and the result of refreshing it.
+  Reports an error on the current line if the module can't be included, returns wether it can.
+*/
+static int checkRefresh(includeModulePtr module, int result) {
+  if (result == MISSING_FILE) {
+    printe("Cannot open the included file %s" ASSEMBLY_EXT, 0, module->name);
+  } else if (result == FAILED_FILE) {
+    printe("The included file %s" ASSEMBLY_EXT " has errors", 0, module->name);
+  }
+  return result == VALID_FILE;
+}
+
+/*
+  Accepts the last node of the symbol table(NULL when it is empty) and a symbol of a module.
+  Adds the symbol after it and points tail to the new node.
+*/
+static void appendSymbol(symbolNodePtr *tail, includeSymbol *symbol) {
+  symbolNodePtr new = salloc();
+
+  new->label = symbol->label; /* The labels of the symbol table are never freed, the label of the module is shared */
+  new->val = symbol->val;
+  new->type = symbol->type;
+  new->next = NULL;
+  if (*tail == NULL) {
+    symbolHead = new;
+  } else {
+    (*tail)->next = new;
+  }
+  *tail = new;
+}
+
+/*
+  Accepts a module and the last node of the symbol table.
+  Adds the symbols of the module and of the modules it includes to the symbol table in the order of their lines, unless
+  it was already merged into the current source. The modules it includes are parsed again if they changed.
+  Returns a status.
+*/
+static int merge(includeModulePtr module, symbolNodePtr *tail) {
+  int i, k = 0, end, status = OK_STATUS;
+  includeModulePtr included;
+
+  if (module->mergedIn == source) { /* The include guard */
+    return OK_STATUS;
+  }
+  module->mergedIn = source;
+  module->active = 1;
+
+  for (i = 0; i <= module->includeCount; i++) {
+    end = i < module->includeCount ? module->includes[i].position : module->symbolCount;
+    for (; k < end; k++) {
+      appendSymbol(tail, &module->symbols[k]);
+    }
+    if (i == module->includeCount) {
+      break;
+    }
+
+    included = module->includes[i].module;
+    if (included->active) {
+      printe("The file %s" ASSEMBLY_EXT " includes itself", 0, included->name);
+      status = INVALID_ARGUMENT;
+    } else if (included->mergedIn != source && (!checkRefresh(included, refresh(included)) ||
+                                                merge(included, tail) != OK_STATUS)) {
+      status = INVALID_ARGUMENT;
+    }
+  }
+
+  module->active = 0;
+  return status;
+}
+
+/*
+  Accepts a line of an included file.
+  Checks that it is empty, a comment, or a .define, .extern or .include line and handles it like the first scan does.
+  Returns a status.
+*/
+static int scanModule(char *line) {
+  char *word = getWord(&line), *label = NULL;
+
+  if (*word == '\0' || *word == ';') {
+    return OK_STATUS;
+  }
+  if (word[strlen(word) - 1] == ':') {
+    word[strlen(word) - 1] = '\0';
+    label = word;
+    word = getWord(&line);
+  }
+  if (strcmp(word, ".define") != 0 && strcmp(word, ".extern") != 0 && strcmp(word, ".include") != 0) {
+    printe("An included file can only have .define, .extern and .include lines", 0);
+    return INVALID_SYNTAX;
+  }
+  return handleGuidance(line, word, label);
+}
+
+/*
+  Handles an '.include' guidance.
+  Checks for syntax errors and finds the module of the file in the cache, it is parsed if it isn't there or its file
+  changed. When the source is scanned its symbols are merged into the symbol table, when an included file is parsed
+  the module is recorded in the module of that file.
+  Sends a warning if a label was given.
+*/
+int createInclude(char *line, char *label) {
+  char *name, *path, *end, *real;
+  includeModulePtr module;
+  symbolNodePtr tail;
+
+  if (label != NULL) {
+    warning("A label in an include guidance is meaningless");
+  }
+
+  skipSpace(&line);
+  if (*line != '"' || (end = strchr(line + 1, '"')) == NULL || end == line + 1) {
+    printe("Include expects the name of a file in quotes", 0);
+    return INVALID_SYNTAX;
+  }
+  *end = '\0';
+  for (end++; isspace(*end); end++)
+    ;
+  if (*end != '\0') {
+    printe("The name of the included file cannot be followed by another value", 0);
+    return TOO_MANY_ARGS;
+  }
+
+  name = relativeName(line + 1);
+  path = addExtension(name, ASSEMBLY_EXT);
+  real = realpath(path, NULL);
+  free(path);
+  if (real == NULL) {
+    printe("Cannot open the included file %s" ASSEMBLY_EXT, 0, name);
+    free(name);
+    return INVALID_ARGUMENT;
+  }
+
+  for (module = modules; module != NULL && strcmp(module->path, real) != 0; module = module->next)
+    ;
+  if (module == NULL) {
+    module = grow(NULL, sizeof(includeModule));
+    memset(module, 0, sizeof(includeModule));
+    module->path = real;
+    module->name = name;
+    module->next = modules;
+    modules = module;
+  } else {
+    free(real);
+    free(name);
+  }
+
+  if (module->active) {
+    printe("The file %s" ASSEMBLY_EXT " includes itself", 0, module->name);
+    return INVALID_ARGUMENT;
+  }
+  if (!checkRefresh(module, refresh(module))) {
+    return INVALID_ARGUMENT;
+  }
+
+  if (parsing != NULL) { /* Recorded in the module of the included file that is parsed */
+    parsing->includes = grow(parsing->includes, sizeof(includeEdge) * (parsing->includeCount + 1));
+    parsing->includes[parsing->includeCount].module = module;
+    parsing->includes[parsing->includeCount].position = 0;
+    for (tail = symbolHead; tail != NULL; tail = tail->next) {
+      parsing->includes[parsing->includeCount].position++;
+    }
+    parsing->includeCount++;
+    return OK_STATUS;
+  }
+
+  for (tail = symbolHead; tail != NULL && tail->next != NULL; tail = tail->next)
+    ;
+  return merge(module, &tail);
+}
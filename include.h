@@ -0,0 +1,21 @@
+#ifndef INCLUDE_H
+#define INCLUDE_H
+
+/*
+  The .include guidance, it adds the macros and the externals of another file to the symbol table:
+  .include "NAME"
+  The name is given without the '.as' extension like on the command line, relative to the directory of the file that
+  includes it. An included file may only have .define, .extern and .include lines(and comments and empty lines).
+
+  Every included file is parsed once per process into a module: its symbols and the modules it includes, kept in a
+  cache that is keyed by the real path of the file and checked against its modification time and size on every
+  include, a changed file is parsed again. An include merges the symbols of the module from the cache, so when many
+  sources include the same file(a batch of files, or the workers of --watch) it is only parsed for the first one.
+  A module is merged once into each source however many times it is included(an include guard), a file that includes
+  itself, directly or through other files, is an error.
+*/
+
+int createInclude(char *line, char *label); /* Handles an .include guidance in the first scan, returns a status */
+void includeReset(void); /* Starts a new source, the modules the previous one included may be included again */
+
+#endif
@@ -0,0 +1,772 @@
+#define _POSIX_C_SOURCE 200809L /* Required for fmemopen */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "./incremental.h"
+#include "./compile.h"
+#include "./scan.h"
+#include "./command.h"
+#include "./commandUtils.h"
+#include "./guidance.h"
+#include "./output.h"
+#include "./peephole.h"
+#include "./data.h"
+#include "./utils.h"
+#include "./strings.h"
+#include "./status.h"
+#include "./options.h"
+#include "./files.h"
+
+/*
+  This file holds the incremental reassembly, see incremental.h.
+*/
+
+#define LINES_CHUNK 1024 /* The amount of lines the array of lines grows by */
+#define DELIMITERS " \t\n\v\f\r," /* The characters between the words and the operands of a line */
+
+enum LINE_KIND /* Types of source code lines, the edits of the first 3 can be done incrementally */
+{
+  BLANK_LINE, /* An empty line or a comment */
+  INSTRUCTION_LINE,
+  DATA_LINE, /* .data or .string */
+  OTHER_LINE /* .define, .entry, .extern and lines the first scan rejects before parsing them */
+};
+
+typedef struct sourceLine { /* A line of the source code and what the last build found in it */
+  char *source, /* The line without its new line */
+  *label; /* The label the line defines, NULL if it has none */
+  int kind, /* enum LINE_KIND */
+  ends, /* The line is an instruction that ends a basic block, a jump, rts or stop */
+  address, /* The address of the first word of an instruction, the index of the first word of data in the data table */
+  dataWords, /* The amount of words added to the data table */
+  words[MAX_WORDS], wordCount, /* The words the second scan encoded */
+  relocations[MAX_WORDS], relocationCount, /* The distance of each relocatable word from the first word */
+  externalOffsets[MAX_WORDS], externalCount; /* The distance of each word that uses an external from the first word */
+  char *externals[MAX_WORDS]; /* The labels of the externals, they point to the labels of the symbol table like extLabels */
+  symbolNodePtr references[MAX_ARGS]; /* The labels of this file the operands use */
+  int referenced[MAX_ARGS], referenceCount; /* The values the labels had when the line was encoded */
+} sourceLine;
+
+static sourceLine *lines; /* The lines of the source code in their order */
+static int lineCount, lineCapacity;
+static char *sourceName; /* The name of the file without its extension */
+static int built; /* The last build compiled successfully, so the results of the lines are valid */
+static int codeWords, dataWords; /* The amount of instruction words and data words of the last build */
+static int firstScanned, secondScanned; /* The next line the first and the second scan of a full build treat */
+static char *reason; /* Why the last edit compiled the whole source again */
+
+/*
+  Accepts a line of the source code and copies it to 'line' the way fgets would read it from the file(see scan).
+  Returns wether the line is longer than LINE_MAX - 1 characters with its new line, only its start is copied then.
+*/
+static int setLine(char *source) {
+  if (strlen(source) + 1 > LINE_MAX - 1) {
+    strncpy(line, source, LINE_MAX - 1);
+    line[LINE_MAX - 1] = '\0';
+    return 1;
+  }
+  strcpy(line, source);
+  strcat(line, "\n");
+  return 0;
+}
+
+/*
+  Accepts a line, a buffer of LINE_MAX + 1 characters and an array of MAX_ARGS operands.
+  Copies the line to the buffer, splits it to its words and points the operands to the ones after the command.
+  Returns the amount of operands, at most MAX_ARGS, and points command to the command(an empty string if there is none).
+*/
+static int splitOperands(sourceLine *cur, char buffer[], char **command, char *args[]) {
+  char *word;
+  int count = 0;
+
+  strncpy(buffer, cur->source, LINE_MAX);
+  buffer[LINE_MAX] = '\0';
+  *command = "";
+  if ((word = strtok(buffer, DELIMITERS)) != NULL && cur->label != NULL) { /* Skips the label */
+    word = strtok(NULL, DELIMITERS);
+  }
+  if (word == NULL) {
+    return 0;
+  }
+  *command = word;
+  while (count < MAX_ARGS && (word = strtok(NULL, DELIMITERS)) != NULL) {
+    args[count++] = word;
+  }
+  return count;
+}
+
+/*
+  Finds the kind of a line, its label and wether it ends a basic block.
+*/
+static void classify(sourceLine *cur) {
+  char buffer[LINE_MAX + 2], *rest = buffer, *word;
+
+  free(cur->label);
+  cur->label = NULL;
+  cur->ends = 0;
+  cur->kind = OTHER_LINE;
+  if (strlen(cur->source) + 1 > LINE_MAX - 1) { /* The first scan rejects it */
+    return;
+  }
+
+  strcpy(buffer, cur->source);
+  strcat(buffer, "\n");
+  word = getWord(&rest);
+  if (*word == '\0' || *word == ';') {
+    cur->kind = BLANK_LINE;
+    return;
+  }
+  if (word[strlen(word) - 1] == ':') {
+    word[strlen(word) - 1] = '\0';
+    cur->label = copyString(word);
+    word = getWord(&rest);
+  }
+
+  if (*word == '.') {
+    cur->kind = strcmp(word, ".data") == 0 || strcmp(word, ".string") == 0 ? DATA_LINE : OTHER_LINE;
+  } else if (*word != '\0') {
+    commandPtr comm = getCommand(word);
+
+    cur->kind = INSTRUCTION_LINE;
+    cur->ends = comm != NULL && (comm->flags & ENDS_BLOCK) != 0;
+  }
+}
+
+/*
+  Finds the labels of this file the operands of an instruction use and keeps their current values.
+*/
+static void findReferences(sourceLine *cur) {
+  char buffer[LINE_MAX + 1], *command, *args[MAX_ARGS];
+  int count, k;
+
+  cur->referenceCount = 0;
+  if (cur->kind != INSTRUCTION_LINE) {
+    return;
+  }
+
+  count = splitOperands(cur, buffer, &command, args);
+  for (k = 0; k < count; k++) {
+    symbolNodePtr node = peepholeSymbol(args[k]);
+
+    if (node != NULL && node->type != EXTERNAL && node->type != MACRO) {
+      cur->references[cur->referenceCount] = node;
+      cur->referenced[cur->referenceCount++] = node->val;
+    }
+  }
+}
+
+/*
+  Returns the amount of array operands of an instruction that the second scan folds, see peepholeFolds.
+*/
+static int foldedOperands(sourceLine *cur) {
+  char buffer[LINE_MAX + 1], *command, *args[MAX_ARGS];
+  int count = splitOperands(cur, buffer, &command, args), folded = 0, k;
+
+  for (k = 0; k < count; k++) {
+    folded += getArgType(args[k]) == ARR && peepholeFolds(args[k], getCommand(command), k);
+  }
+  return folded;
+}
+
+/*
+  Checks wether an operand of an instruction uses the address of an instruction, as data or as the label of an array.
+*/
+static int usesCode(sourceLine *cur) {
+  int k;
+
+  for (k = 0; k < cur->referenceCount; k++) {
+    if (cur->references[k]->val < MEMORY_BASE + codeWords) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/*
+  Checks wether a label an operand of an instruction uses has moved since the line was encoded.
+*/
+static int moved(sourceLine *cur) {
+  int k;
+
+  for (k = 0; k < cur->referenceCount; k++) {
+    if (cur->references[k]->val != cur->referenced[k]) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/*
+  Accepts a line and a slice of the output that was marked before the second scan encoded it.
+  Keeps the words, the externals and the relocatable words the line added, and the labels its operands use.
+*/
+static void keepOutput(sourceLine *cur, outputSlice *slice) {
+  int k;
+
+  outputSince(slice);
+  memcpy(cur->words, slice->words, sizeof(int) * slice->wordCount);
+  cur->wordCount = slice->wordCount;
+  for (k = 0, cur->relocationCount = slice->relocationCount; k < slice->relocationCount; k++) {
+    cur->relocations[k] = slice->relocationLines[k] - cur->address;
+  }
+  for (k = 0, cur->externalCount = slice->externalCount; k < slice->externalCount; k++) {
+    cur->externals[k] = slice->externalLabels[k];
+    cur->externalOffsets[k] = slice->externalLines[k] - cur->address;
+  }
+  findReferences(cur);
+}
+
+/*
+  Returns the next line the first scan of a full build treats, the scan skips the lines that are too long.
+*/
+static sourceLine *nextLine(int *scanned) {
+  while (strlen(lines[*scanned].source) + 1 > LINE_MAX - 1) {
+    (*scanned)++;
+  }
+  return &lines[(*scanned)++];
+}
+
+/*
+  The first scan of a full build, keeps where the data of each line starts and its amount of words.
+*/
+static int firstOfBuild(char *text) {
+  sourceLine *cur = nextLine(&firstScanned);
+  int status;
+
+  cur->address = DC;
+  status = scanFirst(text);
+  cur->dataWords = DC - cur->address;
+  return status;
+}
+
+/*
+  The second scan of a full build, keeps the address and the output of each line.
+*/
+static int secondOfBuild(char *text) {
+  sourceLine *cur = nextLine(&secondScanned);
+  outputSlice slice;
+  int status;
+
+  if (cur->kind == INSTRUCTION_LINE) {
+    cur->address = IC;
+  }
+  outputMark(&slice);
+  status = scanSecond(text);
+  keepOutput(cur, &slice);
+  return status;
+}
+
+/*
+  The first scan of a new line of an incremental edit. It works like scanFirst but the label of the line is not added,
+  the label already has a node in the symbol table, and the line is not recorded for the optimizer.
+*/
+static int firstOfEdit(char *text) {
+  char *word = getWord(&text);
+
+  if (strlen(word) == 0 || *word == ';') {
+    return OK_STATUS;
+  }
+  if (*(word + strlen(word) - 1) == ':') {
+    word = getWord(&text);
+  }
+
+  if (*word == '.') {
+    return handleGuidance(text, word, NULL);
+  }
+  return handleFirstCommand(text, word, NULL);
+}
+
+/*
+  Accepts a line and its number(counted from 1).
+  Encodes it with the second scan at its address, with output variables of its own.
+*/
+static void encodeLine(sourceLine *cur, int number) {
+  outputSlice slice;
+  int overflow = setLine(cur->source);
+
+  IC = MEMORY_BASE + MAX_WORDS; /* Enough room for the words of a single line */
+  initOutputVars();
+  IC = cur->address;
+  lineIndex = number - 1;
+
+  outputMark(&slice);
+  scanLine(scanSecond, overflow); /* No instruction was removed or rewritten, so peepholeRewrite keeps every line as it is */
+  keepOutput(cur, &slice);
+  freeOutputVars();
+}
+
+/*
+  Adds the kept output of every line to the output variables and writes the outputs.
+*/
+static void writeKept() {
+  int i, k;
+
+  IC = MEMORY_BASE + codeWords;
+  initOutputVars();
+  IC = MEMORY_BASE;
+
+  for (i = 0; i < lineCount; i++) {
+    sourceLine *cur = &lines[i];
+
+    for (k = 0; k < cur->externalCount; k++) {
+      addExternal(cur->externals[k], cur->address + cur->externalOffsets[k]);
+    }
+    for (k = 0; k < cur->relocationCount; k++) {
+      addRelocation(cur->address + cur->relocations[k]);
+    }
+    addWords(cur->words, cur->wordCount);
+  }
+
+  DC = dataWords;
+  writeOutputs();
+}
+
+/*
+  Accepts a line that is removed or added by an edit.
+  Returns why the edit can't be done incrementally because of the line, or NULL if it can.
+*/
+static char *lineReason(sourceLine *cur) {
+  if (cur->kind == OTHER_LINE) {
+    return "a .define, .entry or .extern line, or a line that is not an instruction or data";
+  }
+  if (cur->ends) {
+    return "a jump, rts or stop";
+  }
+  if (usesCode(cur)) {
+    return "an operand uses the address of an instruction";
+  }
+  return NULL;
+}
+
+/*
+  Accepts the index of the first removed line, the amount of removed lines and the new lines.
+  Returns why the edit can't be done incrementally, or NULL if it can.
+*/
+static char *editReason(int first, int removed, sourceLine fresh[], int count) {
+  char *why;
+  int i, j;
+
+  if (!built) {
+    return "the last build failed";
+  }
+  if (hasOption(OPTIMIZE_OPTION | DEAD_DATA_OPTION | POOL_STRINGS_OPTION)) {
+    return "--optimize, --dead-data and --pool-strings look at every line";
+  }
+
+  for (i = first; i < first + removed; i++) {
+    if ((why = lineReason(&lines[i])) != NULL) {
+      return why;
+    }
+  }
+  for (i = 0; i < count; i++) {
+    findReferences(&fresh[i]);
+    if ((why = lineReason(&fresh[i])) != NULL) {
+      return why;
+    }
+  }
+
+  for (i = first, j = 0;; i++, j++) { /* Compares the labels in their order */
+    for (; i < first + removed && lines[i].label == NULL; i++)
+      ;
+    for (; j < count && fresh[j].label == NULL; j++)
+      ;
+    if (i == first + removed || j == count) {
+      if (i != first + removed || j != count) {
+        return "a label was added or removed";
+      }
+      break;
+    }
+    if (strcmp(lines[i].label, fresh[j].label) != 0 || lines[i].kind != fresh[j].kind) {
+      return "a label was added, removed or moved";
+    }
+  }
+  return NULL;
+}
+
+/*
+  Accepts the index of the first removed line, the amount of removed lines and the new lines.
+  Frees the removed lines and puts the new lines in their place.
+*/
+static void replaceLines(int first, int removed, sourceLine fresh[], int count) {
+  int i;
+
+  for (i = first; i < first + removed; i++) {
+    free(lines[i].source);
+    free(lines[i].label);
+  }
+  if (lineCount - removed + count > lineCapacity) {
+    lineCapacity = lineCount - removed + count + LINES_CHUNK;
+    if ((lines = realloc(lines, sizeof(sourceLine) * lineCapacity)) == NULL) {
+      printf("Cannot allocate memory\n");
+      exit(0);
+    }
+  }
+  memmove(&lines[first + count], &lines[first + removed], sizeof(sourceLine) * (lineCount - first - removed));
+  memcpy(&lines[first], fresh, sizeof(sourceLine) * count);
+  lineCount += count - removed;
+}
+
+/*
+  Accepts the address where the removed instructions started, their words and the words of the new ones, the index in
+  the data table where the removed data started, its words and the words of the new data.
+  Moves the labels after the edited lines, the labels of the edited lines are set by placeLabels.
+*/
+static void moveLabels(int codeStart, int oldCode, int newCode, int dataStart, int oldData, int newData) {
+  symbolNodePtr node;
+
+  for (node = symbolHead; node != NULL; node = node->next) {
+    if (node->type == MACRO || node->type == EXTERNAL) {
+      continue;
+    }
+    if (node->val < MEMORY_BASE + codeWords) { /* A label of an instruction */
+      node->val += node->val >= codeStart + oldCode ? newCode - oldCode : 0;
+    } else if (node->val - MEMORY_BASE - codeWords >= dataStart + oldData) { /* A label of data after the edited lines */
+      node->val += newCode - oldCode + newData - oldData;
+    } else if (node->val - MEMORY_BASE - codeWords < dataStart) {
+      node->val += newCode - oldCode;
+    }
+  }
+}
+
+/*
+  Accepts the new lines after they were given their addresses and the amount of instruction words of the edited file.
+  Sets the labels of the new lines to their addresses.
+*/
+static void placeLabels(sourceLine fresh[], int count, int newCodeWords) {
+  int i;
+
+  for (i = 0; i < count; i++) {
+    if (fresh[i].label != NULL) {
+      symbolNodeByLabel(fresh[i].label)->val = fresh[i].kind == INSTRUCTION_LINE ? fresh[i].address :
+                                               MEMORY_BASE + newCodeWords + fresh[i].address;
+    }
+  }
+}
+
+/*
+  Accepts the index in the data table where the removed data started, its words and the words of the new data, the data
+  table of the new lines and the new lines.
+  Replaces the words of the removed data with the new words and moves the words after them.
+*/
+static void replaceData(int dataStart, int oldData, int newData, dataNodePtr added, sourceLine fresh[], int count) {
+  dataNodePtr *link = &dataHead, cur, rest;
+  int i;
+
+  while (*link != NULL && (*link)->index < dataStart) {
+    link = &(*link)->next;
+  }
+  while (*link != NULL && (*link)->index < dataStart + oldData) {
+    cur = *link;
+    *link = cur->next;
+    free(cur->label);
+    free(cur);
+  }
+
+  rest = *link;
+  for (i = 0, cur = added; i < count; i++) { /* Every node of a labelled line holds a copy of its label, see createData */
+    int j;
+
+    for (j = 0; j < fresh[i].dataWords; j++, cur = cur->next) {
+      cur->label = fresh[i].label != NULL ? copyString(fresh[i].label) : NULL;
+      *link = cur;
+      link = &cur->next;
+    }
+  }
+  *link = rest;
+
+  for (cur = rest; cur != NULL; cur = cur->next) {
+    cur->index += newData - oldData;
+  }
+  for (dataTail = dataHead; dataTail != NULL && dataTail->next != NULL; dataTail = dataTail->next)
+    ;
+}
+
+/*
+  Accepts the index of the first removed line, the amount of removed lines and the new lines, the edit can be done
+  incrementally.
+  Scans the new lines, moves the labels, the data and the lines after them and encodes the lines whose labels moved.
+  Returns a status wether the source compiled successfully.
+*/
+static int reassemble(int first, int removed, sourceLine fresh[], int count) {
+  dataNodePtr kept = dataHead, keptTail = dataTail, added;
+  int codeStart = MEMORY_BASE + codeWords, dataStart = dataWords, oldCode = 0, oldData = 0, newCode = 0, newData = 0,
+  address, mismatch = 0, i;
+
+  for (i = lineCount - 1; i >= first; i--) { /* Where the instructions and the data of the edited lines start */
+    codeStart = lines[i].kind == INSTRUCTION_LINE ? lines[i].address : codeStart;
+    dataStart = lines[i].kind == DATA_LINE ? lines[i].address : dataStart;
+  }
+  for (i = first; i < first + removed; i++) {
+    oldCode += lines[i].wordCount;
+    oldData += lines[i].dataWords;
+  }
+
+  error = OK; /* The first scan of the new lines, their data is added to a data table of their own */
+  scanCount = FIRST;
+  dataHead = NULL;
+  DC = dataStart;
+  for (i = 0, address = codeStart; i < count; i++) {
+    int overflow = setLine(fresh[i].source);
+
+    fresh[i].address = DC;
+    IC = address;
+    lineIndex = first + i;
+    scanLine(firstOfEdit, overflow);
+    fresh[i].dataWords = DC - fresh[i].address;
+    newData += fresh[i].dataWords;
+
+    if (fresh[i].kind == INSTRUCTION_LINE) {
+      fresh[i].wordCount = IC - address - foldedOperands(&fresh[i]); /* The words the second scan will encode */
+      fresh[i].address = address;
+      address = IC - foldedOperands(&fresh[i]);
+      newCode += fresh[i].wordCount;
+    }
+  }
+  added = dataHead;
+  dataHead = kept;
+  dataTail = keptTail;
+
+  if (error != OK || dataWords - oldData + newData >= MEMORY_SIZE) {
+    dataNodeFree(added);
+    replaceLines(first, removed, fresh, count);
+    if (error == OK) { /* The full build reports it */
+      reason = "the data no longer fits in the memory";
+      return incrementalRebuild();
+    }
+    built = 0;
+    printf("An error has been found on the first scan, failed to compile %s\n", sourceName);
+    return BAD_STATUS;
+  }
+
+  moveLabels(codeStart, oldCode, newCode, dataStart, oldData, newData);
+  codeWords += newCode - oldCode;
+  dataWords += newData - oldData;
+  placeLabels(fresh, count, codeWords);
+  replaceData(dataStart, oldData, newData, added, fresh, count);
+  replaceLines(first, removed, fresh, count);
+
+  for (i = first + count; i < lineCount; i++) {
+    lines[i].address += lines[i].kind == INSTRUCTION_LINE ? newCode - oldCode : 0;
+    lines[i].address += lines[i].kind == DATA_LINE ? newData - oldData : 0;
+  }
+
+  scanCount = SECOND; /* The second scan of the new lines and of the lines whose labels moved */
+  for (i = 0; i < lineCount; i++) {
+    if (lines[i].kind == INSTRUCTION_LINE && ((i >= first && i < first + count) || moved(&lines[i]))) {
+      int estimate = lines[i].wordCount;
+
+      encodeLine(&lines[i], i + 1);
+      mismatch |= lines[i].wordCount != estimate;
+    }
+  }
+  if (error == OK && mismatch) { /* The addresses given by the first scan are wrong */
+    reason = "an instruction was not encoded to the words the first scan counted";
+    return incrementalRebuild();
+  }
+  if (error != OK) {
+    built = 0;
+    printf("\nAn error has been found on second scan, failed to compile %s\n", sourceName);
+    return BAD_STATUS;
+  }
+
+  writeKept();
+  return OK_STATUS;
+}
+
+/*
+  Adds a line to the end of the source.
+*/
+static void appendLine(char *source) {
+  if (lineCount == lineCapacity) {
+    lineCapacity += LINES_CHUNK;
+    if ((lines = realloc(lines, sizeof(sourceLine) * lineCapacity)) == NULL) {
+      printf("Cannot allocate memory\n");
+      exit(0);
+    }
+  }
+  memset(&lines[lineCount], 0, sizeof(sourceLine));
+  lines[lineCount].source = copyString(source);
+  classify(&lines[lineCount++]);
+}
+
+/*
+  Accepts the name of a file without its extension.
+  Reads the .as file to memory and compiles it, keeping the results of every line.
+  Returns a status wether it compiled successfully.
+*/
+int incrementalOpen(char *name) {
+  char *fileExt = addExtension(name, ASSEMBLY_EXT), *text = NULL;
+  FILE *fp = openFile(fileExt, "r");
+  int ch, length = 0, capacity = 0;
+
+  free(fileExt);
+  if (fp == NULL) {
+    return BAD_STATUS;
+  }
+
+  sourceName = copyString(name);
+  while ((ch = getc(fp)) != EOF) { /* Splits the file to lines, a new line at the end of the file does not start another line */
+    if (length + 1 >= capacity) {
+      capacity += LINE_MAX;
+      if ((text = realloc(text, capacity)) == NULL) {
+        printf("Cannot allocate memory\n");
+        exit(0);
+      }
+    }
+    if (ch == '\n') {
+      text[length] = '\0';
+      appendLine(text);
+      length = 0;
+    } else {
+      text[length++] = ch;
+    }
+  }
+  if (length > 0) {
+    text[length] = '\0';
+    appendLine(text);
+  }
+  free(text);
+  fclose(fp);
+
+  return incrementalRebuild();
+}
+
+/*
+  Compiles the whole source the way the assembler compiles the file, keeping the results of every line.
+  Returns a status wether it compiled successfully.
+*/
+int incrementalRebuild() {
+  char *text;
+  size_t size = 0;
+  FILE *fp;
+  int i, status;
+
+  for (i = 0; i < lineCount; i++) {
+    size += strlen(lines[i].source) + 1;
+  }
+  if ((text = malloc(size + 1)) == NULL) {
+    printf("Cannot allocate memory\n");
+    exit(0);
+  }
+  for (i = 0, *text = '\0', size = 0; i < lineCount; i++) {
+    strcpy(text + size, lines[i].source);
+    size += strlen(lines[i].source);
+    text[size++] = '\n';
+  }
+
+  if ((fp = size > 0 ? fmemopen(text, size, "r") : tmpfile()) == NULL) {
+    printf("Cannot allocate memory\n");
+    exit(0);
+  }
+
+  for (i = 0; i < lineCount; i++) {
+    lines[i].wordCount = lines[i].dataWords = lines[i].relocationCount = lines[i].externalCount = 0;
+    lines[i].referenceCount = 0;
+  }
+  firstScanned = secondScanned = 0;
+  lineIndex = 0;
+  status = compileSource(sourceName, fp, firstOfBuild, secondOfBuild);
+  fclose(fp);
+  free(text);
+
+  built = status == OK_STATUS;
+  for (i = 0, codeWords = 0; i < lineCount; i++) {
+    codeWords += lines[i].wordCount;
+  }
+  dataWords = DC;
+  return status;
+}
+
+/*
+  Accepts the number of the first line to replace(counted from 1), the amount of lines to replace and the new lines
+  without their new lines and their amount. Lines are inserted before the first line when none are replaced.
+  Edits the source and reassembles it incrementally when it can, otherwise compiles the whole source again.
+  Returns a status wether it compiled successfully.
+*/
+int incrementalEdit(int first, int removed, char *texts[], int count) {
+  sourceLine *fresh;
+  int i;
+
+  reason = NULL;
+  if (first < 1 || removed < 0 || first - 1 + removed > lineCount) {
+    printf("Lines %d to %d are not in the source\n", first, first + removed - 1);
+    return BAD_STATUS;
+  }
+  if ((fresh = calloc(count + 1, sizeof(sourceLine))) == NULL) {
+    printf("Cannot allocate memory\n");
+    exit(0);
+  }
+  for (i = 0; i < count; i++) {
+    fresh[i].source = copyString(texts[i]);
+    classify(&fresh[i]);
+  }
+
+  reason = editReason(first - 1, removed, fresh, count);
+  if (reason == NULL) {
+    i = reassemble(first - 1, removed, fresh, count);
+  } else {
+    replaceLines(first - 1, removed, fresh, count);
+    i = incrementalRebuild();
+  }
+  free(fresh);
+  return i;
+}
+
+/*
+  Returns why the last edit compiled the whole source again, NULL if it was done incrementally.
+*/
+char *incrementalReason() {
+  return reason;
+}
+
+/*
+  Returns the amount of lines of the source.
+*/
+int incrementalLineCount() {
+  return lineCount;
+}
+
+/*
+  Accepts the number of a line(counted from 1) and returns it without its new line, NULL if there is no such line.
+*/
+char *incrementalLine(int number) {
+  return number >= 1 && number <= lineCount ? lines[number - 1].source : NULL;
+}
+
+/*
+  Writes the source back to its .as file.
+  Returns a status wether it was written.
+*/
+int incrementalSave() {
+  char *fileExt = addExtension(sourceName, ASSEMBLY_EXT);
+  FILE *fp = openFile(fileExt, "w");
+  int i;
+
+  free(fileExt);
+  if (fp == NULL) {
+    return BAD_STATUS;
+  }
+  for (i = 0; i < lineCount; i++) {
+    fprintf(fp, "%s\n", lines[i].source);
+  }
+  fclose(fp);
+  return OK_STATUS;
+}
+
+/*
+  Frees the source and the results of its lines.
+*/
+void incrementalClose() {
+  int i;
+
+  for (i = 0; i < lineCount; i++) {
+    free(lines[i].source);
+    free(lines[i].label);
+  }
+  free(lines);
+  free(sourceName);
+  lines = NULL;
+  sourceName = NULL;
+  lineCount = lineCapacity = built = 0;
+}
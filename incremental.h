@@ -0,0 +1,36 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+/*
+  Incremental reassembly of a single source file that is edited line by line, used by 'obinc'.
+  The source is kept in memory and the first build compiles all of it the way the assembler does(see compile.h), keeping
+  for every line its kind, its label, its address, the words the second scan encoded for it, its uses of externals and
+  relocatable words, and the labels its operands use with the addresses they had.
+
+  An edit replaces a range of lines with new ones. When it can be done incrementally only the new lines are scanned:
+  the first scan validates them and parses their data, the second scan encodes their instructions. The labels after
+  the range are moved by the words the range gained or lost(the instruction words, and the data words for the labels
+  of the data), the words of the data table after the range are moved the same way and every other line is encoded
+  again only if a label its operands use has moved. The outputs are then written again from the kept words of every
+  line, so they are the same as the outputs of a clean build of the edited source. Diagnostics are only printed for
+  the lines that were scanned.
+
+  An edit is done by compiling the whole source again when anything outside of the range could be affected:
+  - The last build failed, or --optimize(with its control flow analysis), --dead-data or --pool-strings were given(they
+    look at every line).
+  - A removed or a new line is a .define, .entry or .extern line, a jump(jmp, bne, jsr), rts or stop, an instruction
+    that uses the address of an instruction as data, or a line the first scan would reject before parsing it.
+  - The labels of the removed lines and the new lines are not the same labels of the same kind in the same order.
+  - The data no longer fits in the memory.
+*/
+
+int incrementalOpen(char *name); /* Reads NAME.as and compiles it, returns a status wether it compiled successfully */
+int incrementalEdit(int first, int removed, char *texts[], int count); /* Replaces lines of the source with new ones and reassembles it, returns a status wether it compiled successfully */
+int incrementalRebuild(void); /* Compiles the whole source again, returns a status wether it compiled successfully */
+char *incrementalReason(void); /* Returns why the last edit compiled the whole source again, NULL if it was incremental */
+int incrementalLineCount(void); /* Returns the amount of lines of the source */
+char *incrementalLine(int number); /* Returns a line of the source(counted from 1) without its new line */
+int incrementalSave(void); /* Writes the source back to NAME.as, returns a status */
+void incrementalClose(void); /* Frees the source and the results of its lines */
+
+#endif
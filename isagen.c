@@ -0,0 +1,660 @@
+/*
+  Generator of the instruction set tables.
+  Reads the description of the instruction set(see commands.isa) and writes a header and a source of generated C:
+  the fields of the words, enum ADDRESS_MODE and enum COMMAND_FLAG in the header, and in the source the commands table
+  with a bitmask of the address modes each operand accepts and of those it accepts only for compatibility, the amount
+  of words of each address mode, getCommand with a perfect hash of the names, getCommandByOpcode and decodeCommandWord
+  with a table of every instruction word.
+  The description is checked before anything is written, so two commands with the same opcode, an unknown address mode
+  or fields that cannot hold the codes are errors of the build and not of the passes.
+
+  USAGE:
+  isagen DESCRIPTION PREFIX
+  eg: isagen commands.isa isa
+  Writes isa.h and isa.c, the makefile runs it when the description changes.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define MAX_LINE 256 /* The maximum length of a line of the description */
+#define MAX_NAME 32 /* The maximum length of a name in the description */
+#define MAX_ITEMS 16 /* The maximum amount of fields, address modes and flags */
+#define MAX_COMMANDS 64
+#define MAX_OPERANDS 2
+#define MAX_HASH 256 /* The largest table the perfect hash of the names is searched in */
+#define MAX_MULTIPLIER 64 /* The multipliers of the first two characters of a name are searched up to it */
+#define ENTRIES_PER_LINE 8 /* The entries of a generated table in a line */
+
+typedef struct isaField { /* A field of a word */
+  char name[MAX_NAME];
+  int shift, width;
+} isaField;
+
+typedef struct isaMode { /* An address mode */
+  char name[MAX_NAME];
+  int code, words, shared;
+} isaMode;
+
+typedef struct isaCommand {
+  char name[MAX_NAME];
+  int opcode, args,
+      modes[MAX_OPERANDS], /* A bit for the code of each address mode the operand accepts */
+      compat[MAX_OPERANDS], /* The bits of the modes the operand accepts only for compatibility */
+      flags;
+} isaCommand;
+
+static isaField fields[MAX_ITEMS];
+static int fieldCount;
+static isaMode modes[MAX_ITEMS];
+static int modeCount;
+static char flags[MAX_ITEMS][MAX_NAME];
+static int flagCount;
+static isaCommand commands[MAX_COMMANDS];
+static int commandCount;
+
+static char *description; /* The name of the description and the current line in it, for the messages */
+static int lineNumber;
+static int errors;
+
+static int hashSize, hashFirst, hashSecond; /* The perfect hash that was found, see findHash */
+static unsigned char *decodings; /* 4 bytes for each instruction word >> decodeShift, see buildDecodings */
+static int decodeShift, decodeSize;
+static char headerName[MAX_LINE]; /* The name of the header the source includes */
+
+/*
+  Prints an error of the current line of the description, or of the whole of it when lineNumber is 0.
+*/
+static void error(char *message, char *word) {
+  if (lineNumber > 0) {
+    printf("%s:%d: %s %s\n", description, lineNumber, message, word);
+  } else { /* Not of a single line */
+    printf("%s: %s %s\n", description, message, word);
+  }
+  errors++;
+}
+
+/*
+  Accepts a string.
+  Returns wether it is a C identifier that fits in a name.
+*/
+static int validName(char *word) {
+  if (strlen(word) >= MAX_NAME || !(isalpha((unsigned char) *word) || *word == '_')) {
+    return 0;
+  }
+  for (; *word != '\0'; word++) {
+    if (!isalnum((unsigned char) *word) && *word != '_') {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/*
+  Accepts a string.
+  Returns the number it holds, or -1 if it is not a non-negative number.
+*/
+static int number(char *word) {
+  char *end;
+  long val = word == NULL ? -1 : strtol(word, &end, 10);
+
+  return word == NULL || *word == '\0' || *end != '\0' || val < 0 || val > 0xffff ? -1 : (int) val;
+}
+
+/*
+  Returns the field with a name, or NULL.
+*/
+static isaField *findField(char *name) {
+  int i;
+
+  for (i = 0; i < fieldCount; i++) {
+    if (strcmp(fields[i].name, name) == 0) {
+      return &fields[i];
+    }
+  }
+  return NULL;
+}
+
+/*
+  Returns the index of the address mode or of the flag with a name, or -1.
+*/
+static int findMode(char *name) {
+  int i;
+
+  for (i = 0; i < modeCount && strcmp(modes[i].name, name) != 0; i++)
+    ;
+  return i < modeCount ? i : -1;
+}
+
+static int findFlag(char *name) {
+  int i;
+
+  for (i = 0; i < flagCount && strcmp(flags[i], name) != 0; i++)
+    ;
+  return i < flagCount ? i : -1;
+}
+
+/*
+  Accepts the operand of a command in the description, '*' or address modes separated by '|', and where to store the
+  modes that are marked with a '?'.
+  Returns a bit for the code of each of the modes, or -1 if one is unknown.
+*/
+static int modeMask(char *operand, int *compat) {
+  char *name;
+  int mask = 0, i, marked;
+
+  *compat = 0;
+  if (strcmp(operand, "*") == 0) {
+    return (1 << modeCount) - 1;
+  }
+  for (name = strtok(operand, "|"); name != NULL; name = strtok(NULL, "|")) {
+    if ((marked = *name != '\0' && name[strlen(name) - 1] == '?')) {
+      name[strlen(name) - 1] = '\0';
+    }
+    if ((i = findMode(name)) < 0) {
+      error("Unknown address mode", name);
+      return -1;
+    }
+    mask |= 1 << modes[i].code;
+    *compat |= marked << modes[i].code;
+  }
+  return mask;
+}
+
+/*
+  Accepts the words of a line of the description and their amount.
+  Adds what the line describes.
+*/
+static void parseLine(char *words[], int count) {
+  if (strcmp(words[0], "field") == 0 && count == 4) {
+    isaField *field = &fields[fieldCount];
+
+    if (fieldCount == MAX_ITEMS || !validName(words[1]) || findField(words[1]) != NULL) {
+      error("Invalid field", words[1]);
+      return;
+    }
+    strcpy(field->name, words[1]);
+    if ((field->shift = number(words[2])) < 0 || (field->width = number(words[3])) <= 0 || field->shift > 30 ||
+        field->width > 30) {
+      error("Invalid shift or width of the field", words[1]);
+    }
+    fieldCount++;
+  } else if (strcmp(words[0], "mode") == 0 && (count == 4 || (count == 5 && strcmp(words[4], "shared") == 0))) {
+    isaMode *mode = &modes[modeCount];
+
+    if (modeCount == MAX_ITEMS || !validName(words[1]) || findMode(words[1]) >= 0) {
+      error("Invalid address mode", words[1]);
+      return;
+    }
+    strcpy(mode->name, words[1]);
+    if ((mode->code = number(words[2])) < 0 || mode->code >= MAX_ITEMS || (mode->words = number(words[3])) < 0) {
+      error("Invalid code or amount of words of the address mode", words[1]);
+    }
+    mode->shared = count == 5;
+    modeCount++;
+  } else if (strcmp(words[0], "flag") == 0 && count == 2) {
+    if (flagCount == MAX_ITEMS || !validName(words[1]) || findFlag(words[1]) >= 0) {
+      error("Invalid flag", words[1]);
+      return;
+    }
+    strcpy(flags[flagCount++], words[1]);
+  } else if (strcmp(words[0], "command") == 0 && count >= 3) {
+    isaCommand *comm = &commands[commandCount];
+    int i = 3, k;
+
+    if (commandCount == MAX_COMMANDS || !validName(words[1])) {
+      error("Invalid command", words[1]);
+      return;
+    }
+    for (k = 0; k < commandCount; k++) {
+      if (strcmp(commands[k].name, words[1]) == 0) {
+        error("The command is described twice:", words[1]);
+        return;
+      }
+    }
+    memset(comm, 0, sizeof(isaCommand));
+    strcpy(comm->name, words[1]);
+    if ((comm->opcode = number(words[2])) < 0) {
+      error("Invalid opcode of the command", words[1]);
+    }
+    for (; i < count && strcmp(words[i], ":") != 0; i++) {
+      if (comm->args == MAX_OPERANDS) {
+        error("Too many operands for the command", words[1]);
+        break;
+      }
+      if ((comm->modes[comm->args] = modeMask(words[i], &comm->compat[comm->args])) == 0) {
+        error("An operand accepts no address mode in the command", words[1]);
+      } else if (comm->compat[comm->args] == comm->modes[comm->args]) {
+        error("An operand accepts only modes kept for compatibility in the command", words[1]);
+      }
+      comm->args++;
+    }
+    for (i++; i < count; i++) {
+      if ((k = findFlag(words[i])) < 0) {
+        error("Unknown flag", words[i]);
+      } else {
+        comm->flags |= 1 << k;
+      }
+    }
+    commandCount++;
+  } else {
+    error("Invalid line, expected a field, a mode, a flag or a command:", words[0]);
+  }
+}
+
+/*
+  Accepts the open description.
+  Reads every line and splits it to words, a '#' starts a comment.
+*/
+static void parse(FILE *fp) {
+  char line[MAX_LINE + 2], *words[MAX_LINE], *word;
+  int count;
+
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    lineNumber++;
+    if (strchr(line, '\n') == NULL && !feof(fp)) {
+      error("The line is too long, the maximum is", "256");
+      return;
+    }
+    if ((word = strchr(line, '#')) != NULL) {
+      *word = '\0';
+    }
+    for (count = 0, word = strtok(line, " \t\r\n"); word != NULL; word = strtok(NULL, " \t\r\n")) {
+      words[count++] = word;
+    }
+    if (count > 0) {
+      parseLine(words, count);
+    }
+  }
+}
+
+/*
+  Checks what the lines can't check alone: the required fields, that the codes of the address modes are 0 to their
+  amount - 1 and fit in the mode fields, and that the opcodes are different and fit in their field.
+*/
+static void validate(void) {
+  isaField *opcode = findField("OPCODE"), *destination = findField("DESTINATION"), *source = findField("SOURCE");
+  int i, k;
+
+  lineNumber = 0;
+  if (opcode == NULL || destination == NULL || source == NULL) {
+    error("The OPCODE, DESTINATION and SOURCE fields are required, found", opcode == NULL ? "no OPCODE" :
+          destination == NULL ? "no DESTINATION" : "no SOURCE");
+    return;
+  }
+  if (modeCount == 0 || commandCount == 0) {
+    error("No address modes or commands were described", "");
+    return;
+  }
+  if (opcode->shift + opcode->width > 16 || opcode->width > 8 || destination->width != source->width ||
+      1 << destination->width < modeCount) {
+    error("The fields of the instruction word cannot hold the opcodes and the address modes", "");
+  }
+  for (i = 0; i < modeCount; i++) {
+    for (k = 0; k < modeCount && modes[k].code != i; k++)
+      ;
+    if (k == modeCount) {
+      error("The codes of the address modes must be 0 to their amount - 1, there is no mode with the code",
+            modes[i].name);
+    }
+  }
+  for (i = 0; i < commandCount; i++) {
+    if (commands[i].opcode >= 1 << opcode->width) {
+      error("The opcode doesn't fit in its field in the command", commands[i].name);
+    }
+    for (k = 0; k < i; k++) {
+      if (commands[k].opcode == commands[i].opcode) {
+        error("Two commands have the same opcode:", commands[i].name);
+      }
+    }
+  }
+}
+
+/*
+  Accepts a name.
+  Returns its hash with the current multipliers and table size, the characters that are read are those the generated
+  getCommand reads.
+*/
+static int hashName(char *name) {
+  int length = strlen(name);
+
+  return (hashFirst * (unsigned char) name[0] + hashSecond * (unsigned char) name[1] +
+          (unsigned char) name[length - 1] + length) & (hashSize - 1);
+}
+
+/*
+  Searches for a perfect hash of the names of the commands: the smallest table(a power of 2) and the multipliers of
+  the first two characters with which no two names have the same hash.
+  Returns wether one was found.
+*/
+static int findHash(void) {
+  char used[MAX_HASH];
+  int i;
+
+  for (hashSize = 1; hashSize < commandCount; hashSize *= 2)
+    ;
+  for (; hashSize <= MAX_HASH; hashSize *= 2) {
+    for (hashFirst = 1; hashFirst <= MAX_MULTIPLIER; hashFirst++) {
+      for (hashSecond = 0; hashSecond <= MAX_MULTIPLIER; hashSecond++) {
+        memset(used, 0, sizeof(used));
+        for (i = 0; i < commandCount && !used[hashName(commands[i].name)]; i++) {
+          used[hashName(commands[i].name)] = 1;
+        }
+        if (i == commandCount) {
+          return 1;
+        }
+      }
+    }
+  }
+  return 0;
+}
+
+/*
+  Accepts a bitmask of address modes.
+  Writes it as an expression of the names of the modes.
+*/
+static void writeMask(FILE *fp, int mask) {
+  int i, first = 1;
+
+  if (mask == 0) {
+    fprintf(fp, "0");
+  }
+  for (i = 0; i < modeCount; i++) {
+    if (mask & (1 << modes[i].code)) {
+      fprintf(fp, "%s(1 << %s)", first ? "" : " | ", modes[i].name);
+      first = 0;
+    }
+  }
+}
+
+/*
+  Writes the header: the fields, the amounts, enum ADDRESS_MODE, enum COMMAND_FLAG and the tables the source exports.
+*/
+static void writeHeader(FILE *fp) {
+  int i, k, words, maxWords = 0, mask;
+
+  for (i = 0; i < commandCount; i++) { /* The most words an instruction can take */
+    for (k = 0, words = 1; k < commands[i].args; k++) {
+      int most = 0, m;
+
+      for (m = 0, mask = commands[i].modes[k]; m < modeCount; m++) {
+        if ((mask & (1 << modes[m].code)) && modes[m].words > most) {
+          most = modes[m].words;
+        }
+      }
+      words += most;
+    }
+    if (words > maxWords) {
+      maxWords = words;
+    }
+  }
+
+  fprintf(fp, "/*\n  Generated by isagen from %s, do not edit, the instruction set is described there.\n*/\n", description);
+  fprintf(fp, "#ifndef ISA_H\n#define ISA_H\n\n");
+  for (i = 0; i < fieldCount; i++) {
+    fprintf(fp, "#define %s_DIST %d\n#define %s_WIDTH %d\n", fields[i].name, fields[i].shift, fields[i].name,
+            fields[i].width);
+  }
+  fprintf(fp, "\n#define MAX_ADDRESS_MODE %d /* The amount of address modes */\n", modeCount);
+  fprintf(fp, "#define COMMAND_COUNT %d\n", commandCount);
+  fprintf(fp, "#define MAX_WORDS %d /* The most words an instruction can take */\n\n", maxWords);
+
+  fprintf(fp, "enum ADDRESS_MODE /* The address modes, their values are their codes in the instruction word */\n{\n");
+  for (i = 0; i < modeCount; i++) {
+    for (k = 0; modes[k].code != i; k++)
+      ;
+    fprintf(fp, "  %s = %d%s\n", modes[k].name, i, i + 1 < modeCount ? "," : "");
+  }
+  fprintf(fp, "};\n\nenum COMMAND_FLAG /* The properties of the commands, bits of their flags */\n{\n");
+  for (i = 0; i < flagCount; i++) {
+    fprintf(fp, "  %s = %d%s\n", flags[i], 1 << i, i + 1 < flagCount ? "," : "");
+  }
+  if (flagCount == 0) {
+    fprintf(fp, "  NO_COMMAND_FLAGS = 0\n");
+  }
+  fprintf(fp, "};\n\nextern int modeWords[MAX_ADDRESS_MODE]; /* The amount of operand words of each address mode */\n");
+  fprintf(fp, "\n#endif\n");
+}
+
+/*
+  Accepts a command and the codes of the address modes of its operands.
+  Returns the instruction word they are encoded to, the way handleSecondCommand encodes it.
+*/
+static int encode(isaCommand *comm, int first, int second) {
+  int word = comm->opcode << findField("OPCODE")->shift;
+
+  if (comm->args == 1) { /* A single operand is encoded in the field of the second */
+    word |= first << findField("SOURCE")->shift;
+  } else if (comm->args == 2) {
+    word |= first << findField("DESTINATION")->shift | second << findField("SOURCE")->shift;
+  }
+  return word;
+}
+
+/*
+  Accepts the codes of the address modes of the operands of a command and their amount.
+  Returns the amount of words of the instruction.
+*/
+static int instructionWords(int mode[], int args) {
+  int words = 1, k, m, shared = 0;
+
+  for (k = 0; k < args; k++) {
+    for (m = 0; modes[m].code != mode[k]; m++)
+      ;
+    words += modes[m].words;
+    if (modes[m].shared && shared++ > 0) { /* Shares the word of the first */
+      words -= modes[m].words;
+    }
+  }
+  return words;
+}
+
+/*
+  Fills the decoding of every instruction word that encodes a command with address modes it accepts: the index of the
+  command + 1(0 for the words that aren't valid), the amount of words of the instruction and the modes of the operands.
+  The words are indexed from the lowest mode field, the bits below it are 0 in every instruction word.
+*/
+static void buildDecodings(void) {
+  isaField *opcode = findField("OPCODE"), *destination = findField("DESTINATION"), *source = findField("SOURCE");
+  int i, k, c, combos, mode[MAX_OPERANDS];
+
+  decodeShift = destination->shift < source->shift ? destination->shift : source->shift;
+  decodeSize = 1 << (opcode->shift + opcode->width - decodeShift);
+  if ((decodings = calloc(decodeSize, 4)) == NULL) {
+    printf("Cannot allocate memory\n");
+    exit(1);
+  }
+
+  for (i = 0; i < commandCount; i++) { /* Every combination of the modes the operands accept */
+    combos = 1;
+    for (k = 0; k < commands[i].args; k++) {
+      combos *= modeCount;
+    }
+    for (c = 0; c < combos; c++) {
+      int rest = c, word, valid = 1;
+      unsigned char *entry;
+
+      for (k = 0; k < MAX_OPERANDS; k++) {
+        mode[k] = k < commands[i].args ? rest % modeCount : 0;
+        rest /= modeCount;
+        valid = valid && (k >= commands[i].args || (commands[i].modes[k] & (1 << mode[k])));
+      }
+      if (!valid) {
+        continue;
+      }
+      word = encode(&commands[i], mode[0], mode[1]);
+      entry = decodings + 4 * (word >> decodeShift);
+      if (entry[0] != 0) {
+        error("The fields of the instruction word overlap, two instructions are encoded the same in the command",
+              commands[i].name);
+        return;
+      }
+      entry[0] = i + 1;
+      entry[1] = instructionWords(mode, commands[i].args);
+      entry[2] = mode[0];
+      entry[3] = mode[1];
+    }
+  }
+}
+
+/*
+  Writes the source: the commands table, the words of the address modes, the perfect hash lookup, the opcode table and
+  the decoding of every instruction word.
+*/
+static void writeSource(FILE *fp) {
+  int i, k, c, minLength = MAX_NAME, maxLength = 0, length;
+  unsigned char hash[MAX_HASH], byOpcode[MAX_HASH];
+
+  fprintf(fp, "/*\n  Generated by isagen from %s, do not edit, the instruction set is described there.\n*/\n", description);
+  fprintf(fp, "#include <string.h>\n#include \"./%s\"\n#include \"./command.h\"\n#include \"./commandUtils.h\"\n"
+          "#include \"./profile.h\"\n\n", headerName);
+
+  fprintf(fp, "#define DECODE_DIST %d /* The instruction words are decoded by their bits from it */\n\n", decodeShift);
+  fprintf(fp, "typedef struct isaDecoding { /* The decoding of an instruction word */\n"
+          "  unsigned char command, /* The index of the command in the commands table + 1, 0 if the word is not valid */\n"
+          "  length, /* The amount of words of the instruction */\n"
+          "  modes[2]; /* The address mode of each operand */\n} isaDecoding;\n\n");
+
+  fprintf(fp, "/*\n  The commands, the address modes each operand accepts(the first operand is validated against dest and the\n"
+          "  second against src, see valAddressMode), their flags and the modes of each operand that are accepted only for\n"
+          "  compatibility.\n*/\nstatic command commands[COMMAND_COUNT] = {\n");
+  for (i = 0; i < commandCount; i++) {
+    fprintf(fp, "  { \"%s\", %d, %d, ", commands[i].name, commands[i].opcode, commands[i].args);
+    writeMask(fp, commands[i].modes[0]);
+    fprintf(fp, ", ");
+    writeMask(fp, commands[i].modes[1]);
+    fprintf(fp, ", ");
+    for (k = 0, c = 0; k < flagCount; k++) {
+      if (commands[i].flags & (1 << k)) {
+        fprintf(fp, "%s%s", c++ ? " | " : "", flags[k]);
+      }
+    }
+    fprintf(fp, "%s, ", c ? "" : "0");
+    writeMask(fp, commands[i].compat[0]);
+    fprintf(fp, ", ");
+    writeMask(fp, commands[i].compat[1]);
+    fprintf(fp, " }%s\n", i + 1 < commandCount ? "," : "");
+  }
+  fprintf(fp, "};\n\nint modeWords[MAX_ADDRESS_MODE] = {");
+  for (i = 0; i < modeCount; i++) {
+    for (k = 0; modes[k].code != i; k++)
+      ;
+    fprintf(fp, "%s%d", i ? ", " : " ", modes[k].words);
+  }
+  fprintf(fp, " };\n\n");
+
+  memset(hash, 0, sizeof(hash));
+  memset(byOpcode, 0, sizeof(byOpcode));
+  for (i = 0; i < commandCount; i++) {
+    hash[hashName(commands[i].name)] = i + 1;
+    byOpcode[commands[i].opcode] = i + 1;
+    length = strlen(commands[i].name);
+    minLength = length < minLength ? length : minLength;
+    maxLength = length > maxLength ? length : maxLength;
+  }
+  fprintf(fp, "static unsigned char commandHash[%d] = { /* The index of the command + 1 at the hash of its name */", hashSize);
+  for (i = 0; i < hashSize; i++) {
+    fprintf(fp, "%s%d%s", i % (ENTRIES_PER_LINE * 2) ? " " : "\n  ", hash[i], i + 1 < hashSize ? "," : "");
+  }
+  fprintf(fp, "\n};\n\nstatic unsigned char opcodeCommands[1 << OPCODE_WIDTH] = { /* The index of the command + 1 of each opcode */");
+  for (i = 0; i < 1 << findField("OPCODE")->width; i++) {
+    fprintf(fp, "%s%d%s", i % (ENTRIES_PER_LINE * 2) ? " " : "\n  ", byOpcode[i],
+            i + 1 < 1 << findField("OPCODE")->width ? "," : "");
+  }
+  fprintf(fp, "\n};\n\n");
+
+  fprintf(fp, "static isaDecoding decodings[%d] = { /* The instruction word >> DECODE_DIST */", decodeSize);
+  for (i = 0; i < decodeSize; i++) {
+    unsigned char *entry = decodings + 4 * i;
+
+    fprintf(fp, "%s{ %d, %d, { %d, %d } }%s", i % ENTRIES_PER_LINE ? " " : "\n  ", entry[0], entry[1], entry[2],
+            entry[3], i + 1 < decodeSize ? "," : "");
+  }
+  fprintf(fp, "\n};\n\n");
+
+  fprintf(fp, "/*\n  Takes a string of a name of a command and returns a pointer to a struct of that command with data about it\n"
+          "  from the commands array, the name is found by a perfect hash of its length and its first, second and last\n"
+          "  characters.\n  If the command is not present in the array returns NULL.\n*/\n");
+  fprintf(fp, "commandPtr getCommand(char *commandName) {\n  size_t length = strlen(commandName);\n  int i;\n\n"
+          "  profileCount(COMMAND_LOOKUPS, 1);\n\n  if (length < %d || length > %d) {\n    return NULL;\n  }\n",
+          minLength, maxLength);
+  fprintf(fp, "  i = commandHash[(%d * (unsigned char) commandName[0] + %d * (unsigned char) commandName[1] +\n"
+          "                  (unsigned char) commandName[length - 1] + length) & %d];\n", hashFirst, hashSecond,
+          hashSize - 1);
+  fprintf(fp, "  return i != 0 && strcmp(commandName, commands[i - 1].name) == 0 ? &commands[i - 1] : NULL;\n}\n\n");
+
+  fprintf(fp, "/*\n  Takes an opcode and returns a pointer to the struct of the command with that opcode from the commands array.\n"
+          "  If no command has the opcode returns NULL.\n*/\n");
+  fprintf(fp, "commandPtr getCommandByOpcode(int opcode) {\n"
+          "  if (opcode < 0 || opcode >= 1 << OPCODE_WIDTH || opcodeCommands[opcode] == 0) {\n    return NULL;\n  }\n"
+          "  return &commands[opcodeCommands[opcode] - 1];\n}\n\n");
+
+  fprintf(fp, "/*\n  Takes an instruction word and an array for the address modes of its operands.\n"
+          "  The decoding of every word that encodes a command with address modes it accepts is in the decodings table.\n"
+          "  Returns the command and stores the amount of words of the instruction in length, or returns NULL if the word is not\n"
+          "  a valid instruction word.\n*/\n");
+  fprintf(fp, "commandPtr decodeCommandWord(int word, int modes[], int *length) {\n  isaDecoding *d;\n  int i;\n\n"
+          "  if (word < 0 || word >= 1 << (OPCODE_DIST + OPCODE_WIDTH) || (word & ((1 << DECODE_DIST) - 1)) != 0 ||\n"
+          "      (d = &decodings[word >> DECODE_DIST])->command == 0) {\n    return NULL;\n  }\n\n"
+          "  for (i = 0; i < commands[d->command - 1].args; i++) {\n    modes[i] = d->modes[i];\n  }\n"
+          "  *length = d->length;\n  return &commands[d->command - 1];\n}\n");
+}
+
+/*
+  Accepts the prefix and the extension of a file and the function that writes its content.
+  Writes the file, returns wether it was written.
+*/
+static int writeFile(char *prefix, char *ext, void (*write)(FILE *)) {
+  char file[MAX_LINE];
+  FILE *fp;
+
+  sprintf(file, "%s%s", prefix, ext);
+  if ((fp = fopen(file, "w")) == NULL) {
+    printf("Cannot write to file %s\n", file);
+    return 0;
+  }
+  write(fp);
+  if (fclose(fp) != 0) {
+    printf("Cannot write to file %s\n", file);
+    return 0;
+  }
+  return 1;
+}
+
+int main(int argc, char *argv[]) {
+  FILE *fp;
+
+  if (argc != 3 || strlen(argv[2]) + 3 > MAX_LINE) {
+    printf("USAGE: isagen DESCRIPTION PREFIX\n");
+    return 1;
+  }
+  description = argv[1];
+  if ((fp = fopen(description, "r")) == NULL) {
+    printf("Cannot open file %s\n", description);
+    return 1;
+  }
+  parse(fp);
+  fclose(fp);
+  if (errors == 0) {
+    validate();
+  }
+  if (errors == 0 && !findHash()) {
+    lineNumber = 0;
+    error("No perfect hash of the names of the commands was found", "");
+  }
+  if (errors == 0) {
+    buildDecodings();
+  }
+  if (errors > 0) {
+    printf("%d errors in %s, nothing was generated\n", errors, description);
+    return 1;
+  }
+
+  sprintf(headerName, "%s.h", strrchr(argv[2], '/') == NULL ? argv[2] : strrchr(argv[2], '/') + 1);
+  if (!writeFile(argv[2], ".h", writeHeader) || !writeFile(argv[2], ".c", writeSource)) {
+    return 1;
+  }
+  free(decodings);
+  return 0;
+}
@@ -0,0 +1,447 @@
+/*
+  Microbenchmarks for the functions that run once per source code line or per operand.
+  Each benchmark is run for a few warm-up samples that are discarded, and then for a number of samples
+  where each sample times a batch of calls. The time per call is reported as mean, standard deviation,
+  minimum and median over the samples.
+  Inputs that the functions mutate are prepared before each sample and are not part of the measured time.
+
+  USAGE:
+  microbench [samples]
+  To create the program use 'make microbench'.
+*/
+#define _POSIX_C_SOURCE 199309L /* Required for clock_gettime */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "./data.h"
+#include "./utils.h"
+#include "./strings.h"
+#include "./files.h"
+#include "./commandUtils.h"
+#include "./structural.h"
+
+#define WARMUP 5 /* The amount of samples that are discarded before measuring */
+#define SAMPLES 30 /* The default amount of measured samples */
+#define BATCH 1000 /* The amount of calls in each sample */
+#define LABELS 64 /* The amount of different labels that are looked up in the symbol table benchmarks */
+#define VERIFY_LENGTH 300 /* Random buffers of every length up to this one are used to verify the vectorized structural index */
+#define VERIFY_ROUNDS 20 /* The amount of random buffers of each length */
+
+void writeLine(FILE *fp, int line); /* Defined in files.c, its prototype is private to that file */
+
+typedef struct benchmark { /* A single benchmark */
+  char *name;
+  void (*prepare)(void); /* Called before each sample, not measured, may be NULL */
+  void (*body)(int i); /* Called BATCH times in each sample with the index of the call */
+} benchmark;
+
+static char buffers[BATCH][LINE_MAX]; /* Copies of source code lines for the functions that mutate their input */
+static char labels[LABELS][LINE_MAX]; /* Labels that exist in the symbol table */
+static char *args[] = { "#-5", "#sz", "r3", "LIST[sz]", "STR[5]", "LOOP", "r12", "#1024" };
+static char *commandNames[] = { "mov", "cmp", "lea", "jmp", "prn", "stop", "rts", "foo" };
+static char *corpusLines[] = { /* Lines of the shapes corpusgen writes and lines with errors, to verify the tokenizer */
+  "MAIN: mov STR[5], LIST[sz] ; a comment\n", " r3 , LIST[sz]\n", "L12: cmp #-5, D3[M2]\n", " prn #M1\n",
+  "D0: .data 1, -2, 3,4\n", "S1: .string \"a, b [c]\"\n", " jsr X2\n", "\tstop\n", " mov r1,,r2\n", " add r1 r2\n",
+  " sub r1, r2,\n", ",r1\n", "", " \t\r\v\f\n"
+};
+static FILE *devNull;
+static int samples = SAMPLES, dataSize;
+static dataNodePtr dataEnd; /* The last node of the data table after it was built to dataSize */
+volatile long sink; /* Results are accumulated here so the calls are not optimized away */
+
+/*
+  Returns the current time in nanoseconds.
+*/
+static double now() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int compareDoubles(const void *a, const void *b) {
+  double x = *(double *) a, y = *(double *) b;
+
+  return x < y ? -1 : x > y;
+}
+
+/*
+  Runs a single benchmark and prints the time per call.
+*/
+static void run(benchmark *bench) {
+  double *times = malloc(sizeof(double) * samples), sum = 0, var = 0, mean;
+  int s, i;
+
+  if (times == NULL) {
+    printf("Cannot allocate memory\n");
+    exit(1);
+  }
+
+  for (s = -WARMUP; s < samples; s++) {
+    double start;
+
+    if (bench->prepare != NULL) {
+      bench->prepare();
+    }
+
+    start = now();
+    for (i = 0; i < BATCH; i++) {
+      bench->body(i);
+    }
+
+    if (s >= 0) {
+      times[s] = (now() - start) / BATCH;
+      sum += times[s];
+    }
+  }
+
+  mean = sum / samples;
+  for (s = 0; s < samples; s++) {
+    var += (times[s] - mean) * (times[s] - mean);
+  }
+  qsort(times, samples, sizeof(double), compareDoubles);
+
+  printf("%-32s %10.1f %10.1f %10.1f %10.1f\n", bench->name, mean, sqrt(var / samples), times[0], times[samples / 2]);
+  free(times);
+}
+
+/*
+  Fills the line buffers with copies of a typical command line.
+*/
+static void prepareLines() {
+  int i;
+
+  for (i = 0; i < BATCH; i++) {
+    strcpy(buffers[i], "MAIN: mov STR[5], LIST[sz] ; a comment\n");
+  }
+}
+
+static void benchGetWord(int i) {
+  char *line = buffers[i];
+
+  sink += *getWord(&line);
+  sink += *getWord(&line);
+}
+
+/*
+  Fills the line buffers with the operands part of a command line.
+*/
+static void prepareArgs() {
+  int i;
+
+  for (i = 0; i < BATCH; i++) {
+    strcpy(buffers[i], " STR[5],LIST[sz]\n");
+  }
+}
+
+static void benchGetArg(int i) {
+  char *line = buffers[i];
+
+  sink += *getArg(&line);
+  sink += *getArg(&line);
+}
+
+static void benchCountArgs(int i) {
+  sink += countArgs(" r3 , LIST[sz]\n");
+}
+
+static void benchGetArgType(int i) {
+  sink += getArgType(args[i % (sizeof(args) / sizeof(char *))]);
+}
+
+static void benchCheckNumeric(int i) {
+  sink += checkNumeric(i & 1 ? "-1234" : "sz");
+}
+
+/*
+  Builds a symbol table with the given amount of symbols, and picks LABELS labels spread evenly over the table to be looked up.
+  Nodes are added at the head of the list, with addSymbolNode the build alone would take quadratic time.
+*/
+static void buildSymbols(int amount) {
+  char label[LINE_MAX];
+  int i;
+
+  symbolNodeFree(symbolHead);
+  symbolHead = NULL;
+
+  for (i = 0; i < amount; i++) {
+    symbolNodePtr node = salloc();
+
+    sprintf(label, "LABEL%d", i);
+    node->label = copyString(label);
+    node->val = i;
+    node->type = COMMAND;
+    node->next = symbolHead;
+    symbolHead = node;
+  }
+
+  for (i = 0; i < LABELS; i++) {
+    sprintf(labels[i], "LABEL%d", (int) ((long) i * amount / LABELS));
+  }
+}
+
+static void benchSymbolLookup(int i) {
+  sink += symbolNodeByLabel(labels[i % LABELS]) != NULL;
+}
+
+static void benchParseNumber(int i) {
+  int val = 0;
+  char *end;
+
+  sink += parseNumber(i & 1 ? "-1234" : "sz", WORD_MIN, WORD_MAX, &val, &end) + val;
+}
+
+static char indexedLine[LINE_MAX] = " r3 , LIST[sz]\n";
+static structuralIndex benchIndex;
+static int benchLevel;
+
+static void benchIndexBuffer(int i) {
+  indexBufferLevel(&benchIndex, buffers[0], 40, benchLevel);
+}
+
+/*
+  Indexes the line that countArgs is called with, the same way scan does before the line is processed.
+*/
+static void prepareIndexedLine() {
+  indexBuffer(&lineStructure, indexedLine, strlen(indexedLine));
+}
+
+static void benchCountArgsIndexed(int i) {
+  sink += countArgs(indexedLine);
+}
+
+static int diagnostics; /* The amount of errors countArgs reported while the tokenizer is verified */
+
+static void countDiagnostic(int number, int isError, char *message) {
+  diagnostics++;
+}
+
+/*
+  Accepts a source code line and runs getWord and getArg over all of it and countArgs on it, once on a copy that is
+  not indexed and once on a copy that is.
+  Returns the amount of results that are not the same: the tokens, where the line points after each of them, the null
+  terminators written to the copies, the amount of arguments and the amount of errors.
+*/
+static int verifyTokens(char *line) {
+  static char scalar[LINE_MAX + 2], indexed[LINE_MAX + 2];
+  structuralIndex idx;
+  int length = strlen(line), mismatches = 0, function, count, errors;
+  char *s, *x, *word;
+
+  for (function = 0; function < 3; function++) { /* getWord, getArg and countArgs */
+    memset(scalar, 0, sizeof(scalar));
+    memset(indexed, 0, sizeof(indexed));
+    strcpy(scalar, line);
+    strcpy(indexed, line);
+    indexBuffer(&lineStructure, indexed, length);
+    idx = lineStructure;
+
+    if (function == 2) {
+      diagnostics = 0;
+      count = countArgs(indexed);
+      errors = diagnostics;
+      lineStructure.base = NULL;
+      diagnostics = 0;
+      mismatches += countArgs(scalar) != count || diagnostics != errors;
+      continue;
+    }
+    for (s = scalar, x = indexed; s - scalar <= length;) { /* Every call points the line after a null terminator */
+      lineStructure.base = NULL;
+      word = function == 0 ? getWord(&s) : getArg(&s);
+      lineStructure = idx;
+      mismatches += (function == 0 ? getWord(&x) : getArg(&x)) - indexed != word - scalar || x - indexed != s - scalar;
+    }
+    mismatches += memcmp(scalar, indexed, sizeof(scalar)) != 0;
+  }
+
+  lineStructure.base = NULL;
+  return mismatches;
+}
+
+/*
+  Verifies that every implementation of the structural index builds the exact same bitmaps as the scalar one.
+  Uses random buffers of every length up to VERIFY_LENGTH, with characters of the whole range including null characters.
+  Then verifies that the tokenizer returns the same with the index as without it, on the corpus lines and on random
+  lines of every length up to LINE_MAX.
+  Returns the amount of mismatches.
+*/
+static int verifyIndex() {
+  static char buf[VERIFY_LENGTH + 1], lineChars[] = "ab1#-. \t\n\v\f\r,\"[];"; /* The characters of the random lines */
+  structuralIndex scalar = { 0 }, vector = { 0 };
+  int length, round, level, i, c, mismatches = 0;
+  unsigned long seed = 1;
+
+  for (length = 0; length <= VERIFY_LENGTH; length++) {
+    for (round = 0; round < VERIFY_ROUNDS; round++) {
+      for (i = 0; i < length; i++) {
+        seed = (seed * 1103515245UL + 12345UL) & 0xffffffffUL;
+        buf[i] = (char) ((seed >> 16) & 0xff);
+        if (seed & 1) { /* Half of the characters are picked from the structural ones so every class is common */
+          buf[i] = " \t\n\v\f\r,\"[];"[(seed >> 8) % 11];
+        }
+      }
+
+      indexBufferLevel(&scalar, buf, length, SCALAR_LEVEL);
+
+      for (level = SSE2_LEVEL; level <= indexLevel(); level++) {
+        indexBufferLevel(&vector, buf, length, level);
+
+        for (c = 0; c < CLASS_AMOUNT; c++) {
+          if (memcmp(scalar.masks[c], vector.masks[c], sizeof(unsigned long) * scalar.words) != 0) {
+            mismatches++;
+          }
+        }
+      }
+    }
+  }
+
+  setDiagnosticHandler(countDiagnostic);
+  for (i = 0; i < sizeof(corpusLines) / sizeof(char *); i++) {
+    mismatches += verifyTokens(corpusLines[i]);
+  }
+  for (length = 0; length < LINE_MAX; length++) {
+    for (round = 0; round < VERIFY_ROUNDS; round++) {
+      for (i = 0; i < length; i++) {
+        seed = (seed * 1103515245UL + 12345UL) & 0xffffffffUL;
+        buf[i] = lineChars[(seed >> 8) % (sizeof(lineChars) - 1)];
+      }
+      buf[length] = '\0';
+      mismatches += verifyTokens(buf);
+    }
+  }
+  setDiagnosticHandler(NULL);
+
+  return mismatches;
+}
+
+static void benchGetCommand(int i) {
+  sink += getCommand(commandNames[i % (sizeof(commandNames) / sizeof(char *))]) != NULL;
+}
+
+/*
+  Encodes a single word to its special characters, the same way writeObject does.
+*/
+static void benchEncodeWord(int i) {
+  char *str = toBinaryString(i * 37, CPU_BIT_SIZE);
+  int j;
+
+  for (j = 0; j < CPU_BIT_SIZE; j += BINARY_TO_SPECIAL_LENGTH) {
+    sink += toSpecialChar(str + j);
+  }
+
+  free(str);
+}
+
+static void benchWriteLine(int i) {
+  writeLine(devNull, MEMORY_BASE + i);
+}
+
+/*
+  Removes the nodes that were added by the previous sample so every sample adds to a table of dataSize nodes.
+*/
+static void prepareData() {
+  if (dataEnd != NULL) {
+    dataNodeFree(dataEnd->next);
+    dataEnd->next = NULL;
+  }
+  dataTail = dataEnd;
+  DC = dataSize;
+}
+
+static void benchAddDataNode(int i) {
+  addDataNode(NULL, i);
+}
+
+/*
+  Builds a data table of the given size for the addDataNode benchmark.
+*/
+static void buildData(int size) {
+  int i;
+
+  dataNodeFree(dataHead);
+  dataHead = dataEnd = NULL;
+  DC = DATA_BASE;
+
+  for (i = 0; i < size; i++) {
+    addDataNode(NULL, i);
+  }
+
+  for (dataEnd = dataHead; dataEnd != NULL && dataEnd->next != NULL; dataEnd = dataEnd->next);
+  dataSize = size;
+}
+
+int main(int argc, char *argv[]) {
+  benchmark benchmarks[] = {
+    { "getWord (2 words)", prepareLines, benchGetWord },
+    { "getArg (2 args)", prepareArgs, benchGetArg },
+    { "countArgs", NULL, benchCountArgs },
+    { "getArgType", NULL, benchGetArgType },
+    { "checkNumeric", NULL, benchCheckNumeric },
+    { "parseNumber", NULL, benchParseNumber },
+    { "getCommand", NULL, benchGetCommand },
+    { "toBinaryString + toSpecialChar", NULL, benchEncodeWord },
+    { "writeLine", NULL, benchWriteLine }
+  };
+  int symbolSizes[] = { 10, 1000, 100000 }, dataSizes[] = { 10, 100, 1000, 3000 }, i, mismatches;
+  char name[64], *levels[] = { "scalar", "SSE2", "AVX2" };
+
+  if (argc > 1 && atoi(argv[1]) > 0) {
+    samples = atoi(argv[1]);
+  }
+
+  devNull = fopen("/dev/null", "w");
+  fileName = "microbench";
+  if (devNull == NULL) {
+    printf("Cannot open file /dev/null\n");
+    return 1;
+  }
+
+  mismatches = verifyIndex();
+  printf("Structural index: %s selected, vectorized implementations and the indexed tokenizer %s the scalar ones\n\n",
+         levels[indexLevel()], mismatches ? "DO NOT MATCH" : "match");
+
+  printf("%-32s %10s %10s %10s %10s\n", "ns per call", "mean", "stddev", "min", "median");
+
+  for (i = 0; i < sizeof(benchmarks) / sizeof(benchmark); i++) {
+    run(&benchmarks[i]);
+  }
+
+  {
+    benchmark bench = { "countArgs (indexed)", prepareIndexedLine, benchCountArgsIndexed };
+
+    run(&bench);
+    lineStructure.base = NULL;
+  }
+
+  for (benchLevel = SCALAR_LEVEL; benchLevel <= indexLevel(); benchLevel++) {
+    benchmark bench = { NULL, prepareLines, benchIndexBuffer };
+
+    sprintf(name, "indexBuffer %s (40 chars)", levels[benchLevel]);
+    bench.name = name;
+    run(&bench);
+  }
+
+  for (i = 0; i < sizeof(symbolSizes) / sizeof(int); i++) {
+    benchmark bench = { NULL, NULL, benchSymbolLookup };
+
+    buildSymbols(symbolSizes[i]);
+    sprintf(name, "symbolNodeByLabel (%d)", symbolSizes[i]);
+    bench.name = name;
+    run(&bench);
+  }
+
+  for (i = 0; i < sizeof(dataSizes) / sizeof(int); i++) {
+    benchmark bench = { NULL, prepareData, benchAddDataNode };
+
+    buildData(dataSizes[i]);
+    sprintf(name, "addDataNode (%d)", dataSizes[i]);
+    bench.name = name;
+    run(&bench);
+  }
+
+  fclose(devNull);
+  return mismatches ? 1 : 0;
+}
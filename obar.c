@@ -0,0 +1,96 @@
+/*
+  Lists and extracts the members of an archive the assembler writes with --archive.
+  Extracted members have the exact bytes the individual output files would have.
+
+  USAGE:
+  obar -t ARCHIVE                         Lists the members: size and name
+  obar -x [-C DIR] ARCHIVE [MEMBER...]    Extracts the given members, or all of them, to their names(under DIR)
+  obar -p ARCHIVE MEMBER...               Writes the given members to the standard output
+  To create the program use 'make obar'.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "./archive.h"
+
+#define MAX_PATH 1024
+
+/*
+  Returns true if the member was requested, all members are when none were given.
+*/
+static int requested(char *name, char **names, int count) {
+  int i;
+
+  for (i = 0; i < count; i++) {
+    if (strcmp(name, names[i]) == 0) {
+      return 1;
+    }
+  }
+  return count == 0;
+}
+
+/*
+  Writes a member to the file with the given path, returns 0 on success.
+*/
+static int extract(archiveFile *ar, archiveMember *member, char *path) {
+  FILE *fp = fopen(path, "wb");
+
+  if (fp == NULL) {
+    printf("Cannot open file %s\n", path);
+    return -1;
+  }
+  if (fwrite(archivePayload(ar, member), 1, member->size, fp) != member->size || fclose(fp) != 0) {
+    printf("Cannot write to file %s\n", path);
+    return -1;
+  }
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  char *dir = NULL, *mode, path[2 * MAX_PATH + 2];
+  int i = 2, failed = 0, found = 0;
+  unsigned long m;
+  archiveFile ar;
+
+  if (argc < 3 || (strcmp(argv[1], "-t") != 0 && strcmp(argv[1], "-x") != 0 && strcmp(argv[1], "-p") != 0)) {
+    printf("USAGE: obar -t ARCHIVE | obar -x [-C DIR] ARCHIVE [MEMBER...] | obar -p ARCHIVE MEMBER...\n");
+    return 1;
+  }
+  mode = argv[1];
+
+  if (strcmp(mode, "-x") == 0 && strcmp(argv[2], "-C") == 0 && argc > 4) {
+    dir = argv[3];
+    i = 4;
+  }
+  if (argc == i || (dir != NULL && strlen(dir) >= MAX_PATH) || archiveMap(argv[i], &ar) != 0) {
+    return 1;
+  }
+
+  for (m = 0; m < ar.header->memberCount; m++) {
+    archiveMember *member = &ar.members[m];
+    char *name = archiveName(&ar, member);
+
+    if (strcmp(mode, "-t") == 0) {
+      printf("%10u %s\n", member->size, name);
+    } else if (requested(name, argv + i + 1, argc - i - 1)) {
+      found++;
+      if (strcmp(mode, "-p") == 0) {
+        fwrite(archivePayload(&ar, member), 1, member->size, stdout);
+      } else if (name[0] == '/' || strstr(name, "..") != NULL || strlen(name) >= MAX_PATH) { /* Members are only extracted under the directory */
+        printf("Skipping member %s\n", name);
+        failed = 1;
+      } else {
+        sprintf(path, "%s%s%s", dir == NULL ? "" : dir, dir == NULL ? "" : "/", name);
+        failed |= extract(&ar, member, path) != 0;
+      }
+    }
+  }
+
+  if (strcmp(mode, "-t") != 0 && argc - i - 1 > found) {
+    printf("%d of the requested members were not found\n", argc - i - 1 - found);
+    failed = 1;
+  }
+
+  archiveUnmap(&ar);
+  return failed;
+}
@@ -0,0 +1,110 @@
+/*
+  Converts binary object files(.bo) back to the text outputs of the assembler.
+  For each name it maps NAME.bo and writes NAME.ob, and NAME.ent and NAME.ext when the object has entries or uses
+  externals. The files are identical to the ones the assembler writes for the same source code.
+
+  USAGE:
+  obconv [-o DIR] NAME...
+  The names are given without the '.bo' extension, with -o the text files are written to DIR instead of next to the object.
+  To create the program use 'make obconv'.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "./object.h"
+
+#define MAX_PATH 1024
+
+/*
+  Accepts the name of an object, an output directory or NULL and an extension.
+  Writes to path the name of the text file with that extension.
+*/
+static void outputPath(char *path, char *name, char *dir, char *ext) {
+  char *base = strrchr(name, '/');
+
+  if (dir == NULL) {
+    sprintf(path, "%s%s", name, ext);
+  } else {
+    sprintf(path, "%s/%s%s", dir, base == NULL ? name : base + 1, ext);
+  }
+}
+
+static FILE *createFile(char *name, char *dir, char *ext) {
+  char path[MAX_PATH + 16];
+  FILE *fp;
+
+  outputPath(path, name, dir, ext);
+  if ((fp = fopen(path, "w")) == NULL) {
+    printf("Cannot open file %s\n", path);
+  }
+  return fp;
+}
+
+/*
+  Converts a single object file. Returns 0 on success.
+*/
+static int convert(char *name, char *dir) {
+  char path[MAX_PATH + 16];
+  objectFile obj;
+  objectHeader *header;
+  unsigned long i;
+  FILE *fp;
+
+  sprintf(path, "%s.bo", name);
+  if (objectMap(path, &obj) != 0) {
+    return -1;
+  }
+  header = obj.header;
+
+  if ((fp = createFile(name, dir, ".ob")) == NULL) {
+    objectUnmap(&obj);
+    return -1;
+  }
+  objectWriteText(fp, obj.words, header->codeWords, header->dataWords, header->base);
+  fclose(fp);
+
+  if (header->entryCount > 0 && (fp = createFile(name, dir, ".ent")) != NULL) {
+    for (i = 0; i < header->entryCount; i++) {
+      fprintf(fp, "%s\t%0*u\n", objectString(&obj, obj.entries[i].name), OBJECT_LINE_CHARS, obj.entries[i].address);
+    }
+    fclose(fp);
+  }
+
+  if (header->referenceCount > 0 && (fp = createFile(name, dir, ".ext")) != NULL) {
+    for (i = 0; i < header->referenceCount; i++) {
+      objectReference *ref = &obj.references[i];
+
+      fprintf(fp, "%s\t%0*u\n", objectString(&obj, obj.symbols[ref->symbol].name), OBJECT_LINE_CHARS, ref->address);
+    }
+    fclose(fp);
+  }
+
+  objectUnmap(&obj);
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  char *dir = NULL;
+  int i = 1, failed = 0;
+
+  if (argc > 2 && strcmp(argv[1], "-o") == 0) {
+    dir = argv[2];
+    i = 3;
+  }
+
+  if (i == argc) {
+    printf("USAGE: obconv [-o DIR] NAME...\n");
+    return 1;
+  }
+
+  for (; i < argc; i++) {
+    if (strlen(argv[i]) + (dir == NULL ? 0 : strlen(dir)) >= MAX_PATH) {
+      printf("The name %s is too long\n", argv[i]);
+      failed = 1;
+      continue;
+    }
+    failed |= convert(argv[i], dir) != 0;
+  }
+
+  return failed;
+}
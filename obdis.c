@@ -0,0 +1,672 @@
+/*
+  Disassembles the .ob files the assembler writes back to source code listings, and checks that they are valid.
+  The special characters of every word are decoded through a lookup table(objectReadText), and every instruction word is
+  decoded through a table that is built once from the commands table of the assembler(commandUtils.c), so exactly the
+  opcodes and address modes the assembler encodes are accepted.
+  Operand words are read in the layout the assembler writes them: two register operands share a single word and an index
+  operand is a word of the label followed by a word of the index. Labels are named after their address(L0123) unless
+  NAME.ent names them and uses of externals are named from NAME.ext, the data words are listed as .data and .string.
+  The files are handled by a pool of threads, each file by a single thread.
+
+  USAGE:
+  obdis [-o DIR] [-j THREADS] [-c] NAME...
+  The names are given without the '.ob' extension, the listing of each is written to NAME.dis(to DIR with -o).
+  With -c the files are only checked and no listing is written.
+  To create the program use 'make obdis'.
+*/
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "./command.h"
+#include "./commandUtils.h"
+#include "./data.h"
+#include "./object.h"
+
+#define MAX_PATH 1024
+#define MAX_THREADS 64
+#define MAX_NAME 80 /* The longest name accepted in the .ent and .ext files */
+#define MAX_ERRORS 10 /* The amount of errors that are printed for each file */
+#define MAX_STRING 72 /* Longer runs of characters are listed as .data */
+#define VALUES_PER_LINE 8 /* The amount of values in each .data line */
+#define LINE_RESERVE (3 * MAX_NAME + 128) /* The most a single line of a listing takes */
+#define OPERAND_SIGN 0x800 /* The sign bit of the 12 bit value of an operand word */
+#define WORD_SIGN 0x2000 /* The sign bit of a data word */
+
+#define LABEL_MARK 1 /* A label is defined at the address */
+#define START_MARK 2 /* An instruction starts at the address */
+
+typedef struct decoding { /* How an instruction word is decoded, there is one for every value of a word */
+  commandPtr comm; /* NULL when the word is not a valid instruction word */
+  unsigned char modes[2], /* The address mode(enum ADDRESS_MODE) of each operand */
+  length; /* The amount of words of the instruction */
+} decoding;
+
+typedef struct operand { /* An operand that was decoded from its words */
+  int mode, /* enum ADDRESS_MODE */
+  reg; /* The register of a register operand */
+  long value; /* The value of an immediate operand or of the index of an index operand */
+  unsigned long label; /* The address of the label of a direct or index operand */
+  char *external; /* The name of the external of a direct or index operand, NULL if it uses a label of the file */
+} operand;
+
+typedef struct program { /* The words of a single .ob file and the names of its addresses */
+  char *name; /* The name of the file without the extension, used in messages */
+  unsigned short *words;
+  unsigned long base, codeWords, size; /* size is the amount of instruction and data words */
+  unsigned char *marks; /* LABEL_MARK and START_MARK of every word */
+  char **labels, /* The name of the entry at each word, NULL when it has no name in the .ent file */
+  **externals, /* The external each word uses, NULL when it uses none */
+  **entryList, **externalList; /* The lines of the .ent and .ext files in their order */
+  unsigned long entryCount, externalCount;
+  char *entText, *extText; /* The contents of the .ent and .ext files, the names point into them */
+  int errors;
+} program;
+
+static decoding decodings[OBJECT_WORD_MASK + 1];
+static char **names, *outputDir;
+static int nameCount, nextName, checkOnly, failed; /* nextName is the next file a thread takes */
+static unsigned long totalBytes;
+static pthread_mutex_t nextLock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+  Prints an error about a file, at most MAX_ERRORS are printed for each file.
+*/
+static void report(program *prog, char *format, ...) {
+  char msg[MAX_PATH + LINE_RESERVE];
+  va_list ap;
+
+  if (prog->errors++ >= MAX_ERRORS) {
+    return;
+  }
+  va_start(ap, format);
+  vsnprintf(msg, sizeof(msg), format, ap);
+  va_end(ap);
+  printf("%s.ob: %s\n", prog->name, msg); /* A single call, so messages of different threads are not mixed */
+}
+
+/*
+  Fills the table of the instruction words, every word is decoded once with decodeCommandWord.
+*/
+static void buildTables(void) {
+  unsigned int word;
+  int modes[2] = { 0, 0 }, length;
+
+  for (word = 0; word <= OBJECT_WORD_MASK; word++) {
+    if ((decodings[word].comm = decodeCommandWord(word, modes, &length)) != NULL) {
+      decodings[word].modes[0] = modes[0];
+      decodings[word].modes[1] = modes[1];
+      decodings[word].length = length;
+    }
+  }
+}
+
+/*
+  Returns the value of the 12 bits above the encoding type of an operand word.
+*/
+static long operandValue(unsigned int word) {
+  long val = word >> OBJECT_ADDRESS_SHIFT;
+
+  return val & OPERAND_SIGN ? val - (OPERAND_SIGN << 1) : val;
+}
+
+/*
+  Accepts a program, the index of a word that holds a label and the operand to fill.
+  A relocatable word holds the address of a label of the file and an external word is named by the .ext file.
+  Returns 0 if the word is valid.
+*/
+static int decodeLabel(program *prog, unsigned long i, operand *op, int check) {
+  unsigned int word = prog->words[i];
+
+  op->external = NULL;
+  op->label = word >> OBJECT_ADDRESS_SHIFT;
+
+  if ((word & OBJECT_ARE_MASK) == EXT) {
+    op->external = prog->externals[i];
+    if (op->label != 0 || op->external == NULL) {
+      if (check) {
+        report(prog, "%04lu: the external word is not in %s.ext", prog->base + i, prog->name);
+      }
+      return -1;
+    }
+    return 0;
+  }
+  if ((word & OBJECT_ARE_MASK) != REL || op->label < prog->base || op->label >= prog->base + prog->size) {
+    if (check) {
+      report(prog, "%04lu: the word is not an address of the file", prog->base + i);
+    }
+    return -1;
+  }
+  return 0;
+}
+
+/*
+  Accepts a program, the index of an instruction word and an array for its operands.
+  Decodes the operand words of the instruction, and reports the errors when check is true.
+  Returns the amount of words of the instruction, or 0 if they are not a valid instruction.
+*/
+static int decodeInstruction(program *prog, unsigned long i, operand ops[], int check) {
+  decoding *d = &decodings[prog->words[i]];
+  unsigned long pos = i + 1, regPos = 0;
+  unsigned int regWord = 0;
+  int k, status = 0;
+
+  if (d->comm == NULL || i + d->length > prog->codeWords) {
+    if (check) {
+      report(prog, "%04lu: %s", prog->base + i, d->comm == NULL ? "the word is not an instruction" : "the instruction is cut by the data");
+    }
+    return 0;
+  }
+
+  for (k = 0; k < d->comm->args; k++) {
+    operand *op = &ops[k];
+    unsigned int word = prog->words[pos];
+
+    op->mode = d->modes[k];
+    switch (op->mode) {
+      case IMMED:
+        op->value = operandValue(word);
+        status |= (word & OBJECT_ARE_MASK) != ABS;
+        pos++;
+        break;
+      case DIRECT:
+        status |= decodeLabel(prog, pos++, op, check) != 0;
+        break;
+      case INDEX:
+        status |= decodeLabel(prog, pos++, op, check) != 0;
+        op->value = operandValue(prog->words[pos]);
+        status |= (prog->words[pos++] & OBJECT_ARE_MASK) != ABS;
+        break;
+      default:
+        {
+          int shift = k ? REG_SOURCE_DIST : REG_DESTINATION_DIST;
+
+          if (k > 0 && ops[0].mode == REGISTER_MODE) { /* Shares the word of the first operand */
+            pos--;
+          }
+          op->reg = (prog->words[pos] >> shift) & (REGISTER_AMOUNT - 1);
+          regWord += op->reg << shift;
+          regPos = pos++;
+        }
+    }
+  }
+
+  if (regPos != 0 && prog->words[regPos] != regWord) {
+    status = 1;
+  }
+  if (status != 0) {
+    if (check) {
+      report(prog, "%04lu: invalid operand words", prog->base + i);
+    }
+    return 0;
+  }
+  return d->length;
+}
+
+/*
+  Reads a decimal number at *p, returns the amount of digits.
+*/
+static int readNumber(char **p, char *end, unsigned long *val) {
+  int digits = 0;
+
+  for (*val = 0; *p < end && **p >= '0' && **p <= '9'; (*p)++, digits++) {
+    *val = *val * 10 + (**p - '0');
+  }
+  return digits;
+}
+
+/*
+  Accepts a program and the contents of its .ob file, decodes every line to a word. Returns 0 on success.
+*/
+static int readWords(program *prog, char *text, unsigned long length) {
+  unsigned long line, data;
+
+  prog->base = MEMORY_BASE;
+  if ((line = objectReadText(text, length, &prog->words, &prog->codeWords, &data, &prog->base)) != 0) {
+    report(prog, "line %lu is not valid", line);
+    return -1;
+  }
+  prog->size = prog->codeWords + data;
+  return 0;
+}
+
+/*
+  Accepts a program, the extension of one of its text outputs(.ent or .ext) and where to keep what is read.
+  Reads the file if it exists, keeps its contents in text and its names in list, and names each address it lists in
+  table(labels for entries and externals for uses).
+  Returns the amount of errors.
+*/
+static int readNames(program *prog, char *ext, char **text, char ***list, unsigned long *count, char **table) {
+  char path[MAX_PATH + 16], *p, *end;
+  long size;
+  FILE *fp;
+
+  sprintf(path, "%s%s", prog->name, ext);
+  if ((fp = fopen(path, "rb")) == NULL) {
+    return 0; /* The assembler doesn't write the file when it is empty */
+  }
+  if (fseek(fp, 0, SEEK_END) != 0 || (size = ftell(fp)) < 0 || fseek(fp, 0, SEEK_SET) != 0 ||
+      (*text = malloc(size + 1)) == NULL || (*list = malloc(sizeof(char *) * (size / 2 + 1))) == NULL ||
+      fread(*text, 1, size, fp) != size) {
+    fclose(fp);
+    report(prog, "cannot read %s", path);
+    return 1;
+  }
+  fclose(fp);
+
+  for (p = *text, end = p + size; p < end; (*count)++) {
+    char *name = p;
+    unsigned long address;
+
+    while (p < end && *p != '\t' && *p != '\n') {
+      p++;
+    }
+    if (p == end || *p != '\t' || p == name || p - name > MAX_NAME) {
+      report(prog, "%s has an invalid line", path);
+      return 1;
+    }
+    *p++ = '\0';
+    if (readNumber(&p, end, &address) == 0 || p == end || *p != '\n' || address < prog->base ||
+        address >= prog->base + prog->size) {
+      report(prog, "%s names %s at an address that is not in the file", path, name);
+      return 1;
+    }
+    *p++ = '\0';
+    table[address - prog->base] = name;
+    (*list)[*count] = name;
+  }
+  return 0;
+}
+
+/*
+  Writes a string, returns its end.
+*/
+static char *putString(char *p, char *s) {
+  while (*s) {
+    *p++ = *s++;
+  }
+  return p;
+}
+
+/*
+  Writes a decimal number with at least digits digits, returns its end.
+*/
+static char *putNumber(char *p, long val, int digits) {
+  char tmp[24];
+  unsigned long u = val < 0 ? -(unsigned long) val : val;
+  int n = 0;
+
+  if (val < 0) {
+    *p++ = '-';
+  }
+  do {
+    tmp[n++] = '0' + u % 10;
+    u /= 10;
+  } while (u > 0 || n < digits);
+  while (n > 0) {
+    *p++ = tmp[--n];
+  }
+  return p;
+}
+
+/*
+  Writes the name of the label at an address of the program, returns its end.
+*/
+static char *putLabel(char *p, program *prog, unsigned long address) {
+  char *name = prog->labels[address - prog->base];
+
+  if (name != NULL) {
+    return putString(p, name);
+  }
+  *p++ = 'L';
+  return putNumber(p, address, OBJECT_LINE_CHARS);
+}
+
+/*
+  Writes the address of a word and the definition of its label if it has one, returns their end.
+*/
+static char *putAddress(char *p, program *prog, unsigned long i) {
+  p = putNumber(p, prog->base + i, OBJECT_LINE_CHARS);
+  *p++ = '\t';
+  if (prog->marks[i] & LABEL_MARK) {
+    p = putLabel(p, prog, prog->base + i);
+    *p++ = ':';
+  }
+  *p++ = '\t';
+  return p;
+}
+
+/*
+  Writes an operand the way it is written in the source code, returns its end.
+*/
+static char *putOperand(char *p, program *prog, operand *op) {
+  switch (op->mode) {
+    case IMMED:
+      *p++ = '#';
+      return putNumber(p, op->value, 1);
+    case REGISTER_MODE:
+      *p++ = 'r';
+      return putNumber(p, op->reg, 1);
+    default:
+      p = op->external != NULL ? putString(p, op->external) : putLabel(p, prog, op->label);
+      if (op->mode == INDEX) {
+        *p++ = '[';
+        p = putNumber(p, op->value, 1);
+        *p++ = ']';
+      }
+      return p;
+  }
+}
+
+/*
+  Marks the start of every instruction and the address of every label, and checks every instruction and label.
+*/
+static void markProgram(program *prog) {
+  operand ops[2];
+  unsigned long i;
+  int k, length;
+
+  for (i = 0; i < prog->size; i++) {
+    prog->marks[i] = prog->labels[i] != NULL ? LABEL_MARK : 0;
+  }
+
+  for (i = 0; i < prog->codeWords; i += length > 0 ? length : 1) {
+    prog->marks[i] |= START_MARK;
+    length = decodeInstruction(prog, i, ops, 1);
+
+    for (k = 0; length > 0 && k < decodings[prog->words[i]].comm->args; k++) {
+      if ((ops[k].mode == DIRECT || ops[k].mode == INDEX) && ops[k].external == NULL) {
+        prog->marks[ops[k].label - prog->base] |= LABEL_MARK;
+      }
+    }
+  }
+
+  for (i = 0; i < prog->codeWords; i++) {
+    if ((prog->marks[i] & (LABEL_MARK | START_MARK)) == LABEL_MARK) {
+      report(prog, "%04lu: a label points into an instruction", prog->base + i);
+    }
+  }
+}
+
+/*
+  Adds the listing of the instructions to the buffer.
+*/
+static void listCode(program *prog, objectBuffer *buf) {
+  char line[LINE_RESERVE], *p;
+  operand ops[2];
+  unsigned long i;
+  int k, length;
+
+  for (i = 0; i < prog->codeWords; i += length > 0 ? length : 1) {
+    p = putAddress(line, prog, i);
+    length = decodeInstruction(prog, i, ops, 0);
+
+    if (length == 0) {
+      p = putString(p, "; invalid word ");
+      p = putNumber(p, prog->words[i], 1);
+    } else {
+      commandPtr comm = decodings[prog->words[i]].comm;
+
+      p = putString(p, comm->name);
+      for (k = 0; k < comm->args; k++) {
+        p = putString(p, k == 0 ? "\t" : ", ");
+        p = putOperand(p, prog, &ops[k]);
+      }
+    }
+    *p++ = '\n';
+    objectAppend(buf, line, p - line);
+  }
+}
+
+/*
+  Returns the value of a data word.
+*/
+static long dataValue(unsigned int word) {
+  return word & WORD_SIGN ? (long) word - (WORD_SIGN << 1) : (long) word;
+}
+
+/*
+  Adds the listing of the data words to the buffer, the words between two labels are a single .string if they are
+  printable characters followed by a 0, otherwise they are .data lines.
+*/
+static void listData(program *prog, objectBuffer *buf) {
+  char line[LINE_RESERVE], *p;
+  unsigned long i = prog->codeWords, end, j;
+
+  while (i < prog->size) {
+    for (end = i + 1; end < prog->size && !(prog->marks[end] & LABEL_MARK); end++)
+      ;
+    for (j = i; j < end && j - i <= MAX_STRING && prog->words[j] >= ' ' && prog->words[j] <= '~' && prog->words[j] != '"'; j++)
+      ;
+
+    if (j > i && j + 1 == end && prog->words[j] == 0) {
+      p = putString(putAddress(line, prog, i), ".string\t\"");
+      for (; i < j; i++) {
+        *p++ = prog->words[i];
+      }
+      p = putString(p, "\"\n");
+      objectAppend(buf, line, p - line);
+      i = end;
+    }
+
+    while (i < end) {
+      p = putString(putAddress(line, prog, i), ".data\t");
+      for (j = 0; j < VALUES_PER_LINE && i < end; j++, i++) {
+        p = putString(p, j == 0 ? "" : ", ");
+        p = putNumber(p, dataValue(prog->words[i]), 1);
+      }
+      *p++ = '\n';
+      objectAppend(buf, line, p - line);
+    }
+  }
+}
+
+/*
+  Writes the listing of a program to NAME.dis. Returns 0 on success.
+*/
+static int writeListing(program *prog) {
+  char path[MAX_PATH + 16], line[LINE_RESERVE], *p, *base = strrchr(prog->name, '/');
+  objectBuffer buf;
+  unsigned long i, j;
+  int status = 0;
+  FILE *fp;
+
+  objectInit(&buf);
+  p = putString(line, "; ");
+  p = putString(p, base != NULL ? base + 1 : prog->name);
+  p = putString(p, ".ob: ");
+  p = putNumber(p, prog->codeWords, 1);
+  p = putString(p, " instruction words, ");
+  p = putNumber(p, prog->size - prog->codeWords, 1);
+  p = putString(p, " data words\n");
+  objectAppend(&buf, line, p - line);
+
+  for (i = 0; i < prog->entryCount; i++) {
+    p = putString(putString(line, "\t\t.entry\t"), prog->entryList[i]);
+    *p++ = '\n';
+    objectAppend(&buf, line, p - line);
+  }
+  for (i = 0; i < prog->externalCount; i++) { /* Every external once, in the order of its first use */
+    for (j = 0; j < i && strcmp(prog->externalList[j], prog->externalList[i]) != 0; j++)
+      ;
+    if (j == i) {
+      p = putString(putString(line, "\t\t.extern\t"), prog->externalList[i]);
+      *p++ = '\n';
+      objectAppend(&buf, line, p - line);
+    }
+  }
+
+  listCode(prog, &buf);
+  listData(prog, &buf);
+
+  if (outputDir == NULL) {
+    sprintf(path, "%s.dis", prog->name);
+  } else {
+    sprintf(path, "%s/%s.dis", outputDir, base != NULL ? base + 1 : prog->name);
+  }
+  if ((fp = fopen(path, "w")) == NULL || fwrite(buf.data, 1, buf.size, fp) != buf.size || fclose(fp) != 0) {
+    printf("Cannot write to file %s\n", path);
+    status = -1;
+  }
+  objectFree(&buf);
+  return status;
+}
+
+/*
+  Disassembles a single file, adds its size to bytes. Returns the amount of errors.
+*/
+static int disassemble(char *name, unsigned long *bytes) {
+  char path[MAX_PATH + 16], *text;
+  struct stat st;
+  program prog;
+  int fd;
+
+  memset(&prog, 0, sizeof(prog));
+  prog.name = name;
+  sprintf(path, "%s.ob", name);
+
+  if ((fd = open(path, O_RDONLY)) < 0 || fstat(fd, &st) != 0) {
+    printf("Cannot open file %s\n", path);
+    if (fd >= 0) {
+      close(fd);
+    }
+    return 1;
+  }
+  text = st.st_size > 0 ? mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+  close(fd);
+  if (text == MAP_FAILED) {
+    printf("Cannot open file %s\n", path);
+    return 1;
+  }
+
+  *bytes += st.st_size;
+  if (readWords(&prog, text, st.st_size) == 0) {
+    if ((prog.marks = malloc(prog.size + 1)) == NULL || (prog.labels = calloc(prog.size + 1, sizeof(char *))) == NULL ||
+        (prog.externals = calloc(prog.size + 1, sizeof(char *))) == NULL) {
+      printf("Cannot allocate memory\n");
+      exit(1);
+    }
+
+    if (readNames(&prog, ".ent", &prog.entText, &prog.entryList, &prog.entryCount, prog.labels) == 0 &&
+        readNames(&prog, ".ext", &prog.extText, &prog.externalList, &prog.externalCount, prog.externals) == 0) {
+      markProgram(&prog);
+      if (!checkOnly && writeListing(&prog) != 0) {
+        prog.errors++;
+      }
+    }
+  }
+
+  if (text != NULL) {
+    munmap(text, st.st_size);
+  }
+  free(prog.words);
+  free(prog.marks);
+  free(prog.labels);
+  free(prog.externals);
+  free(prog.entryList);
+  free(prog.externalList);
+  free(prog.entText);
+  free(prog.extText);
+  return prog.errors;
+}
+
+/*
+  The body of each thread, takes files until all of them were disassembled.
+*/
+static void *worker(void *arg) {
+  unsigned long bytes = 0;
+  int errors = 0;
+
+  for (;;) {
+    int i;
+
+    pthread_mutex_lock(&nextLock);
+    i = nextName++;
+    failed += errors > 0;
+    totalBytes += bytes;
+    pthread_mutex_unlock(&nextLock);
+
+    if (i >= nameCount) {
+      return NULL;
+    }
+    bytes = 0;
+    errors = disassemble(names[i], &bytes);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  long threads = sysconf(_SC_NPROCESSORS_ONLN);
+  struct timespec start, end;
+  pthread_t pool[MAX_THREADS];
+  double seconds;
+  char *endp;
+  int i;
+
+  for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+    if (strcmp(argv[i], "-c") == 0) {
+      checkOnly = 1;
+    } else if (i + 1 == argc) { /* An option without a value */
+      i = argc;
+    } else if (strcmp(argv[i], "-o") == 0 && strlen(argv[i + 1]) < MAX_PATH) {
+      outputDir = argv[++i];
+    } else if (strcmp(argv[i], "-j") == 0) {
+      threads = strtol(argv[++i], &endp, 10);
+      if (*endp != '\0' || threads <= 0) {
+        printf("Invalid thread count %s\n", argv[i]);
+        return 1;
+      }
+    } else {
+      printf("Unknown option %s\n", argv[i]);
+      return 1;
+    }
+  }
+
+  if (i == argc) {
+    printf("USAGE: obdis [-o DIR] [-j THREADS] [-c] NAME...\n");
+    return 1;
+  }
+
+  names = argv + i;
+  nameCount = argc - i;
+  for (i = 0; i < nameCount; i++) {
+    if (strlen(names[i]) >= MAX_PATH) {
+      printf("The name %s is too long\n", names[i]);
+      return 1;
+    }
+  }
+
+  buildTables();
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  if (threads > MAX_THREADS) {
+    threads = MAX_THREADS;
+  }
+  if (threads > nameCount) {
+    threads = nameCount;
+  }
+  for (i = 0; i < threads; i++) {
+    if (pthread_create(&pool[i], NULL, worker, NULL) != 0) {
+      break;
+    }
+  }
+  if (i == 0) { /* No thread could be created, the files are disassembled by this one */
+    worker(NULL);
+  }
+  while (i > 0) {
+    pthread_join(pool[--i], NULL);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  printf("%s %d files, %d with errors, %.1f MB in %.3f seconds(%.0f MB/s)\n", checkOnly ? "Checked" : "Disassembled",
+         nameCount, failed, totalBytes / 1e6, seconds, seconds > 0 ? totalBytes / 1e6 / seconds : 0.0);
+  return failed > 0;
+}
@@ -0,0 +1,349 @@
+/*
+  Keeps a source file in memory and reassembles it after every edit, see incremental.h.
+  The edits are read from the standard input, a command in each line:
+  r LINE TEXT     Replaces a line with TEXT
+  i LINE TEXT     Inserts TEXT before a line(one after the last line appends it)
+  d LINE [COUNT]  Deletes COUNT lines(1 by default) from a line on
+  f               Compiles the whole source again
+  w               Writes the source back to NAME.as
+  q               Quits
+  After every edit the outputs are written as the assembler would write them for the edited source, and the time it
+  took and wether it was done incrementally(or why not) are printed.
+
+  With -b EDITS a benchmark runs EDITS edits instead: inserting an instruction after a random instruction, deleting it,
+  adding a number to a random .data line and restoring it, in turn. After every edit the outputs are compared with the
+  outputs of compiling the whole source again, which is timed too. The times of both are printed to the standard error.
+
+  USAGE:
+  obinc [-b EDITS] [OPTIONS] NAME
+  The name is given without the '.as' extension, the options are the options of the assembler except for --index,
+  --archive, --shm and --memfd.
+  To create the program use 'make obinc', 'make bench-incremental' runs the benchmark on a generated source.
+*/
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "./incremental.h"
+#include "./options.h"
+#include "./status.h"
+#include "./data.h"
+#include "./utils.h"
+
+#define MAX_PATH 1024
+#define OUTPUT_COUNT (sizeof(outputs) / sizeof(outputs[0]))
+
+static char *outputs[] = { ".ob", ".ent", ".ext" }; /* The outputs the benchmark compares */
+static char *name;
+
+/*
+  Returns the time since start in milliseconds.
+*/
+static double elapsed(struct timespec *start) {
+  struct timespec end;
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  return (end.tv_sec - start->tv_sec) * 1e3 + (end.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+/*
+  Accepts a line of the source and a buffer of LINE_MAX characters.
+  Copies the command or the guidance of the line to the buffer, an empty string if it has none.
+*/
+static void commandOf(char *text, char word[]) {
+  char first[LINE_MAX], second[LINE_MAX];
+
+  *first = *second = *word = '\0';
+  if (strlen(text) >= LINE_MAX || sscanf(text, "%s %s", first, second) < 1 || *first == ';') {
+    return;
+  }
+  strcpy(word, first[strlen(first) - 1] == ':' ? second : first);
+}
+
+/*
+  Accepts an extension.
+  Reads the output of the source with the extension to a new string, NULL if it does not exist.
+*/
+static char *readOutput(char *ext) {
+  char path[MAX_PATH + 16], *text;
+  FILE *fp;
+  long size;
+
+  sprintf(path, "%s%s", name, ext);
+  if ((fp = fopen(path, "rb")) == NULL) {
+    return NULL;
+  }
+  fseek(fp, 0, SEEK_END);
+  size = ftell(fp);
+  rewind(fp);
+  if ((text = malloc(size + 1)) == NULL) {
+    printf("Cannot allocate memory\n");
+    exit(1);
+  }
+  text[fread(text, 1, size, fp)] = '\0';
+  fclose(fp);
+  return text;
+}
+
+/*
+  Accepts the outputs that were read after an edit.
+  Compiles the whole source again and compares its outputs with them, returns the time it took.
+  Counts the outputs that differ in mismatches.
+*/
+static double compareFull(char *kept[], int *mismatches) {
+  struct timespec start;
+  double time;
+  int i;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  incrementalRebuild();
+  time = elapsed(&start);
+
+  for (i = 0; i < OUTPUT_COUNT; i++) {
+    char *full = readOutput(outputs[i]);
+
+    if ((full == NULL) != (kept[i] == NULL) || (full != NULL && strcmp(full, kept[i]) != 0)) {
+      fprintf(stderr, "The %s output of the edit differs from the output of a full build\n", outputs[i]);
+      (*mismatches)++;
+    }
+    free(full);
+    free(kept[i]);
+  }
+  return time;
+}
+
+/*
+  Accepts a kind of the source lines('i' for instructions that don't end a block, 'd' for .data) and a seed.
+  Returns the number of a random line of the kind, 0 if there is none.
+*/
+static int randomLine(char kind, unsigned long *seed) {
+  char word[LINE_MAX];
+  int count = incrementalLineCount(), i, k;
+
+  for (k = 0; k < count; k++) {
+    *seed = *seed * 1103515245 + 12345;
+    i = (*seed >> 8) % count + 1;
+    commandOf(incrementalLine(i), word);
+    if (kind == 'd' ? strcmp(word, ".data") == 0 :
+        *word != '\0' && *word != '.' && strcmp(word, "jmp") != 0 && strcmp(word, "bne") != 0 &&
+        strcmp(word, "jsr") != 0 && strcmp(word, "rts") != 0 && strcmp(word, "stop") != 0) {
+      return i;
+    }
+  }
+  return 0;
+}
+
+/*
+  Used by qsort to sort the times.
+*/
+static int compareTimes(const void *a, const void *b) {
+  double x = *(double *) a, y = *(double *) b;
+
+  return x < y ? -1 : x > y;
+}
+
+/*
+  Accepts a title, times and their amount.
+  Prints the mean, the median, the minimum and the maximum of the times to the standard error.
+*/
+static void printTimes(char *title, double times[], int count) {
+  double sum = 0;
+  int i;
+
+  qsort(times, count, sizeof(double), compareTimes);
+  for (i = 0; i < count; i++) {
+    sum += times[i];
+  }
+  fprintf(stderr, "%-12s mean %8.3f ms  median %8.3f ms  min %8.3f ms  max %8.3f ms\n", title, sum / count,
+          times[count / 2], times[0], times[count - 1]);
+}
+
+/*
+  Accepts the amount of edits.
+  Runs the benchmark, returns the amount of outputs that differed from the outputs of a full build.
+*/
+static int benchmark(int edits) {
+  double *incremental = malloc(sizeof(double) * edits), *full = malloc(sizeof(double) * edits);
+  char text[LINE_MAX + 8], *saved = NULL, *texts[1], *kept[OUTPUT_COUNT];
+  unsigned long seed = 1;
+  int mismatches = 0, fast = 0, done = 0, number = 0, i, k;
+  struct timespec start;
+
+  if (incremental == NULL || full == NULL) {
+    printf("Cannot allocate memory\n");
+    exit(1);
+  }
+
+  texts[0] = text;
+  for (i = 0; i < edits; i++) {
+    int first = number, removed = 1, count = 1;
+
+    switch (i % 4) {
+      case 0: /* Inserts an instruction after a random instruction */
+        if ((number = randomLine('i', &seed)) == 0) {
+          continue;
+        }
+        strcpy(text, "inc r1");
+        first = ++number;
+        removed = 0;
+        break;
+      case 1: /* Deletes it */
+        count = 0;
+        break;
+      case 2: /* Adds a number to a random .data line */
+        if ((number = randomLine('d', &seed)) == 0 || strlen(incrementalLine(number)) + 4 >= LINE_MAX - 1) {
+          number = 0;
+          continue;
+        }
+        saved = malloc(strlen(incrementalLine(number)) + 1);
+        strcpy(saved, incrementalLine(number));
+        sprintf(text, "%s, 7", saved);
+        first = number;
+        break;
+      default: /* Restores it */
+        if (number != 0) {
+          strcpy(text, saved);
+          free(saved);
+        }
+    }
+    if (first == 0) { /* The edit this one undoes was skipped */
+      continue;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    incrementalEdit(first, removed, texts, count);
+    incremental[done] = elapsed(&start);
+    fast += incrementalReason() == NULL;
+
+    for (k = 0; k < OUTPUT_COUNT; k++) {
+      kept[k] = readOutput(outputs[k]);
+    }
+    full[done++] = compareFull(kept, &mismatches);
+  }
+
+  if (done > 0) {
+    fprintf(stderr, "%s: %d lines, %d edits, %d incremental, %d outputs differ\n", name, incrementalLineCount(), done,
+            fast, mismatches);
+    printTimes("incremental", incremental, done);
+    printTimes("full build", full, done);
+  }
+  free(incremental);
+  free(full);
+  return mismatches;
+}
+
+/*
+  Accepts a command line and runs it.
+  Returns 0 when the command was q.
+*/
+static int runCommand(char *command) {
+  char *text, *end, *texts[1];
+  struct timespec start;
+  long number = 0, count = 1;
+  int status;
+
+  command[strcspn(command, "\n")] = '\0';
+  if (strchr("rid", *command) != NULL && *command != '\0') {
+    number = strtol(command + 1, &end, 10);
+    if (end == command + 1) {
+      printf("A line number is missing\n");
+      return 1;
+    }
+    text = *end == ' ' ? end + 1 : end;
+    texts[0] = text;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  switch (*command) {
+    case 'r':
+      status = incrementalEdit(number, 1, texts, 1);
+      break;
+    case 'i':
+      status = incrementalEdit(number, 0, texts, 1);
+      break;
+    case 'd':
+      if (*end != '\0' && ((count = strtol(end, &text, 10)) < 0 || *text != '\0')) {
+        printf("Invalid amount of lines %s\n", end);
+        return 1;
+      }
+      status = incrementalEdit(number, count, texts, 0);
+      break;
+    case 'f':
+      status = incrementalRebuild();
+      printf("full build: %.3f ms\n", elapsed(&start));
+      return 1;
+    case 'w':
+      if (incrementalSave() == OK_STATUS) {
+        printf("Wrote %s.as\n", name);
+      }
+      return 1;
+    case 'q':
+      return 0;
+    case '\0':
+      return 1;
+    default:
+      printf("Unknown command %s\n", command);
+      return 1;
+  }
+
+  if (status == OK_STATUS || incrementalReason() != NULL) {
+    printf("edit: %.3f ms, %s%s\n", elapsed(&start), incrementalReason() == NULL ? "incremental" : "full build: ",
+           incrementalReason() == NULL ? "" : incrementalReason());
+  }
+  return 1;
+}
+
+int main(int argc, char *argv[]) {
+  char command[LINE_MAX * 2], **files = malloc(sizeof(char *) * argc); /* The arguments that are not options */
+  long edits = 0;
+  int status;
+
+  if (argc > 2 && strcmp(argv[1], "-b") == 0) {
+    char *endp;
+
+    if ((edits = strtol(argv[2], &endp, 10)) <= 0 || *endp != '\0') {
+      printf("Invalid value %s for -b\n", argv[2]);
+      return 1;
+    }
+    argv[2] = argv[0];
+    argv += 2;
+    argc -= 2;
+  }
+
+  if (files == NULL) {
+    printf("Cannot allocate memory\n");
+    return 1;
+  }
+  if (parseOptions(argc, argv, files) != 1) {
+    printf("USAGE: obinc [-b EDITS] [OPTIONS] NAME\n");
+    return 1;
+  }
+  if (hasOption(INDEX_OPTION | ARCHIVE_OPTION | SHM_OPTION | MEMFD_OPTION)) {
+    printf("--index, --archive, --shm and --memfd are not supported by obinc\n");
+    return 1;
+  }
+  if (strlen(files[0]) >= MAX_PATH) {
+    printf("The name %s is too long\n", files[0]);
+    return 1;
+  }
+
+  name = files[0];
+  free(files);
+  if (incrementalOpen(name) != OK_STATUS && (edits > 0 || incrementalLineCount() == 0)) { /* The benchmark needs a source that compiles */
+    incrementalClose();
+    return 1;
+  }
+
+  if (edits > 0) {
+    status = benchmark(edits) != 0;
+  } else {
+    while (fgets(command, sizeof(command), stdin) != NULL && runCommand(command))
+      ;
+    status = 0;
+  }
+
+  incrementalClose();
+  return status;
+}
@@ -0,0 +1,326 @@
+#define _POSIX_C_SOURCE 200809L /* Required for mmap */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "./object.h"
+
+/*
+  This file holds the functions that build binary object files in memory and map them back from the disk.
+  The layout of the format is described in object.h.
+*/
+
+#define OBJECT_CHUNK 4096 /* The minimum amount of bytes the buffer grows by */
+
+typedef char objectHeaderSizeCheck[sizeof(objectHeader) == 68 ? 1 : -1]; /* The mapped structs require 16 and 32 bit shorts and ints */
+
+/*
+  Initializes an empty buffer.
+*/
+void objectInit(objectBuffer *buf) {
+  buf->data = NULL;
+  buf->size = buf->capacity = 0;
+}
+
+/*
+  Frees the memory of a buffer and leaves it empty.
+*/
+void objectFree(objectBuffer *buf) {
+  free(buf->data);
+  objectInit(buf);
+}
+
+/*
+  Grows the memory of the buffer so it can hold at least size bytes.
+*/
+static void objectGrow(objectBuffer *buf, unsigned long size) {
+  unsigned long capacity = buf->capacity * 2;
+  unsigned char *data;
+
+  if (size <= buf->capacity) {
+    return;
+  }
+  if (capacity < size + OBJECT_CHUNK) {
+    capacity = size + OBJECT_CHUNK;
+  }
+  if ((data = realloc(buf->data, capacity)) == NULL) {
+    printf("Cannot allocate memory\n");
+    exit(0);
+  }
+  buf->data = data;
+  buf->capacity = capacity;
+}
+
+/*
+  Accepts a buffer and an amount of bytes.
+  Pads the buffer to OBJECT_ALIGN and adds size zeroed bytes to it, growing its memory if needed.
+  Returns the offset of the added bytes.
+*/
+unsigned long objectReserve(objectBuffer *buf, unsigned long size) {
+  unsigned long offset = (buf->size + OBJECT_ALIGN - 1) / OBJECT_ALIGN * OBJECT_ALIGN;
+
+  objectGrow(buf, offset + size);
+  memset(buf->data + buf->size, 0, offset + size - buf->size);
+  buf->size = offset + size;
+  return offset;
+}
+
+/*
+  Accepts a buffer and size bytes of data.
+  Adds the bytes to the buffer right after the previous ones without aligning them, growing its memory if needed.
+  Returns the offset of the added bytes.
+*/
+unsigned long objectAppend(objectBuffer *buf, void *data, unsigned long size) {
+  unsigned long offset = buf->size;
+
+  objectGrow(buf, offset + size);
+  memcpy(buf->data + offset, data, size);
+  buf->size += size;
+  return offset;
+}
+
+/*
+  Writes the lower 16 bits of val at the given offset of the buffer, least significant byte first.
+*/
+void objectPut16(objectBuffer *buf, unsigned long offset, unsigned int val) {
+  buf->data[offset] = val & 0xff;
+  buf->data[offset + 1] = (val >> 8) & 0xff;
+}
+
+/*
+  Writes the lower 32 bits of val at the given offset of the buffer, least significant byte first.
+*/
+void objectPut32(objectBuffer *buf, unsigned long offset, unsigned long val) {
+  objectPut16(buf, offset, val & 0xffff);
+  objectPut16(buf, offset + 2, (val >> 16) & 0xffff);
+}
+
+/*
+  Accepts a file, words and the amount of instruction and data words among them, and the address of the first word.
+  Writes the words in the format of the .ob file: a line with the amount of instruction and data words, and a line for
+  each word with its address and its special characters(00 is '*', 01 is '#', 10 is '%' and 11 is '!', the first
+  character holds the 2 most significant bits).
+*/
+void objectWriteText(FILE *fp, unsigned short *words, unsigned long codeWords, unsigned long dataWords, unsigned long base) {
+  static char specialChars[] = { '*', '#', '%', '!' };
+  char line[OBJECT_SPECIAL_CHARS + 2];
+  unsigned long i;
+  int j;
+
+  line[OBJECT_SPECIAL_CHARS] = '\n';
+  line[OBJECT_SPECIAL_CHARS + 1] = '\0';
+
+  fprintf(fp, "\t%lu\t%lu\n", codeWords, dataWords);
+  for (i = 0; i < codeWords + dataWords; i++) {
+    for (j = 0; j < OBJECT_SPECIAL_CHARS; j++) {
+      line[j] = specialChars[(words[i] >> (2 * (OBJECT_SPECIAL_CHARS - 1 - j))) & 3];
+    }
+    fprintf(fp, "%0*lu\t%s", OBJECT_LINE_CHARS, base + i, line);
+  }
+}
+
+/*
+  Reads a decimal number at *p, returns the amount of digits.
+*/
+static int readNumber(char **p, char *end, unsigned long *val) {
+  int digits = 0;
+
+  for (*val = 0; *p < end && **p >= '0' && **p <= '9'; (*p)++, digits++) {
+    *val = *val * 10 + (**p - '0');
+  }
+  return digits;
+}
+
+/*
+  Accepts the contents of a .ob file and where to store what is read from it.
+  Decodes every line to a word the opposite way of objectWriteText, the 2 bits of a special character are found in a
+  table by the 4 lowest bits of the character, which are different for each of them. The addresses must be consecutive
+  and the first one is stored in base, which is left as it is when there are no words.
+  The words are allocated and stored in words. Returns 0 on success, or the number of the first line that is not valid.
+*/
+unsigned long objectReadText(char *text, unsigned long length, unsigned short **words, unsigned long *codeWords,
+                             unsigned long *dataWords, unsigned long *base) {
+  static char specialChars[] = { '*', '#', '%', '!' };
+  static unsigned char values[16] = { 4, 3, 4, 1, 4, 2, 4, 4, 4, 4, 0, 4, 4, 4, 4, 4 }; /* 4 for no special character */
+  char *p = text, *end = text + length;
+  unsigned long i, size, address;
+
+  *words = NULL;
+  if (p == end || *p++ != '\t' || readNumber(&p, end, codeWords) == 0 || p == end || *p++ != '\t' ||
+      readNumber(&p, end, dataWords) == 0 || p == end || *p++ != '\n') {
+    return 1;
+  }
+
+  size = *codeWords + *dataWords;
+  if (size > (end - p) / (OBJECT_LINE_CHARS + OBJECT_SPECIAL_CHARS + 2)) { /* Each line takes at least this much */
+    return 2;
+  }
+  if ((*words = malloc(sizeof(unsigned short) * (size + 1))) == NULL) {
+    printf("Cannot allocate memory\n");
+    exit(0);
+  }
+
+  for (i = 0; i < size; i++) {
+    unsigned int word = 0, bad = 0, val;
+    int j;
+
+    if (readNumber(&p, end, &address) < OBJECT_LINE_CHARS || (i > 0 && address != *base + i) ||
+        end - p < OBJECT_SPECIAL_CHARS + 2 || *p != '\t' || p[OBJECT_SPECIAL_CHARS + 1] != '\n') {
+      break;
+    }
+    if (i == 0) {
+      *base = address;
+    }
+
+    for (p++, j = 0; j < OBJECT_SPECIAL_CHARS; j++) {
+      val = values[p[j] & 15];
+      bad |= val == 4 || specialChars[val & 3] != p[j];
+      word = word << 2 | (val & 3);
+    }
+    if (bad) {
+      break;
+    }
+    (*words)[i] = word;
+    p += OBJECT_SPECIAL_CHARS + 1;
+  }
+
+  if (i < size || p != end) {
+    free(*words);
+    *words = NULL;
+    return i + 2;
+  }
+  return 0;
+}
+
+/*
+  Checks that a section of count elements of the given size at the given offset is aligned and lies inside the file.
+*/
+static int validSection(objectHeader *header, unsigned long offset, unsigned long count, unsigned long size) {
+  return offset % OBJECT_ALIGN == 0 && offset >= header->headerSize && offset <= header->fileSize &&
+         count <= (header->fileSize - offset) / size;
+}
+
+/*
+  Accepts a mapped object whose sections lie inside the file.
+  Returns wether every name is a string of it, every reference is to one of its symbols and every relocation, reference
+  and entry is at an address of its words.
+*/
+static int validRecords(objectFile *obj) {
+  objectHeader *header = obj->header;
+  unsigned long words = (unsigned long) header->codeWords + header->dataWords;
+  unsigned int i;
+
+  for (i = 0; i < header->relocationCount; i++) {
+    if (obj->relocations[i] < header->base || obj->relocations[i] - header->base >= words) {
+      return 0;
+    }
+  }
+  for (i = 0; i < header->referenceCount; i++) {
+    if (obj->references[i].address < header->base || obj->references[i].address - header->base >= words ||
+        obj->references[i].symbol >= header->symbolCount) {
+      return 0;
+    }
+  }
+  for (i = 0; i < header->entryCount; i++) {
+    if (obj->entries[i].name >= header->stringsSize || obj->entries[i].address < header->base) {
+      return 0;
+    }
+  }
+  for (i = 0; i < header->symbolCount; i++) {
+    if (obj->symbols[i].name >= header->stringsSize) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/*
+  Accepts the name of a binary object file and a struct to fill.
+  Maps the whole file to memory read only, validates the header, that every section lies inside the file and the
+  records of the sections(see validRecords), and points the fields of obj to the sections.
+  Prints a message and returns -1 if the file cannot be mapped or is not a valid object file, returns 0 on success.
+*/
+int objectMap(char *fileName, objectFile *obj) {
+  int fd = open(fileName, O_RDONLY);
+
+  if (fd < 0) {
+    printf("Cannot open file %s\n", fileName);
+    return -1;
+  }
+
+  return objectMapFd(fd, fileName, obj);
+}
+
+/*
+  Accepts an open file descriptor of a binary object, the name it is reported with and a struct to fill.
+  Maps the object like objectMap does and closes the descriptor, the mapping stays valid after it is closed.
+  Returns 0 on success, prints a message and returns -1 otherwise.
+*/
+int objectMapFd(int fd, char *fileName, objectFile *obj) {
+  struct stat st;
+  objectHeader *header;
+  void *map;
+
+  if (fstat(fd, &st) != 0) {
+    printf("Cannot open file %s\n", fileName);
+    close(fd);
+    return -1;
+  }
+
+  if (st.st_size < sizeof(objectHeader)) {
+    printf("%s is not a binary object file\n", fileName);
+    close(fd);
+    return -1;
+  }
+
+  map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd); /* The mapping stays valid after the file is closed */
+
+  if (map == MAP_FAILED) {
+    printf("Cannot map file %s\n", fileName);
+    return -1;
+  }
+
+  header = map;
+  obj->size = st.st_size;
+  if (memcmp(header->magic, OBJECT_MAGIC, sizeof(header->magic)) != 0 || header->version != OBJECT_VERSION ||
+      header->headerSize != sizeof(objectHeader) || header->fileSize != st.st_size ||
+      !validSection(header, header->wordsOffset, (unsigned long) header->codeWords + header->dataWords, sizeof(unsigned short)) ||
+      !validSection(header, header->entriesOffset, header->entryCount, sizeof(objectEntry)) ||
+      !validSection(header, header->symbolsOffset, header->symbolCount, sizeof(objectSymbol)) ||
+      !validSection(header, header->referencesOffset, header->referenceCount, sizeof(objectReference)) ||
+      !validSection(header, header->stringsOffset, header->stringsSize, 1) ||
+      !validSection(header, header->relocationsOffset, header->relocationCount, sizeof(unsigned short)) ||
+      (header->stringsSize > 0 && ((char *) map)[header->stringsOffset + header->stringsSize - 1] != '\0')) {
+    printf("%s is not a valid binary object file\n", fileName);
+    munmap(map, st.st_size);
+    return -1;
+  }
+
+  obj->header = header;
+  obj->words = (unsigned short *) ((char *) map + header->wordsOffset);
+  obj->entries = (objectEntry *) ((char *) map + header->entriesOffset);
+  obj->symbols = (objectSymbol *) ((char *) map + header->symbolsOffset);
+  obj->references = (objectReference *) ((char *) map + header->referencesOffset);
+  obj->strings = (char *) map + header->stringsOffset;
+  obj->relocations = (unsigned short *) ((char *) map + header->relocationsOffset);
+
+  if (!validRecords(obj)) {
+    printf("%s is not a valid binary object file\n", fileName);
+    objectUnmap(obj);
+    return -1;
+  }
+  return 0;
+}
+
+/*
+  Unmaps a file that was mapped with objectMap.
+*/
+void objectUnmap(objectFile *obj) {
+  munmap(obj->header, obj->size);
+  obj->header = NULL;
+}
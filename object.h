@@ -0,0 +1,97 @@
+#ifndef OBJECT_H
+#define OBJECT_H
+
+#include <stdio.h> /* Included here so I can use FILE in some functions prototypes */
+
+/*
+  The binary object format, an optional output alongside the special characters .ob file.
+  The file is designed to be memory mapped and used without parsing: a fixed header that holds the offset of
+  every section, followed by the sections. All the fields are little endian and every section starts at an
+  offset that is a multiple of 4, so on a little endian machine the mapped file can be read through these structs.
+
+  Sections:
+  words       16 bit words, the instruction words followed by the data words
+  entries     an objectEntry for each entry, in the order of the symbol table(the order of the .ent file)
+  symbols     an objectSymbol for each distinct external symbol
+  references  an objectReference for each use of an external, in the order of use(the order of the .ext file)
+  strings     the null terminated names of the entries and the external symbols
+  relocations the 16 bit addresses of the relocatable(REL) words in ascending order, these hold the address of a label
+              of the module and are the only words that change when the module is loaded at another base, together
+              with the references that are the external(EXT) slots
+*/
+
+#define OBJECT_MAGIC "ASOB" /* The first 4 bytes of every binary object file */
+#define OBJECT_VERSION 2
+#define OBJECT_ALIGN 4 /* Every section starts at an offset that is a multiple of this */
+#define OBJECT_WORD_MASK 0x3fff /* Words are stored with the 14 bits of the machine word, the upper bits are 0 */
+#define OBJECT_ADDRESS_SHIFT 2 /* The address in a relocatable or external word is stored above the 2 bits of the encoding type */
+#define OBJECT_ARE_MASK 3 /* The bits of the encoding type(absolute, external or relocatable) of a word */
+#define OBJECT_LINE_CHARS 4 /* In the text outputs addresses are written with at least this many digits */
+#define OBJECT_SPECIAL_CHARS 7 /* In the .ob file each word is written as 7 special characters, one for every 2 bits */
+
+typedef struct objectHeader {
+  char magic[4];
+  unsigned short version,
+  headerSize; /* The size of this struct, sections start after it */
+  unsigned int base, /* The address of the first word(MEMORY_BASE) */
+  codeWords, /* The amount of instruction words */
+  dataWords, /* The amount of data words */
+  entryCount,
+  symbolCount, /* The amount of distinct external symbols */
+  referenceCount, /* The amount of uses of external symbols */
+  stringsSize, /* The size of the strings section in bytes */
+  wordsOffset, /* The offset of each section from the start of the file */
+  entriesOffset,
+  symbolsOffset,
+  referencesOffset,
+  stringsOffset,
+  relocationCount, /* The amount of relocatable words */
+  relocationsOffset,
+  fileSize;
+} objectHeader;
+
+typedef struct objectEntry {
+  unsigned int name, /* The offset of the name in the strings section */
+  address;
+} objectEntry;
+
+typedef struct objectSymbol {
+  unsigned int name; /* The offset of the name in the strings section */
+} objectSymbol;
+
+typedef struct objectReference {
+  unsigned short address, /* The address of the word that uses the external */
+  symbol; /* The index of the external in the symbols section */
+} objectReference;
+
+typedef struct objectBuffer { /* A growing buffer an object file is built in before it is written */
+  unsigned char *data;
+  unsigned long size, capacity;
+} objectBuffer;
+
+typedef struct objectFile { /* A binary object file that was mapped to memory */
+  objectHeader *header;
+  unsigned short *words;
+  objectEntry *entries;
+  objectSymbol *symbols;
+  objectReference *references;
+  char *strings;
+  unsigned short *relocations;
+  unsigned long size;
+} objectFile;
+
+#define objectString(obj, offset) ((obj)->strings + (offset)) /* Returns a name from the strings section of a mapped object */
+
+void objectInit(objectBuffer *buf); /* Initializes an empty buffer */
+void objectFree(objectBuffer *buf); /* Frees the memory of a buffer */
+unsigned long objectReserve(objectBuffer *buf, unsigned long size); /* Adds size zeroed bytes to the buffer, aligned to OBJECT_ALIGN, and returns their offset */
+unsigned long objectAppend(objectBuffer *buf, void *data, unsigned long size); /* Adds size bytes to the buffer right after the previous ones, returns their offset */
+void objectPut16(objectBuffer *buf, unsigned long offset, unsigned int val); /* Writes a little endian 16 bit value at the offset */
+void objectPut32(objectBuffer *buf, unsigned long offset, unsigned long val); /* Writes a little endian 32 bit value at the offset */
+void objectWriteText(FILE *fp, unsigned short *words, unsigned long codeWords, unsigned long dataWords, unsigned long base); /* Writes words in the special characters format of the .ob file */
+unsigned long objectReadText(char *text, unsigned long length, unsigned short **words, unsigned long *codeWords, unsigned long *dataWords, unsigned long *base); /* Reads the words of a .ob file, returns 0 on success or the number of the first invalid line */
+int objectMap(char *fileName, objectFile *obj); /* Maps a binary object file to memory and validates it, returns 0 on success */
+int objectMapFd(int fd, char *fileName, objectFile *obj); /* Maps a binary object from an open file descriptor and closes it, returns 0 on success */
+void objectUnmap(objectFile *obj); /* Unmaps a file that was mapped with objectMap */
+
+#endif
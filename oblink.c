@@ -0,0 +1,347 @@
+/*
+  Links binary object files(.bo) of many modules into a single program.
+  The code of all the modules is laid out first, in the order of the command line, followed by the data of all the
+  modules, the same way a single module has its data after its code.
+  A global hash table of the entries of all the modules is built, and every use of an external is patched with the
+  final address of the entry it refers to and marked relocatable. Duplicate entries and externals without an entry
+  that are used are reported, the program is not written when one of them is found.
+  The words of each module are copied and relocated by a pool of threads, each module is handled by a single thread.
+
+  USAGE:
+  oblink [-o OUTPUT] [-j THREADS] NAME...
+  The names are given without the '.bo' extension, the linked program is written to OUTPUT.ob(linked.ob by default).
+  To create the program use 'make oblink'.
+*/
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "./object.h"
+
+#define MAX_PATH 1024
+#define MAX_THREADS 64
+#define ADDRESS_LIMIT (OBJECT_WORD_MASK >> OBJECT_ADDRESS_SHIFT) /* The largest address a word can hold */
+#define REL 2 /* The encoding type of a relocatable word */
+
+typedef struct module { /* A single object file and where it is placed in the program */
+  char *name;
+  objectFile obj;
+  unsigned long codeBase, dataBase; /* The final addresses of its code and data */
+  unsigned long *externals; /* The final address of each of its external symbols */
+  int overflows; /* The amount of addresses that don't fit in a word, counted by the thread that relocated the module */
+} module;
+
+typedef struct symbol { /* An entry in the global hash table */
+  char *name; /* Points into the strings of the module that defines it, NULL for an empty slot */
+  unsigned long address;
+  int module;
+} symbol;
+
+static module *modules;
+static int moduleCount, nextModule; /* nextModule is the next module a thread takes */
+static pthread_mutex_t nextLock = PTHREAD_MUTEX_INITIALIZER;
+static symbol *table;
+static unsigned long tableMask; /* The table size minus 1, the size is a power of 2 */
+static unsigned short *image; /* The words of the linked program */
+
+/*
+  Returns the FNV-1a hash of a name.
+*/
+static unsigned long hash(char *name) {
+  unsigned long h = 2166136261UL;
+
+  while (*name) {
+    h = ((h ^ (unsigned char) *name++) * 16777619UL) & 0xffffffffUL;
+  }
+  return h;
+}
+
+/*
+  Returns the slot of the name in the table, an empty slot if it is not there.
+*/
+static symbol *lookup(char *name) {
+  unsigned long i = hash(name) & tableMask;
+
+  while (table[i].name != NULL && strcmp(table[i].name, name) != 0) {
+    i = (i + 1) & tableMask;
+  }
+  return &table[i];
+}
+
+/*
+  Accepts a module and an address in the module as it was assembled, returns the final address.
+*/
+static unsigned long finalAddress(module *mod, unsigned long address) {
+  objectHeader *header = mod->obj.header;
+
+  if (address < header->base + header->codeWords) {
+    return mod->codeBase + address - header->base;
+  }
+  return mod->dataBase + address - header->base - header->codeWords;
+}
+
+/*
+  Accepts a module and an address in it, returns the index of the word in the image.
+*/
+#define imageIndex(mod, address) (finalAddress(mod, address) - modules[0].obj.header->base)
+
+/*
+  Copies the words of a module to the image, relocates its relocatable words and patches its external slots.
+*/
+static void relocate(module *mod) {
+  objectFile *obj = &mod->obj;
+  objectHeader *header = obj->header;
+  unsigned int i;
+
+  memcpy(image + (mod->codeBase - modules[0].obj.header->base), obj->words, sizeof(unsigned short) * header->codeWords);
+  memcpy(image + (mod->dataBase - modules[0].obj.header->base), obj->words + header->codeWords, sizeof(unsigned short) * header->dataWords);
+
+  for (i = 0; i < header->relocationCount; i++) {
+    unsigned short *word = &image[imageIndex(mod, obj->relocations[i])];
+    unsigned long address = finalAddress(mod, *word >> OBJECT_ADDRESS_SHIFT);
+
+    mod->overflows += address > ADDRESS_LIMIT;
+    *word = ((address << OBJECT_ADDRESS_SHIFT) | (*word & OBJECT_ARE_MASK)) & OBJECT_WORD_MASK;
+  }
+
+  for (i = 0; i < header->referenceCount; i++) {
+    unsigned long address = mod->externals[obj->references[i].symbol];
+
+    mod->overflows += address > ADDRESS_LIMIT;
+    image[imageIndex(mod, obj->references[i].address)] = ((address << OBJECT_ADDRESS_SHIFT) | REL) & OBJECT_WORD_MASK;
+  }
+}
+
+/*
+  The body of each thread, takes modules until all of them were relocated.
+*/
+static void *worker(void *arg) {
+  for (;;) {
+    int i;
+
+    pthread_mutex_lock(&nextLock);
+    i = nextModule++;
+    pthread_mutex_unlock(&nextLock);
+
+    if (i >= moduleCount) {
+      return NULL;
+    }
+    relocate(&modules[i]);
+  }
+}
+
+/*
+  Maps all the modules and lays them out, returns the total amount of code and data words through the pointers.
+*/
+static int loadModules(char **names, unsigned long *code, unsigned long *data) {
+  char path[MAX_PATH + 16];
+  int i;
+
+  *code = *data = 0;
+  for (i = 0; i < moduleCount; i++) {
+    module *mod = &modules[i];
+
+    mod->name = names[i];
+    if (strlen(names[i]) >= MAX_PATH) {
+      printf("The name %s is too long\n", names[i]);
+      return -1;
+    }
+    sprintf(path, "%s.bo", names[i]);
+    if (objectMap(path, &mod->obj) != 0) {
+      return -1;
+    }
+    if (mod->obj.header->base != modules[0].obj.header->base) {
+      printf("%s is not a valid binary object file\n", path);
+      return -1;
+    }
+    *code += mod->obj.header->codeWords;
+    *data += mod->obj.header->dataWords;
+  }
+
+  for (i = 0; i < moduleCount; i++) { /* Modules are placed in order, the data of all of them after all of the code */
+    modules[i].codeBase = i == 0 ? modules[0].obj.header->base : modules[i - 1].codeBase + modules[i - 1].obj.header->codeWords;
+    modules[i].dataBase = i == 0 ? modules[0].obj.header->base + *code : modules[i - 1].dataBase + modules[i - 1].obj.header->dataWords;
+  }
+
+  return 0;
+}
+
+/*
+  Builds the global table of the entries of all the modules, reports duplicates.
+  Returns the amount of duplicates.
+*/
+static int buildTable() {
+  unsigned long size = 16, count = 0;
+  int i, duplicates = 0;
+  unsigned int j;
+
+  for (i = 0; i < moduleCount; i++) {
+    count += modules[i].obj.header->entryCount;
+  }
+  while (size < count * 2) { /* The table is kept at most half full */
+    size *= 2;
+  }
+  if ((table = calloc(size, sizeof(symbol))) == NULL) {
+    printf("Cannot allocate memory\n");
+    exit(1);
+  }
+  tableMask = size - 1;
+
+  for (i = 0; i < moduleCount; i++) {
+    objectFile *obj = &modules[i].obj;
+
+    for (j = 0; j < obj->header->entryCount; j++) {
+      char *name = objectString(obj, obj->entries[j].name);
+      symbol *sym = lookup(name);
+
+      if (sym->name != NULL) {
+        printf("Duplicate symbol %s in %s and %s\n", name, modules[sym->module].name, modules[i].name);
+        duplicates++;
+        continue;
+      }
+      sym->name = name;
+      sym->address = finalAddress(&modules[i], obj->entries[j].address);
+      sym->module = i;
+    }
+  }
+
+  return duplicates;
+}
+
+/*
+  Resolves the final address of every external symbol of every module, reports the ones that are used without an entry.
+  Externals that are declared but never used don't need to be defined.
+  Returns the amount of undefined symbols.
+*/
+static int resolveExternals() {
+  int i, undefined = 0;
+  unsigned int j;
+
+  for (i = 0; i < moduleCount; i++) {
+    objectFile *obj = &modules[i].obj;
+    char *used = calloc(obj->header->symbolCount + 1, 1);
+
+    if ((modules[i].externals = malloc(sizeof(unsigned long) * (obj->header->symbolCount + 1))) == NULL || used == NULL) {
+      printf("Cannot allocate memory\n");
+      exit(1);
+    }
+
+    for (j = 0; j < obj->header->referenceCount; j++) {
+      used[obj->references[j].symbol] = 1;
+    }
+
+    for (j = 0; j < obj->header->symbolCount; j++) {
+      char *name = objectString(obj, obj->symbols[j].name);
+      symbol *sym = lookup(name);
+
+      if (sym->name == NULL && used[j]) {
+        printf("Undefined symbol %s in %s\n", name, modules[i].name);
+        undefined++;
+      }
+      modules[i].externals[j] = sym->address;
+    }
+    free(used);
+  }
+
+  return undefined;
+}
+
+/*
+  Writes the linked program in the special characters format of the .ob file.
+*/
+static int writeProgram(char *output, unsigned long code, unsigned long data) {
+  char path[MAX_PATH + 16];
+  FILE *fp;
+
+  sprintf(path, "%s.ob", output);
+  if ((fp = fopen(path, "w")) == NULL) {
+    printf("Cannot open file %s\n", path);
+    return -1;
+  }
+
+  objectWriteText(fp, image, code, data, modules[0].obj.header->base);
+
+  fclose(fp);
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  char *output = "linked", *end;
+  long threads = sysconf(_SC_NPROCESSORS_ONLN);
+  unsigned long code, data;
+  int i, overflows = 0;
+  pthread_t pool[MAX_THREADS];
+
+  for (i = 1; i < argc - 1 && argv[i][0] == '-'; i += 2) {
+    if (strcmp(argv[i], "-o") == 0 && strlen(argv[i + 1]) < MAX_PATH) {
+      output = argv[i + 1];
+    } else if (strcmp(argv[i], "-j") == 0) {
+      threads = strtol(argv[i + 1], &end, 10);
+      if (*end != '\0' || threads <= 0) {
+        printf("Invalid thread count %s\n", argv[i + 1]);
+        return 1;
+      }
+    } else {
+      printf("Unknown option %s\n", argv[i]);
+      return 1;
+    }
+  }
+
+  if (i == argc) {
+    printf("USAGE: oblink [-o OUTPUT] [-j THREADS] NAME...\n");
+    return 1;
+  }
+
+  moduleCount = argc - i;
+  if ((modules = calloc(moduleCount, sizeof(module))) == NULL) {
+    printf("Cannot allocate memory\n");
+    return 1;
+  }
+  if (loadModules(argv + i, &code, &data) != 0) {
+    return 1;
+  }
+
+  if (buildTable() + resolveExternals() > 0) {
+    printf("Failed to link %s\n", output);
+    return 1;
+  }
+
+  if ((image = malloc(sizeof(unsigned short) * (code + data + 1))) == NULL) {
+    printf("Cannot allocate memory\n");
+    return 1;
+  }
+
+  if (threads > MAX_THREADS) {
+    threads = MAX_THREADS;
+  }
+  if (threads > moduleCount) {
+    threads = moduleCount;
+  }
+  for (i = 0; i < threads; i++) {
+    if (pthread_create(&pool[i], NULL, worker, NULL) != 0) {
+      break;
+    }
+  }
+  if (i == 0) { /* No thread could be created, the modules are relocated by this one */
+    worker(NULL);
+  }
+  while (i > 0) {
+    pthread_join(pool[--i], NULL);
+  }
+
+  for (i = 0; i < moduleCount; i++) {
+    overflows += modules[i].overflows;
+  }
+  if (overflows > 0) {
+    printf("%d addresses don't fit in a word\n", overflows);
+  }
+
+  if (writeProgram(output, code, data) != 0) {
+    return 1;
+  }
+  printf("Linked %d modules into %s.ob\n", moduleCount, output);
+  return overflows > 0;
+}
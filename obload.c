@@ -0,0 +1,137 @@
+/*
+  A relocating loader for binary object files(.bo).
+  Maps NAME.bo and writes a memory image of the module loaded at the given base. Only the words listed in the relocation
+  table of the object are patched: the relocatable words get the distance between the new base and the base the module
+  was assembled for added to their address, so relocating costs O(relocations) on top of copying the words.
+  External slots are left as they are and reported, resolving them is the work of the linker.
+
+  The image is written to NAME.img, or to OUTPUT, as 16 bit little endian words where the word at index i is loaded
+  at address BASE + i. With -t the image is written in the special characters format of the .ob file instead, so loading
+  at the default base reproduces the .ob file of the module.
+
+  USAGE:
+  obload [-b BASE] [-o OUTPUT] [-t] NAME
+  To create the program use 'make obload'.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "./object.h"
+
+#define MAX_PATH 1024
+#define ADDRESS_LIMIT (OBJECT_WORD_MASK >> OBJECT_ADDRESS_SHIFT) /* The largest address a word can hold */
+
+/*
+  Accepts a mapped object, the base to load it at and an image with room for all of its words.
+  Copies the words and patches the relocatable ones.
+  Returns the amount of relocated addresses that don't fit in a word at the new base.
+*/
+static int relocate(objectFile *obj, long base, unsigned short *image) {
+  objectHeader *header = obj->header;
+  long delta = base - (long) header->base;
+  int overflows = 0;
+  unsigned int i;
+
+  memcpy(image, obj->words, sizeof(unsigned short) * (header->codeWords + header->dataWords));
+
+  for (i = 0; i < header->relocationCount; i++) {
+    unsigned int index = obj->relocations[i] - header->base;
+    unsigned short word = image[index];
+    long address = (word >> OBJECT_ADDRESS_SHIFT) + delta;
+
+    if (address < 0 || address > ADDRESS_LIMIT) {
+      overflows++;
+    }
+    image[index] = ((address << OBJECT_ADDRESS_SHIFT) | (word & OBJECT_ARE_MASK)) & OBJECT_WORD_MASK;
+  }
+
+  return overflows;
+}
+
+/*
+  Writes the image as 16 bit little endian words.
+*/
+static void writeImage(FILE *fp, objectHeader *header, unsigned short *image) {
+  unsigned long i;
+
+  for (i = 0; i < (unsigned long) header->codeWords + header->dataWords; i++) {
+    putc(image[i] & 0xff, fp);
+    putc(image[i] >> 8, fp);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  char path[MAX_PATH + 16], *output = NULL, *name, *end;
+  long base = -1;
+  int text = 0, i, overflows;
+  unsigned short *image;
+  objectFile obj;
+  FILE *fp;
+
+  for (i = 1; i < argc - 1 && argv[i][0] == '-'; i++) {
+    if (strcmp(argv[i], "-t") == 0) {
+      text = 1;
+    } else if (strcmp(argv[i], "-b") == 0) {
+      base = strtol(argv[++i], &end, 0);
+      if (*end != '\0' || base < 0 || base > ADDRESS_LIMIT) {
+        printf("Invalid base %s\n", argv[i]);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "-o") == 0) {
+      output = argv[++i];
+    } else {
+      printf("Unknown option %s\n", argv[i]);
+      return 1;
+    }
+  }
+
+  if (i != argc - 1 || strlen(argv[i]) >= MAX_PATH) {
+    printf("USAGE: obload [-b BASE] [-o OUTPUT] [-t] NAME\n");
+    return 1;
+  }
+  name = argv[i];
+
+  sprintf(path, "%s.bo", name);
+  if (objectMap(path, &obj) != 0) {
+    return 1;
+  }
+  if (base < 0) {
+    base = obj.header->base;
+  }
+
+  if ((image = malloc(sizeof(unsigned short) * (obj.header->codeWords + obj.header->dataWords + 1))) == NULL) {
+    printf("Cannot allocate memory\n");
+    return 1;
+  }
+
+  if ((overflows = relocate(&obj, base, image)) > 0) {
+    printf("%d addresses don't fit in a word at base %ld\n", overflows, base);
+  }
+  for (i = 0; i < obj.header->referenceCount; i++) {
+    objectReference *ref = &obj.references[i];
+
+    printf("Unresolved external %s at %ld\n", objectString(&obj, obj.symbols[ref->symbol].name), ref->address - (long) obj.header->base + base);
+  }
+
+  if (output == NULL) {
+    sprintf(path, "%s.img", name);
+    output = path;
+  }
+  if ((fp = fopen(output, text ? "w" : "wb")) == NULL) {
+    printf("Cannot open file %s\n", output);
+    free(image);
+    objectUnmap(&obj);
+    return 1;
+  }
+
+  if (text) {
+    objectWriteText(fp, image, obj.header->codeWords, obj.header->dataWords, base);
+  } else {
+    writeImage(fp, obj.header, image);
+  }
+
+  fclose(fp);
+  free(image);
+  objectUnmap(&obj);
+  return overflows > 0;
+}
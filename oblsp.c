@@ -0,0 +1,611 @@
+/*
+  A language server for the assembly language, editors run it and talk to it with the Language Server Protocol(JSON-RPC
+  messages with a Content-Length header) over its standard input and output.
+  Every open document is kept with its cross reference index, see xref.h: its lines, the labels, macros and externals
+  each line defines, the names each line uses, and the symbol table and the errors and warnings of the last time both
+  scans checked it. The scans are the ones of the assembler, so the errors are the ones it reports(validateLabel, valArg,
+  countArgs and the rest of the validations).
+
+  The server answers:
+  textDocument/definition  The label, macro or external a name refers to
+  textDocument/references  Every use of a name(and its definition when the editor asks for it)
+  textDocument/hover       The resolved address of a label or the value of a macro
+  and publishes the errors and the warnings after every change. The editor sends the changes as ranges of the text
+  (incremental synchronization), only the changed lines are split to their names again before the document is checked.
+
+  The messages the assembler prints while it checks a document(the reports of the control flow analysis and the
+  rest) are written to the standard error, since the standard output is the protocol.
+
+  USAGE:
+  oblsp [-v] [OPTIONS]
+  The options are the options of the assembler that change how it scans(--no-cfg, --no-fold, --optimize...), -v
+  writes the time each message took to the standard error.
+  To create the program use 'make oblsp'.
+*/
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "./xref.h"
+#include "./data.h"
+#include "./utils.h"
+#include "./options.h"
+
+#define HEADER_MAX 256 /* The maximum length of a line of the header of a message */
+#define HOVER_MAX 512 /* The maximum length of the text of a hover */
+
+enum JSON_TYPE
+{
+  JSON_NULL,
+  JSON_BOOL,
+  JSON_NUMBER,
+  JSON_STRING,
+  JSON_ARRAY,
+  JSON_OBJECT
+};
+
+enum ERROR_CODE /* Error codes of JSON-RPC */
+{
+  PARSE_ERROR = -32700,
+  METHOD_NOT_FOUND = -32601
+};
+
+typedef struct jsonValue *jsonValuePtr;
+typedef struct jsonValue { /* A value of a message, the members of an object and the items of an array are its children */
+  int type;
+  double number; /* The value of a number or a bool */
+  char *string, *key; /* The value of a string and the key of a member of an object */
+  jsonValuePtr children, next;
+} jsonValue;
+
+static FILE *protocol; /* The standard output, the real standard output writes to the standard error */
+static int verbose; /* -v was given */
+static int shuttingDown; /* The editor sent shutdown, so the exit that follows is not an error */
+
+static jsonValuePtr parseValue(char **text);
+
+/*
+  Skips the white space of a message.
+*/
+static void skipWhite(char **text) {
+  while (**text == ' ' || **text == '\t' || **text == '\n' || **text == '\r') {
+    (*text)++;
+  }
+}
+
+/*
+  Accepts a message that points to the opening quote of a string, returns the string without its escapes and points the
+  message after it. Returns NULL when the string doesn't end.
+*/
+static char *parseString(char **text) {
+  char *result, *cur, *p = *text + 1;
+
+  for (cur = p; *cur != '\0' && *cur != '"'; cur++) { /* The escapes are longer than what they stand for */
+    cur += *cur == '\\' && cur[1] != '\0';
+  }
+  if ((cur = result = malloc(cur - p + 1)) == NULL) {
+    printf("Cannot allocate memory\n");
+    exit(1);
+  }
+  while (*p != '"' && *p != '\0') {
+    if (*p != '\\') {
+      *cur++ = *p++;
+      continue;
+    }
+    switch (*++p) {
+      case 'b': *cur++ = '\b'; break;
+      case 'f': *cur++ = '\f'; break;
+      case 'n': *cur++ = '\n'; break;
+      case 'r': *cur++ = '\r'; break;
+      case 't': *cur++ = '\t'; break;
+      case 'u': { /* Written as UTF-8, a surrogate pair is written as a single '?' */
+        unsigned code = 0;
+        int i;
+
+        for (i = 1; i <= 4 && p[i] != '\0'; i++) {
+          code = code * 16 + (p[i] <= '9' ? p[i] - '0' : (p[i] | 0x20) - 'a' + 10);
+        }
+        p += i - 1;
+        if (code >= 0xD800 && code <= 0xDFFF) {
+          if (code < 0xDC00 && p[1] == '\\' && p[2] == 'u') {
+            p += 6;
+          }
+          *cur++ = '?';
+        } else if (code < 0x80) {
+          *cur++ = code;
+        } else if (code < 0x800) {
+          *cur++ = 0xC0 | code >> 6;
+          *cur++ = 0x80 | (code & 0x3F);
+        } else {
+          *cur++ = 0xE0 | code >> 12;
+          *cur++ = 0x80 | (code >> 6 & 0x3F);
+          *cur++ = 0x80 | (code & 0x3F);
+        }
+        break;
+      }
+      case '\0': p--; break;
+      default: *cur++ = *p; /* \" \\ and \/ */
+    }
+    p++;
+  }
+  *cur = '\0';
+  if (*p != '"') {
+    free(result);
+    return NULL;
+  }
+  *text = p + 1;
+  return result;
+}
+
+/*
+  Frees a value and its children.
+*/
+static void freeJson(jsonValuePtr value) {
+  while (value != NULL) {
+    jsonValuePtr next = value->next;
+
+    freeJson(value->children);
+    free(value->string);
+    free(value->key);
+    free(value);
+    value = next;
+  }
+}
+
+/*
+  Accepts a message that points to the opening bracket of an array or an object and the value of it.
+  Parses its items or members to the children of the value. Returns wether they were parsed.
+*/
+static int parseChildren(char **text, jsonValuePtr value) {
+  jsonValuePtr *link = &value->children, child;
+  char close = value->type == JSON_ARRAY ? ']' : '}', *key = NULL;
+
+  (*text)++;
+  skipWhite(text);
+  if (**text == close) {
+    (*text)++;
+    return 1;
+  }
+  while (1) {
+    skipWhite(text);
+    if (value->type == JSON_OBJECT) {
+      if (**text != '"' || (key = parseString(text)) == NULL) {
+        return 0;
+      }
+      skipWhite(text);
+      if (*(*text)++ != ':') {
+        free(key);
+        return 0;
+      }
+    }
+    if ((child = parseValue(text)) == NULL) {
+      free(key);
+      return 0;
+    }
+    child->key = key;
+    key = NULL;
+    *link = child;
+    link = &child->next;
+
+    skipWhite(text);
+    if (**text == close) {
+      (*text)++;
+      return 1;
+    }
+    if (*(*text)++ != ',') {
+      return 0;
+    }
+  }
+}
+
+/*
+  Accepts a message, parses the value at its start and points it after the value.
+  Returns the value, NULL when it is not valid JSON.
+*/
+static jsonValuePtr parseValue(char **text) {
+  jsonValuePtr value = calloc(1, sizeof(jsonValue));
+  char *end;
+
+  if (value == NULL) {
+    printf("Cannot allocate memory\n");
+    exit(1);
+  }
+  skipWhite(text);
+  if (**text == '{' || **text == '[') {
+    value->type = **text == '{' ? JSON_OBJECT : JSON_ARRAY;
+    if (!parseChildren(text, value)) {
+      freeJson(value);
+      return NULL;
+    }
+  } else if (**text == '"') {
+    value->type = JSON_STRING;
+    if ((value->string = parseString(text)) == NULL) {
+      freeJson(value);
+      return NULL;
+    }
+  } else if (strncmp(*text, "true", 4) == 0 || strncmp(*text, "false", 5) == 0) {
+    value->type = JSON_BOOL;
+    value->number = **text == 't';
+    *text += **text == 't' ? 4 : 5;
+  } else if (strncmp(*text, "null", 4) == 0) {
+    *text += 4;
+  } else {
+    value->type = JSON_NUMBER;
+    value->number = strtod(*text, &end);
+    if (end == *text) {
+      freeJson(value);
+      return NULL;
+    }
+    *text = end;
+  }
+  return value;
+}
+
+/*
+  Accepts an object and a path of keys separated by '.', returns the value at the path or NULL if there is none.
+*/
+static jsonValuePtr member(jsonValuePtr value, char *path) {
+  char *dot;
+  size_t length;
+
+  while (value != NULL && *path != '\0') {
+    dot = strchr(path, '.');
+    length = dot != NULL ? dot - path : strlen(path);
+    for (value = value->type == JSON_OBJECT ? value->children : NULL; value != NULL; value = value->next) {
+      if (strlen(value->key) == length && strncmp(value->key, path, length) == 0) {
+        break;
+      }
+    }
+    path += length + (dot != NULL);
+  }
+  return value;
+}
+
+/*
+  Returns the string at a path of an object, an empty string if there is none.
+*/
+static char *memberString(jsonValuePtr value, char *path) {
+  value = member(value, path);
+  return value != NULL && value->type == JSON_STRING ? value->string : "";
+}
+
+/*
+  Returns the number at a path of an object, -1 if there is none.
+*/
+static int memberNumber(jsonValuePtr value, char *path) {
+  value = member(value, path);
+  return value != NULL && (value->type == JSON_NUMBER || value->type == JSON_BOOL) ? (int) value->number : -1;
+}
+
+/*
+  Writes a string to a message with its quotes and escapes.
+*/
+static void writeString(FILE *out, char *str) {
+  putc('"', out);
+  for (; *str != '\0'; str++) {
+    if (*str == '"' || *str == '\\') {
+      fprintf(out, "\\%c", *str);
+    } else if ((unsigned char) *str < 0x20) {
+      fprintf(out, "\\u%04x", *str);
+    } else {
+      putc(*str, out);
+    }
+  }
+  putc('"', out);
+}
+
+/*
+  Writes a value to a message, used for the ids of the requests.
+*/
+static void writeId(FILE *out, jsonValuePtr id) {
+  if (id != NULL && id->type == JSON_STRING) {
+    writeString(out, id->string);
+  } else if (id != NULL && id->type == JSON_NUMBER) {
+    fprintf(out, "%.17g", id->number);
+  } else {
+    fprintf(out, "null");
+  }
+}
+
+/*
+  Accepts a message that was written to a memory stream and its text, sends it with its header and frees it.
+*/
+static void sendMessage(FILE *out, char **text, size_t *size) {
+  fclose(out); /* Sets the text and the size of the stream */
+  fprintf(protocol, "Content-Length: %lu\r\n\r\n%s", (unsigned long) *size, *text);
+  fflush(protocol);
+  free(*text);
+}
+
+/*
+  Accepts a line and the columns of a part of it, writes the range of the part.
+*/
+static void writeRange(FILE *out, int line, int start, int end) {
+  fprintf(out, "{\"start\":{\"line\":%d,\"character\":%d},\"end\":{\"line\":%d,\"character\":%d}}", line, start, line, end);
+}
+
+/*
+  Accepts a document, a line and a name of it, writes the location of the name.
+*/
+static void writeLocation(FILE *out, xrefDocumentPtr doc, int line, xrefName *name) {
+  fprintf(out, "{\"uri\":");
+  writeString(out, doc->uri);
+  fprintf(out, ",\"range\":");
+  writeRange(out, line, name->start, name->end);
+  putc('}', out);
+}
+
+/*
+  Sends the errors and the warnings of a document, none when it is closed.
+*/
+static void publishDiagnostics(xrefDocumentPtr doc, int closed) {
+  size_t size;
+  char *text;
+  FILE *out = open_memstream(&text, &size);
+  int i;
+
+  fprintf(out, "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/publishDiagnostics\",\"params\":{\"uri\":");
+  writeString(out, doc->uri);
+  fprintf(out, ",\"diagnostics\":[");
+  for (i = 0; !closed && i < doc->diagnosticCount; i++) {
+    xrefDiagnostic *cur = &doc->diagnostics[i];
+    int line = cur->line < 0 ? 0 : cur->line >= doc->lineCount ? doc->lineCount - 1 : cur->line;
+
+    fprintf(out, "%s{\"range\":", i > 0 ? "," : "");
+    writeRange(out, line, 0, strlen(doc->lines[line].text));
+    fprintf(out, ",\"severity\":%d,\"source\":\"assembler\",\"message\":", cur->isError ? 1 : 2);
+    writeString(out, cur->message);
+    putc('}', out);
+  }
+  fprintf(out, "]}}");
+  sendMessage(out, &text, &size);
+}
+
+/*
+  Accepts the parameters of a request about a position, returns its document and sets the line and the name at the
+  position(NULL when there is no name there). Returns NULL when the document isn't open.
+*/
+static xrefDocumentPtr namedAt(jsonValuePtr params, int *line, xrefName **name) {
+  xrefDocumentPtr doc = xrefFind(memberString(params, "textDocument.uri"));
+
+  *line = memberNumber(params, "position.line");
+  *name = doc != NULL ? xrefNameAt(doc, *line, memberNumber(params, "position.character")) : NULL;
+  return doc;
+}
+
+/*
+  Writes the result of textDocument/definition, the location of the definition of the name or null.
+*/
+static void definition(FILE *out, jsonValuePtr params) {
+  xrefName *name, *def = NULL;
+  int line;
+  xrefDocumentPtr doc = namedAt(params, &line, &name);
+
+  if (name != NULL) {
+    def = xrefDefinition(doc, name->name, &line);
+  }
+  if (def != NULL) {
+    writeLocation(out, doc, line, def);
+  } else {
+    fprintf(out, "null");
+  }
+}
+
+/*
+  Writes the result of textDocument/references, the locations of the uses of the name, and of its definitions when the
+  editor asks for them.
+*/
+static void references(FILE *out, jsonValuePtr params) {
+  xrefName *name;
+  int line, declarations = memberNumber(params, "context.includeDeclaration") == 1, count = 0, i, j;
+  xrefDocumentPtr doc = namedAt(params, &line, &name);
+
+  putc('[', out);
+  for (i = 0; name != NULL && i < doc->lineCount; i++) {
+    for (j = 0; j < doc->lines[i].nameCount; j++) {
+      xrefName *cur = &doc->lines[i].names[j];
+
+      if (strcmp(cur->name, name->name) == 0 && (declarations || cur->kind == XREF_USE)) {
+        fprintf(out, "%s", count++ > 0 ? "," : "");
+        writeLocation(out, doc, i, cur);
+      }
+    }
+  }
+  putc(']', out);
+}
+
+/*
+  Writes the result of textDocument/hover, what the symbol of the name resolved to or null.
+*/
+static void hover(FILE *out, jsonValuePtr params) {
+  char value[HOVER_MAX];
+  xrefName *name;
+  xrefSymbol *symbol;
+  int line;
+  xrefDocumentPtr doc = namedAt(params, &line, &name);
+
+  if (name == NULL || (symbol = xrefSymbolOf(doc, name->name)) == NULL || strlen(name->name) > LINE_MAX) {
+    fprintf(out, "null");
+    return;
+  }
+
+  switch (symbol->type) {
+    case COMMAND:
+      sprintf(value, "%s: instruction label, address %d", symbol->label, symbol->val);
+      break;
+    case GUIDANCE:
+      sprintf(value, "%s: data label, address %d", symbol->label, symbol->val);
+      break;
+    case ENTRY:
+      sprintf(value, "%s: entry, address %d", symbol->label, symbol->val);
+      break;
+    case MACRO:
+      sprintf(value, "%s: macro, value %d", symbol->label, symbol->val);
+      break;
+    default:
+      sprintf(value, "%s: external, its address is set when the program is linked", symbol->label);
+  }
+  if (!doc->compiled) {
+    strcat(value, " (the document has errors)");
+  }
+
+  fprintf(out, "{\"contents\":{\"kind\":\"plaintext\",\"value\":");
+  writeString(out, value);
+  fprintf(out, "},\"range\":");
+  writeRange(out, line, name->start, name->end);
+  putc('}', out);
+}
+
+/*
+  Applies the changes of textDocument/didChange to the document and checks it.
+*/
+static void change(jsonValuePtr params) {
+  xrefDocumentPtr doc = xrefFind(memberString(params, "textDocument.uri"));
+  jsonValuePtr cur = member(params, "contentChanges");
+
+  if (doc == NULL || cur == NULL) {
+    return;
+  }
+  for (cur = cur->children; cur != NULL; cur = cur->next) {
+    if (member(cur, "range") == NULL) { /* The whole text */
+      xrefEdit(doc, -1, 0, 0, 0, memberString(cur, "text"));
+    } else {
+      xrefEdit(doc, memberNumber(cur, "range.start.line"), memberNumber(cur, "range.start.character"),
+               memberNumber(cur, "range.end.line"), memberNumber(cur, "range.end.character"),
+               memberString(cur, "text"));
+    }
+  }
+  xrefCheck(doc);
+  publishDiagnostics(doc, 0);
+}
+
+/*
+  Accepts a message and handles it, sends the response to a request.
+  Returns 0 when the editor asked to exit.
+*/
+static int handle(jsonValuePtr message) {
+  char *method = memberString(message, "method"), *text;
+  jsonValuePtr params = member(message, "params"), id = member(message, "id");
+  xrefDocumentPtr doc;
+  size_t size;
+  FILE *out;
+
+  if (strcmp(method, "exit") == 0) {
+    return 0;
+  }
+  if (strcmp(method, "textDocument/didOpen") == 0) {
+    if ((doc = xrefFind(memberString(params, "textDocument.uri"))) != NULL) {
+      xrefClose(doc);
+    }
+    publishDiagnostics(xrefOpen(memberString(params, "textDocument.uri"), memberString(params, "textDocument.text")), 0);
+  } else if (strcmp(method, "textDocument/didChange") == 0) {
+    change(params);
+  } else if (strcmp(method, "textDocument/didClose") == 0) {
+    if ((doc = xrefFind(memberString(params, "textDocument.uri"))) != NULL) {
+      publishDiagnostics(doc, 1);
+      xrefClose(doc);
+    }
+  }
+  if (id == NULL) { /* A notification, it has no response */
+    return 1;
+  }
+
+  out = open_memstream(&text, &size);
+  fprintf(out, "{\"jsonrpc\":\"2.0\",\"id\":");
+  writeId(out, id);
+  if (strcmp(method, "initialize") == 0) {
+    fprintf(out, ",\"result\":{\"capabilities\":{\"textDocumentSync\":{\"openClose\":true,\"change\":2},"
+                 "\"definitionProvider\":true,\"referencesProvider\":true,\"hoverProvider\":true},"
+                 "\"serverInfo\":{\"name\":\"oblsp\"}}}");
+  } else if (strcmp(method, "shutdown") == 0) {
+    shuttingDown = 1;
+    fprintf(out, ",\"result\":null}");
+  } else if (strcmp(method, "textDocument/definition") == 0 || strcmp(method, "textDocument/references") == 0 ||
+             strcmp(method, "textDocument/hover") == 0) {
+    fprintf(out, ",\"result\":");
+    switch (method[13]) {
+      case 'd': definition(out, params); break;
+      case 'r': references(out, params); break;
+      default: hover(out, params);
+    }
+    putc('}', out);
+  } else {
+    fprintf(out, ",\"error\":{\"code\":%d,\"message\":\"Unknown method\"}}", METHOD_NOT_FOUND);
+  }
+  sendMessage(out, &text, &size);
+  return 1;
+}
+
+/*
+  Reads a message from the standard input, returns its text or NULL at the end of the input.
+*/
+static char *readMessage() {
+  char header[HEADER_MAX], *text;
+  long length = -1;
+
+  while (fgets(header, HEADER_MAX, stdin) != NULL) {
+    if (strcmp(header, "\r\n") == 0 || strcmp(header, "\n") == 0) {
+      if (length < 0) { /* A message without a length */
+        continue;
+      }
+      if ((text = malloc(length + 1)) == NULL) {
+        printf("Cannot allocate memory\n");
+        exit(1);
+      }
+      text[fread(text, 1, length, stdin)] = '\0';
+      return text;
+    }
+    if (strncmp(header, "Content-Length:", 15) == 0) {
+      length = strtol(header + 15, NULL, 10);
+    }
+  }
+  return NULL;
+}
+
+int main(int argc, char *argv[]) {
+  char **files = malloc(sizeof(char *) * argc), *text, *cur;
+  struct timespec start, end;
+  int count, running = 1;
+
+  if (files == NULL || (count = parseOptions(argc, argv, files)) < 0) {
+    return 1;
+  }
+  verbose = count == 1 && strcmp(files[0], "-v") == 0;
+  if (count > verbose) {
+    printf("USAGE: oblsp [-v] [OPTIONS]\n");
+    return 1;
+  }
+  free(files);
+
+  protocol = fdopen(dup(STDOUT_FILENO), "w"); /* The protocol is written to the standard output, the rest to the standard error */
+  dup2(STDERR_FILENO, STDOUT_FILENO);
+
+  while (running && (text = readMessage()) != NULL) {
+    jsonValuePtr message;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    cur = text;
+    if ((message = parseValue(&cur)) == NULL) {
+      char *response;
+      size_t size;
+      FILE *out = open_memstream(&response, &size);
+
+      fprintf(out, "{\"jsonrpc\":\"2.0\",\"id\":null,\"error\":{\"code\":%d,\"message\":\"Parse error\"}}", PARSE_ERROR);
+      sendMessage(out, &response, &size);
+    } else {
+      running = handle(message);
+      clock_gettime(CLOCK_MONOTONIC, &end);
+      if (verbose) {
+        fprintf(stderr, "%s: %.3f ms\n", memberString(message, "method"),
+                (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6);
+      }
+      freeJson(message);
+    }
+    free(text);
+  }
+
+  return shuttingDown ? 0 : 1;
+}
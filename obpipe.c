@@ -0,0 +1,83 @@
+/*
+  Assembles files and receives their binary objects through sealed memfds, without any file being written.
+  Runs the assembler with one end of a socket pair as its --memfd socket, and maps every object it sends read only.
+  This is also an example of a consumer that loads the assembled programs into another process.
+  The assembler is looked up next to obpipe itself, its messages are written to the standard error.
+
+  USAGE:
+  obpipe [-t] NAME...
+  For each received object prints its name and sizes, with -t prints its words in the format of the .ob file instead.
+  To create the program use 'make obpipe'.
+*/
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "./shared.h"
+
+#define ASSEMBLER "assembler"
+#define MAX_PATH 1024
+
+int main(int argc, char *argv[]) {
+  char name[SHARED_NAME_MAX], fdArg[16], path[MAX_PATH + sizeof(ASSEMBLER)], *slash, **args;
+  int text = argc > 1 && strcmp(argv[1], "-t") == 0, first = 1 + text, sv[2], i, status, received = 0;
+  objectFile obj;
+  pid_t pid;
+
+  if (argc == first || strlen(argv[0]) >= MAX_PATH) {
+    printf("USAGE: obpipe [-t] NAME...\n");
+    return 1;
+  }
+
+  if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) != 0 || (args = malloc(sizeof(char *) * (argc + 3))) == NULL) {
+    printf("Cannot create a socket pair\n");
+    return 1;
+  }
+
+  strcpy(path, argv[0]);
+  slash = strrchr(path, '/');
+  strcpy(slash != NULL ? slash + 1 : path, ASSEMBLER);
+
+  sprintf(fdArg, "%d", sv[1]);
+  args[0] = path;
+  args[1] = "--memfd";
+  args[2] = fdArg;
+  for (i = first; i <= argc; i++) {
+    args[i - first + 3] = argv[i];
+  }
+
+  if ((pid = fork()) < 0) {
+    printf("Cannot run %s\n", path);
+    return 1;
+  }
+  if (pid == 0) {
+    close(sv[0]);
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+    execv(path, args);
+    fprintf(stderr, "Cannot run %s\n", path);
+    _exit(127);
+  }
+  close(sv[1]); /* The socket reports the end once the assembler exits and its end is closed */
+
+  while ((status = receiveObject(sv[0], name, &obj)) > 0) {
+    objectHeader *header = obj.header;
+
+    if (text) {
+      objectWriteText(stdout, obj.words, header->codeWords, header->dataWords, header->base);
+    } else {
+      printf("%s: %u instruction words, %u data words, %u entries, %u external uses, %u relocations\n", name,
+             header->codeWords, header->dataWords, header->entryCount, header->referenceCount, header->relocationCount);
+    }
+    objectUnmap(&obj);
+    received++;
+  }
+
+  waitpid(pid, &i, 0);
+  free(args);
+  return status < 0 || !WIFEXITED(i) || WEXITSTATUS(i) == 127 || received == 0;
+}
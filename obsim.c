@@ -0,0 +1,666 @@
+/*
+  Simulates the machine the assembler targets and runs programs from their .ob files.
+  The machine has 8 registers, a memory of 4096 words of 14 bits, a zero flag that cmp sets and bne tests, and a stack
+  of return addresses for jsr and rts. A program is loaded at the address of its first word and starts running there.
+  Uses of externals(listed in NAME.ext) are stubbed: they hold the address of a word after the program that holds an
+  rts, so calling an external returns at once. A program from oblink has no externals left.
+
+  Every instruction is decoded once, before it first runs, into an instruction struct that holds a pointer to the
+  function of its operation and pointers to its operands(a register, a word of the memory or a value that was decoded
+  from the instruction). Running is a loop that calls the function of the current instruction, which returns the next
+  one. Writing to a word of an instruction decodes it again before it runs.
+
+  prn writes the value of its operand as a number(as a character with -c), red reads a character into its operand
+  (-1 at the end of the input). A single program reads the standard input and writes the standard output, with more
+  than one program each reads NAME.in(if it exists) and writes NAME.out. The programs are run by a pool of threads,
+  each program by a single thread.
+
+  USAGE:
+  obsim [-n LIMIT] [-j THREADS] [-c] [-p] NAME...
+  The names are given without the '.ob' extension. A program stops at stop, at an error, or after LIMIT instructions.
+  With -p the amount of times each address ran is written to NAME.prof.
+  To create the program use 'make obsim'.
+*/
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "./command.h"
+#include "./commandUtils.h"
+#include "./data.h"
+#include "./object.h"
+
+#define MAX_PATH 1024
+#define MAX_THREADS 64
+#define MACHINE_MEMORY ((OBJECT_WORD_MASK >> OBJECT_ADDRESS_SHIFT) + 1) /* The amount of words an address can reach */
+#define STACK_SIZE 1024 /* The amount of return addresses the stack holds */
+#define DEFAULT_LIMIT 100000000UL
+#define OPERAND_SIGN 0x800 /* The sign bit of the 12 bit value of an operand word */
+#define WORD_SIGN 0x2000 /* The sign bit of a word */
+#define wrap(val) ((((val) & OBJECT_WORD_MASK) ^ WORD_SIGN) - WORD_SIGN) /* The value of a word that holds val */
+
+#define WRITES 1 /* The operation writes its last operand */
+#define ADDRESS_OF_FIRST 2 /* The first operand is the address of a word, not the value in it */
+#define JUMPS 4 /* The operand is the address to jump to, the value of a register or an immediate is used as one */
+
+typedef struct machine machine;
+typedef struct instruction instruction;
+typedef instruction *(*handler)(machine *m, instruction *ins); /* Runs an instruction, returns the next one or NULL */
+
+struct instruction { /* An instruction that was decoded from its words */
+  handler run, /* Called to run the instruction */
+  op; /* The operation, when run is a wrapper around it */
+  int *a, *b; /* The operands, a is the first(or only) one */
+  int imm[2]; /* Values that were decoded from the instruction, operands may point here */
+  int next, /* The address of the next instruction */
+  written; /* The address op writes to, when run has to decode it again after it is written */
+};
+
+struct machine { /* The state of a running program */
+  int memory[MACHINE_MEMORY],
+  regs[REGISTER_AMOUNT],
+  stack[STACK_SIZE], sp,
+  zero, /* Set by cmp when its operands are equal */
+  codeEnd, /* Writes below this address decode the instructions they change again */
+  dataStart, /* The first address after the instructions of the program */
+  stub; /* The address of the rts that the uses of externals point to */
+  instruction code[MACHINE_MEMORY + MAX_WORDS]; /* The decoded instruction at each address */
+  char *fault; /* The reason the program stopped, NULL when it stopped at stop */
+  int faultAddress;
+  FILE *in, *out;
+  int (*read)(machine *m); /* The hooks of red and prn */
+  void (*print)(machine *m, int val);
+};
+
+typedef struct semantics { /* What an operation does */
+  char *name; /* The name of the command in the commands table */
+  handler op;
+  int flags; /* WRITES, ADDRESS_OF_FIRST and JUMPS */
+} semantics;
+
+typedef struct decoding { /* How an instruction word is decoded, there is one for every value of a word */
+  commandPtr comm; /* NULL when the word is not a valid instruction word */
+  int modes[2], length;
+  semantics *sem;
+} decoding;
+
+static instruction *redecode(machine *m, instruction *ins);
+static instruction *fault(machine *m, instruction *ins);
+
+static decoding decodings[OBJECT_WORD_MASK + 1];
+static char **names;
+static int nameCount, nextName, failed, charOutput, profiling;
+static unsigned long limit = DEFAULT_LIMIT, totalSteps;
+static pthread_mutex_t nextLock = PTHREAD_MUTEX_INITIALIZER;
+
+#define NEXT(m, ins) (&(m)->code[(ins)->next])
+
+/*
+  Stops the program with a message about the instruction, returns NULL.
+*/
+static instruction *stopAt(machine *m, instruction *ins, char *msg) {
+  m->fault = msg;
+  m->faultAddress = ins - m->code;
+  return NULL;
+}
+
+/*
+  Returns the instruction at an address, or stops the program if the address is not in the memory.
+*/
+static instruction *jumpTo(machine *m, instruction *ins, int address) {
+  return address >= 0 && address < MACHINE_MEMORY ? &m->code[address] : stopAt(m, ins, "jumps outside of the memory");
+}
+
+static instruction *doMov(machine *m, instruction *ins) {
+  *ins->b = *ins->a;
+  return NEXT(m, ins);
+}
+
+static instruction *doCmp(machine *m, instruction *ins) {
+  m->zero = wrap(*ins->a - *ins->b) == 0;
+  return NEXT(m, ins);
+}
+
+static instruction *doAdd(machine *m, instruction *ins) {
+  *ins->b = wrap(*ins->b + *ins->a);
+  return NEXT(m, ins);
+}
+
+static instruction *doSub(machine *m, instruction *ins) {
+  *ins->b = wrap(*ins->b - *ins->a);
+  return NEXT(m, ins);
+}
+
+static instruction *doNot(machine *m, instruction *ins) {
+  *ins->a = wrap(~*ins->a);
+  return NEXT(m, ins);
+}
+
+static instruction *doClr(machine *m, instruction *ins) {
+  *ins->a = 0;
+  return NEXT(m, ins);
+}
+
+static instruction *doInc(machine *m, instruction *ins) {
+  *ins->a = wrap(*ins->a + 1);
+  return NEXT(m, ins);
+}
+
+static instruction *doDec(machine *m, instruction *ins) {
+  *ins->a = wrap(*ins->a - 1);
+  return NEXT(m, ins);
+}
+
+static instruction *doJmp(machine *m, instruction *ins) {
+  return jumpTo(m, ins, *ins->a);
+}
+
+static instruction *doBne(machine *m, instruction *ins) {
+  return m->zero ? NEXT(m, ins) : jumpTo(m, ins, *ins->a);
+}
+
+static instruction *doRed(machine *m, instruction *ins) {
+  *ins->a = wrap(m->read(m));
+  return NEXT(m, ins);
+}
+
+static instruction *doPrn(machine *m, instruction *ins) {
+  m->print(m, *ins->a);
+  return NEXT(m, ins);
+}
+
+static instruction *doJsr(machine *m, instruction *ins) {
+  if (m->sp == STACK_SIZE) {
+    return stopAt(m, ins, "the stack is full");
+  }
+  m->stack[m->sp++] = ins->next;
+  return jumpTo(m, ins, *ins->a);
+}
+
+static instruction *doRts(machine *m, instruction *ins) {
+  return m->sp > 0 ? &m->code[m->stack[--m->sp]] : stopAt(m, ins, "returns with an empty stack");
+}
+
+static instruction *doStop(machine *m, instruction *ins) {
+  return NULL;
+}
+
+/*
+  The semantics of every command, matched to the commands table by name.
+*/
+static semantics semanticsTable[] = {
+  { "mov", doMov, WRITES },
+  { "cmp", doCmp, 0 },
+  { "add", doAdd, WRITES },
+  { "sub", doSub, WRITES },
+  { "not", doNot, WRITES },
+  { "clr", doClr, WRITES },
+  { "lea", doMov, WRITES | ADDRESS_OF_FIRST },
+  { "inc", doInc, WRITES },
+  { "dec", doDec, WRITES },
+  { "jmp", doJmp, JUMPS },
+  { "bne", doBne, JUMPS },
+  { "red", doRed, WRITES },
+  { "prn", doPrn, 0 },
+  { "jsr", doJsr, JUMPS },
+  { "rts", doRts, 0 },
+  { "stop", doStop, 0 }
+};
+
+/*
+  Fills the table of the instruction words, every word is decoded once with decodeCommandWord.
+*/
+static void buildTables(void) {
+  unsigned int word;
+  int i;
+
+  for (word = 0; word <= OBJECT_WORD_MASK; word++) {
+    decoding *d = &decodings[word];
+
+    if ((d->comm = decodeCommandWord(word, d->modes, &d->length)) == NULL) {
+      continue;
+    }
+    for (i = 0; i < sizeof(semanticsTable) / sizeof(semantics); i++) {
+      if (strcmp(semanticsTable[i].name, d->comm->name) == 0) {
+        d->sem = &semanticsTable[i];
+      }
+    }
+    if (d->sem == NULL) { /* A command the simulator doesn't know is not a valid instruction */
+      d->comm = NULL;
+    }
+  }
+}
+
+/*
+  Returns the value of the 12 bits above the encoding type of an operand word.
+*/
+static int operandValue(int word) {
+  int val = (word & OBJECT_WORD_MASK) >> OBJECT_ADDRESS_SHIFT;
+
+  return val & OPERAND_SIGN ? val - (OPERAND_SIGN << 1) : val;
+}
+
+/*
+  Calls the operation of an instruction that writes to a word of the instructions, then every instruction that may
+  hold that word is decoded again before it runs.
+*/
+static instruction *watched(machine *m, instruction *ins) {
+  instruction *next = ins->op(m, ins);
+  int i;
+
+  for (i = 0; i < MAX_WORDS && ins->written - i >= 0; i++) {
+    m->code[ins->written - i].run = redecode;
+  }
+  return next;
+}
+
+/*
+  Decodes the instruction at an address from the words of the memory.
+  The operands point to the registers and words they use, the address of a label(ADDRESS_OF_FIRST and JUMPS) and the
+  value of an immediate are kept in the instruction.
+*/
+static void predecode(machine *m, int address) {
+  instruction *ins = &m->code[address];
+  decoding *d = &decodings[m->memory[address] & OBJECT_WORD_MASK];
+  int pos = address + 1, k, *ops[2];
+
+  ins->op = fault;
+  ins->run = fault;
+  ins->written = -1;
+  ins->a = ins->b = NULL;
+
+  if (d->comm == NULL || address + d->length > MACHINE_MEMORY) {
+    return;
+  }
+  ins->next = address + d->length;
+
+  for (k = 0; k < d->comm->args; k++) {
+    int mode = d->modes[k], target = -1;
+
+    switch (mode) {
+      case IMMED:
+        ins->imm[k] = operandValue(m->memory[pos++]);
+        ops[k] = &ins->imm[k];
+        break;
+      case DIRECT:
+        target = operandValue(m->memory[pos++]) & (MACHINE_MEMORY - 1);
+        break;
+      case INDEX:
+        target = (operandValue(m->memory[pos]) & (MACHINE_MEMORY - 1)) + operandValue(m->memory[pos + 1]);
+        pos += 2;
+        break;
+      default:
+        {
+          int shift = k ? REG_SOURCE_DIST : REG_DESTINATION_DIST;
+
+          if (k > 0 && d->modes[0] == REGISTER_MODE) { /* Shares the word of the first operand */
+            pos--;
+          }
+          ops[k] = &m->regs[((m->memory[pos++] & OBJECT_WORD_MASK) >> shift) & (REGISTER_AMOUNT - 1)];
+        }
+    }
+
+    if (mode == DIRECT || mode == INDEX) {
+      if ((d->sem->flags & JUMPS) || (k == 0 && (d->sem->flags & ADDRESS_OF_FIRST))) {
+        ins->imm[k] = target;
+        ops[k] = &ins->imm[k];
+      } else if (target < 0 || target >= MACHINE_MEMORY) {
+        return;
+      } else {
+        ops[k] = &m->memory[target];
+      }
+    } else if (k == 0 && (d->sem->flags & ADDRESS_OF_FIRST)) { /* A register or an immediate has no address */
+      return;
+    }
+  }
+
+  if (d->comm->args > 0) {
+    ins->a = ops[0];
+    ins->b = d->comm->args > 1 ? ops[1] : ops[0];
+    if ((d->sem->flags & WRITES) && d->modes[d->comm->args - 1] == IMMED) { /* An immediate cannot be written */
+      return;
+    }
+  }
+
+  ins->op = ins->run = d->sem->op;
+  if ((d->sem->flags & WRITES) && ins->b >= m->memory && ins->b < m->memory + m->codeEnd) {
+    ins->written = ins->b - m->memory;
+    ins->run = watched;
+  }
+}
+
+/*
+  Runs an instruction that was not decoded yet or whose words were written to.
+  Running an instruction after the instructions of the program means any word may be an instruction, so from then on
+  every write to the memory decodes again the instructions it changes.
+*/
+static instruction *redecode(machine *m, instruction *ins) {
+  int address = ins - m->code, i;
+
+  if (address >= MACHINE_MEMORY) {
+    return stopAt(m, ins, "runs past the end of the memory");
+  }
+  if (address >= m->dataStart && address != m->stub && m->codeEnd < MACHINE_MEMORY) {
+    m->codeEnd = MACHINE_MEMORY;
+    for (i = 0; i < MACHINE_MEMORY; i++) {
+      m->code[i].run = redecode;
+    }
+  }
+  predecode(m, address);
+  return ins->run(m, ins);
+}
+
+/*
+  Stops the program at an instruction that cannot run.
+*/
+static instruction *fault(machine *m, instruction *ins) {
+  return stopAt(m, ins, "is not a valid instruction");
+}
+
+/*
+  The default hooks of red and prn.
+*/
+static int readChar(machine *m) {
+  int c = m->in != NULL ? getc(m->in) : EOF;
+
+  return c == EOF ? -1 : c;
+}
+
+static void printValue(machine *m, int val) {
+  if (charOutput) {
+    putc(val, m->out);
+  } else {
+    fprintf(m->out, "%d\n", val);
+  }
+}
+
+/*
+  Accepts a machine and the name of a program.
+  Reads NAME.ob into the memory, stubs the uses of externals that NAME.ext lists and decodes the instructions.
+  Returns 0 on success, prints a message and returns -1 otherwise.
+*/
+static int load(machine *m, char *name) {
+  char path[MAX_PATH + 16], *text;
+  unsigned long code, data, base = MEMORY_BASE, address, i, line;
+  unsigned short *words;
+  struct stat st;
+  commandPtr rts = getCommand("rts");
+  int fd, stubs = 0;
+  FILE *fp;
+
+  sprintf(path, "%s.ob", name);
+  if ((fd = open(path, O_RDONLY)) < 0 || fstat(fd, &st) != 0 || st.st_size == 0 ||
+      (text = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED) {
+    printf("Cannot open file %s\n", path);
+    if (fd >= 0) {
+      close(fd);
+    }
+    return -1;
+  }
+  close(fd);
+
+  line = objectReadText(text, st.st_size, &words, &code, &data, &base);
+  munmap(text, st.st_size);
+  if (line != 0) {
+    printf("%s: line %lu is not valid\n", path, line);
+    return -1;
+  }
+  if (base + code + data >= MACHINE_MEMORY) { /* One more word for the stub of the externals */
+    printf("%s doesn't fit in the memory\n", path);
+    free(words);
+    return -1;
+  }
+
+  for (i = 0; i < code + data; i++) {
+    m->memory[base + i] = wrap(words[i]);
+  }
+  free(words);
+  m->dataStart = m->codeEnd = base + code;
+
+  sprintf(path, "%s.ext", name);
+  if ((fp = fopen(path, "r")) != NULL) {
+    while (fscanf(fp, "%*s %lu", &address) == 1) {
+      if (address >= base && address < base + code) {
+        m->memory[address] = wrap(((base + code + data) << OBJECT_ADDRESS_SHIFT) | REL);
+        stubs++;
+      }
+    }
+    fclose(fp);
+  }
+  m->stub = base + code + data;
+  m->memory[m->stub] = rts->opcode << OPCODE_DIST;
+  if (stubs > 0) {
+    fprintf(nameCount > 1 ? stdout : stderr, "%s: %d uses of externals are stubbed\n", name, stubs);
+  }
+
+  for (i = 0; i < MACHINE_MEMORY + MAX_WORDS; i++) {
+    m->code[i].run = redecode;
+  }
+  for (i = base; i < base + code; i++) {
+    predecode(m, i);
+  }
+  predecode(m, m->stub);
+  return (int) base;
+}
+
+/*
+  Runs a program from an address until it stops or runs limit instructions, counts the runs of each address in counts
+  when it is not NULL. Returns the amount of instructions that ran.
+*/
+static unsigned long run(machine *m, int start, unsigned long *counts) {
+  instruction *ins = &m->code[start];
+  unsigned long steps = 0;
+
+  if (counts == NULL) {
+    while (ins != NULL && steps < limit) {
+      ins = ins->run(m, ins);
+      steps++;
+    }
+  } else {
+    while (ins != NULL && steps < limit) {
+      counts[ins - m->code]++;
+      ins = ins->run(m, ins);
+      steps++;
+    }
+  }
+
+  if (ins != NULL) {
+    m->fault = "reached the limit of instructions";
+    m->faultAddress = ins - m->code;
+  }
+  return steps;
+}
+
+/*
+  Writes the amount of runs of every address that ran to NAME.prof.
+*/
+static void writeProfile(char *name, unsigned long *counts) {
+  char path[MAX_PATH + 16];
+  FILE *fp;
+  int i;
+
+  sprintf(path, "%s.prof", name);
+  if ((fp = fopen(path, "w")) == NULL) {
+    printf("Cannot open file %s\n", path);
+    return;
+  }
+  for (i = 0; i < MACHINE_MEMORY; i++) {
+    if (counts[i] > 0) {
+      fprintf(fp, "%04d\t%lu\n", i, counts[i]);
+    }
+  }
+  fclose(fp);
+}
+
+/*
+  Loads and runs a single program, adds the amount of instructions that ran to steps. Returns 0 if it stopped at stop.
+*/
+static int simulate(char *name, unsigned long *steps) {
+  char path[MAX_PATH + 16];
+  unsigned long *counts = NULL, ran;
+  machine *m = calloc(1, sizeof(machine));
+  int start, status;
+
+  if (m == NULL || (profiling && (counts = calloc(MACHINE_MEMORY + MAX_WORDS, sizeof(unsigned long))) == NULL)) {
+    printf("Cannot allocate memory\n");
+    exit(1);
+  }
+  m->read = readChar;
+  m->print = printValue;
+  m->in = stdin;
+  m->out = stdout;
+
+  if ((start = load(m, name)) < 0) {
+    free(m);
+    free(counts);
+    return -1;
+  }
+
+  if (nameCount > 1) {
+    sprintf(path, "%s.in", name);
+    m->in = fopen(path, "r");
+    sprintf(path, "%s.out", name);
+    if ((m->out = fopen(path, "w")) == NULL) {
+      printf("Cannot open file %s\n", path);
+      if (m->in != NULL) {
+        fclose(m->in);
+      }
+      free(m);
+      free(counts);
+      return -1;
+    }
+  }
+
+  ran = run(m, start, counts);
+  *steps += ran;
+  if (nameCount == 1) { /* The output of the program is not mixed with the result */
+    fflush(m->out);
+  }
+  if (m->fault == NULL) {
+    fprintf(nameCount > 1 ? stdout : stderr, "%s: stopped after %lu instructions\n", name, ran);
+  } else {
+    fprintf(nameCount > 1 ? stdout : stderr, "%s: %04d %s, after %lu instructions\n", name, m->faultAddress, m->fault, ran);
+  }
+
+  if (counts != NULL) {
+    writeProfile(name, counts);
+  }
+  if (nameCount > 1) {
+    if (m->in != NULL) {
+      fclose(m->in);
+    }
+    fclose(m->out);
+  }
+  status = m->fault != NULL;
+  free(m);
+  free(counts);
+  return status;
+}
+
+/*
+  The body of each thread, takes programs until all of them ran.
+*/
+static void *worker(void *arg) {
+  unsigned long steps = 0;
+  int status = 0;
+
+  for (;;) {
+    int i;
+
+    pthread_mutex_lock(&nextLock);
+    i = nextName++;
+    failed += status != 0;
+    totalSteps += steps;
+    pthread_mutex_unlock(&nextLock);
+
+    if (i >= nameCount) {
+      return NULL;
+    }
+    steps = 0;
+    status = simulate(names[i], &steps);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  long threads = sysconf(_SC_NPROCESSORS_ONLN);
+  struct timespec start, end;
+  pthread_t pool[MAX_THREADS];
+  double seconds;
+  char *endp;
+  int i;
+
+  for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+    if (strcmp(argv[i], "-c") == 0) {
+      charOutput = 1;
+    } else if (strcmp(argv[i], "-p") == 0) {
+      profiling = 1;
+    } else if (i + 1 == argc) { /* An option without a value */
+      i = argc;
+    } else if (strcmp(argv[i], "-n") == 0 || strcmp(argv[i], "-j") == 0) {
+      long val = strtol(argv[i + 1], &endp, 10);
+
+      if (*endp != '\0' || val <= 0) {
+        printf("Invalid value %s for %s\n", argv[i + 1], argv[i]);
+        return 1;
+      }
+      if (argv[i++][1] == 'n') {
+        limit = val;
+      } else {
+        threads = val;
+      }
+    } else {
+      printf("Unknown option %s\n", argv[i]);
+      return 1;
+    }
+  }
+
+  if (i == argc) {
+    printf("USAGE: obsim [-n LIMIT] [-j THREADS] [-c] [-p] NAME...\n");
+    return 1;
+  }
+
+  names = argv + i;
+  nameCount = argc - i;
+  for (i = 0; i < nameCount; i++) {
+    if (strlen(names[i]) >= MAX_PATH) {
+      printf("The name %s is too long\n", names[i]);
+      return 1;
+    }
+  }
+
+  buildTables();
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  if (threads > MAX_THREADS) {
+    threads = MAX_THREADS;
+  }
+  if (threads > nameCount) {
+    threads = nameCount;
+  }
+  for (i = 0; i < threads; i++) {
+    if (pthread_create(&pool[i], NULL, worker, NULL) != 0) {
+      break;
+    }
+  }
+  if (i == 0) { /* No thread could be created, the programs are run by this one */
+    worker(NULL);
+  }
+  while (i > 0) {
+    pthread_join(pool[--i], NULL);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  if (nameCount > 1) {
+    printf("Ran %d programs, %d did not stop at stop, %lu instructions in %.3f seconds(%.0f million per second)\n",
+           nameCount, failed, totalSteps, seconds, seconds > 0 ? totalSteps / 1e6 / seconds : 0.0);
+  }
+  return failed > 0;
+}
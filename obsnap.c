@@ -0,0 +1,33 @@
+/*
+  Precompiles a definition source(only .define and .extern lines) to a symbol snapshot, see snapshot.h.
+  The assembler adds the symbols of the snapshot to every file it compiles with --preload SNAPSHOT, without reading or
+  parsing the source again.
+
+  USAGE:
+  obsnap NAME [SNAPSHOT]
+  The name is given without the '.as' extension, the snapshot is written to NAME.snap unless another name is given.
+  To create the program use 'make obsnap'.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include "./snapshot.h"
+#include "./strings.h"
+
+int main(int argc, char *argv[]) {
+  char *snapshotFile;
+  int status;
+
+  if (argc < 2 || argc > 3) {
+    printf("USAGE: obsnap NAME [SNAPSHOT]\n");
+    return 1;
+  }
+
+  snapshotFile = argc == 3 ? argv[2] : addExtension(argv[1], SNAPSHOT_EXT);
+  if ((status = snapshotCreate(argv[1], snapshotFile)) == 0) {
+    printf("Wrote %s\n", snapshotFile);
+  }
+  if (argc == 2) {
+    free(snapshotFile);
+  }
+  return status != 0;
+}
@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <string.h>
+#include "./options.h"
+#include "./status.h"
+
+/*
+  This file holds the parsing of the command line options.
+*/
+
+typedef struct option { /* A single command line option */
+  char *name;
+  int flag; /* The bit that is set in 'options' when the option is supplied */
+  char **value; /* Points to where the argument after the option is stored, NULL if the option takes no value */
+} option;
+
+int options; /* The options that were supplied in the command line */
+char *indexPath; /* The value of --index */
+char *archivePath; /* The value of --archive */
+char *shmPrefix; /* The value of --shm */
+char *memfdSocket; /* The value of --memfd */
+char *watchDir; /* The value of --watch */
+char *preloadPath; /* The value of --preload */
+
+static option optionTable[] = {
+  { "--binary", BINARY_OPTION, NULL },
+  { "--index", INDEX_OPTION, &indexPath },
+  { "--archive", ARCHIVE_OPTION, &archivePath },
+  { "--shm", SHM_OPTION, &shmPrefix },
+  { "--memfd", MEMFD_OPTION, &memfdSocket },
+  { "--optimize", OPTIMIZE_OPTION, NULL },
+  { "--no-fold", NO_FOLD_OPTION, NULL },
+  { "--no-cfg", NO_CFG_OPTION, NULL },
+  { "--dead-data", DEAD_DATA_OPTION, NULL },
+  { "--pool-strings", POOL_STRINGS_OPTION, NULL },
+  { "--size-report", SIZE_REPORT_OPTION, NULL },
+  { "--watch", WATCH_OPTION, &watchDir },
+  { "--preload", PRELOAD_OPTION, &preloadPath }
+};
+
+/*
+  Accepts the command line arguments and an array with enough room for all of them.
+  Every argument that starts with '--' is looked up in the option table and its flag is set in 'options', options that take
+  a value take the next argument. The rest of the arguments are file names and are added to files in their order.
+  Returns the amount of files, or -1 if an unknown option was supplied or an option is missing its value.
+*/
+int parseOptions(int argc, char *argv[], char *files[]) {
+  int i, j, count = 0;
+
+  options = 0;
+
+  for (i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "--", 2) != 0) {
+      files[count++] = argv[i];
+      continue;
+    }
+
+    for (j = 0; j < sizeof(optionTable) / sizeof(option); j++) {
+      if (strcmp(argv[i], optionTable[j].name) == 0) {
+        options |= optionTable[j].flag;
+        break;
+      }
+    }
+
+    if (j == sizeof(optionTable) / sizeof(option)) {
+      printf("Unknown option %s\n", argv[i]);
+      return -1;
+    }
+
+    if (optionTable[j].value != NULL) {
+      if (i + 1 == argc) {
+        printf("The option %s requires a value\n", argv[i]);
+        return -1;
+      }
+      *optionTable[j].value = argv[++i];
+    }
+  }
+
+  return count;
+}
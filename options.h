@@ -0,0 +1,38 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+/*
+  Command line options of the assembler.
+  Options start with '--' and may appear anywhere between the file names, each option that is given sets its bit in 'options'.
+*/
+
+enum OPTION /* Each option is a single bit in 'options' */
+{
+  BINARY_OPTION = 1, /* Also write the binary object file(.bo) */
+  INDEX_OPTION = 2, /* Append the symbols of each file to a shared symbol index, see symindex.h */
+  ARCHIVE_OPTION = 4, /* Write the outputs of all the files to a single archive, see archive.h */
+  SHM_OPTION = 8, /* Hand the binary object of each file over through POSIX shared memory, see shared.h */
+  MEMFD_OPTION = 16, /* Hand the binary object of each file over through a sealed memfd, see shared.h */
+  OPTIMIZE_OPTION = 32, /* Remove and rewrite instructions with the peephole optimizer, see peephole.h */
+  NO_FOLD_OPTION = 64, /* Keep array operands with a constant index in the index address mode, see peephole.h */
+  NO_CFG_OPTION = 128, /* With --optimize, keep unreachable instructions and jumps to jumps, see cfg.h */
+  DEAD_DATA_OPTION = 256, /* Remove the data blocks no instruction or entry uses, see deadData.h */
+  POOL_STRINGS_OPTION = 512, /* Share the strings that are suffixes of other strings, see stringPool.h */
+  SIZE_REPORT_OPTION = 1024, /* Write the words and the estimated cycles of each label and basic block, see sizeReport.h */
+  WATCH_OPTION = 2048, /* Keep compiling the sources of a directory whenever they change, see watch.h */
+  PRELOAD_OPTION = 4096 /* Add the symbols of a precompiled snapshot to the symbol table of every file, see snapshot.h */
+};
+
+#define hasOption(opt) (options & (opt)) /* Returns true if the given option was supplied in the command line */
+
+int parseOptions(int argc, char *argv[], char *files[]); /* Sets the options from the command line and fills files with the rest of the arguments, returns the amount of files or -1 on an unknown option */
+
+extern int options; /* The options that were supplied in the command line(enum OPTION) */
+extern char *indexPath; /* The symbol index file given with --index */
+extern char *archivePath; /* The archive file given with --archive */
+extern char *shmPrefix; /* The prefix of the shared memory names given with --shm */
+extern char *memfdSocket; /* The socket the memfds are sent over given with --memfd */
+extern char *watchDir; /* The directory given with --watch */
+extern char *preloadPath; /* The snapshot given with --preload */
+
+#endif
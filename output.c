@@ -1,8 +1,15 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <stddef.h>
+#include <string.h>
 #include "./files.h"
 #include "./data.h"
 #include "./strings.h"
+#include "./output.h"
+#include "./options.h"
+#include "./symindex.h"
+#include "./shared.h"
+#include "./sizeReport.h"
 
 /*
   Prototypes for functions that are private to this file.
@@ -12,6 +19,8 @@ void initObjOut(int lines);
 void initExtOut(int maxLines);
 void createObjectFile();
 void createExternalFile();
+void createBinaryOutputs();
+void createIndexRecords();
 
 /*
   Checks if a given pointer points somewhere and if so frees that memory allocated
@@ -24,8 +33,9 @@ void createExternalFile();
 
 /* objOut holds the values for the words that needs to be written to the .ob file */
 static int *objOut, *extLines; /* extLines holds lines in their order that needs to be written to the .ext file */
+static int *relLines; /* Holds the lines of the relocatable words in their order, they are written to the binary object */
 static char **extLabels; /* Holds the labels in their order that needs to be written to the .ext file */
-static int curWord, curExt; /* curWord is the current .ob file word count, and curExt is the current .ext file count */
+static int curWord, curExt, curRel; /* curWord is the current .ob file word count, curExt is the current .ext file count and curRel the relocatable words count */
 
 /*
   After the first scan we want to initialize some variables that correspond to the current file being processed.
@@ -34,6 +44,7 @@ static int curWord, curExt; /* curWord is the current .ob file word count, and c
 void initOutputVars() {
   curWord = 0;
   curExt = 0;
+  curRel = 0;
   initObjOut(IC - MEMORY_BASE);
   initExtOut((IC - MEMORY_BASE) * 2); /* extOut can have at most IC - MEMORY_BASE * 2 lines, we multiple by 2 because each instruction may use 2 operands and both can be externals */
 }
@@ -45,6 +56,7 @@ void freeOutputVars() {
   freeVarIfExists(objOut);
   freeVarIfExists(extLines);
   freeVarIfExists(extLabels);
+  freeVarIfExists(relLines);
 }
 
 /*
@@ -54,6 +66,16 @@ void createOutput() {
   createObjectFile(); /* Creates the .ob file */
   createExternalFile(); /* Creates the .ext file */
   createEntries(); /* Loops through symbol table to create entry file */
+
+  if (hasOption(BINARY_OPTION | SHM_OPTION | MEMFD_OPTION)) {
+    createBinaryOutputs(); /* Creates the .bo file, or hands the binary object over through shared memory */
+  }
+  if (hasOption(INDEX_OPTION)) {
+    createIndexRecords(); /* Appends the symbols of the file to the symbol index */
+  }
+  if (hasOption(SIZE_REPORT_OPTION)) {
+    sizeReport(objOut, curWord); /* Creates the .size and .size.json files */
+  }
 }
 
 /*
@@ -74,8 +96,9 @@ void initObjOut(int lines) {
 void initExtOut(int maxLines) {
   extLines = malloc (sizeof(int) * maxLines); /* The external file will have at most maxLines lines */
   extLabels = malloc (sizeof(char *) * maxLines);
+  relLines = malloc (sizeof(int) * maxLines); /* Relocatable words are bound by the same count */
 
-  if (extLines == NULL || extLabels == NULL) {
+  if (extLines == NULL || extLabels == NULL || relLines == NULL) {
     printf("Cannot allocate memory\n");
     exit(0);
   }
@@ -105,6 +128,40 @@ void addExternal(char *label, int line) {
   curExt++;
 }
 
+/*
+  Calls whenever a label of the current file is encoded in the second scan, the word holds its address so it is relocatable.
+  Adds the line of the word to relLines, the lines are added in ascending order since the words are encoded in order.
+*/
+void addRelocation(int line) {
+  *(relLines + curRel) = line;
+  curRel++;
+}
+
+/*
+  Accepts a slice and sets its amounts to the amounts of words, externals and relocations that were added so far.
+  Called before a line is encoded so outputSince can tell what the line added.
+*/
+void outputMark(outputSlice *slice) {
+  slice->wordCount = curWord;
+  slice->externalCount = curExt;
+  slice->relocationCount = curRel;
+}
+
+/*
+  Accepts a slice that was marked with outputMark.
+  Points it to the words, externals and relocations that were added since it was marked, they stay valid until more
+  are added or the output variables are freed.
+*/
+void outputSince(outputSlice *slice) {
+  slice->words = objOut + slice->wordCount;
+  slice->externalLines = extLines + slice->externalCount;
+  slice->externalLabels = extLabels + slice->externalCount;
+  slice->relocationLines = relLines + slice->relocationCount;
+  slice->wordCount = curWord - slice->wordCount;
+  slice->externalCount = curExt - slice->externalCount;
+  slice->relocationCount = curRel - slice->relocationCount;
+}
+
 /*
   Creates the .ob file and writes the instrction and data count to it.
   Loops through all of the words in objOut and write all of them to the .ob file.
@@ -130,3 +187,151 @@ void createExternalFile() {
     writeExternal(*(extLabels + i), *(extLines + i));
   }
 }
+
+/*
+  Accepts an empty buffer and builds in it the binary object of the current file, the layout is described in object.h.
+  Should be called after the second scan, before the output variables are freed.
+  The words are taken from objOut and the data table, the entries from the symbol table, the external references from extLabels and extLines
+  and the relocations from relLines.
+*/
+void buildObject(objectBuffer *buf) {
+  unsigned long header = objectReserve(buf, sizeof(objectHeader)), words, entries, symbols, references, strings, relocations, stringsSize = 0, name;
+  int entryCount = 0, symbolCount = 0, dataWords = 0, i, j;
+  symbolNodePtr cur, *externals;
+  dataNodePtr data;
+
+  for (cur = symbolHead; cur != NULL; cur = cur->next) { /* Counts the entries and externals and the size of their names */
+    if (cur->type == ENTRY || cur->type == EXTERNAL) {
+      entryCount += cur->type == ENTRY;
+      symbolCount += cur->type == EXTERNAL;
+      stringsSize += strlen(cur->label) + 1;
+    }
+  }
+  for (data = dataHead; data != NULL; data = data->next) {
+    dataWords++;
+  }
+
+  externals = malloc(sizeof(symbolNodePtr) * (symbolCount + 1)); /* Maps the index of each external in the symbols section to its node */
+  if (externals == NULL) {
+    printf("Cannot allocate memory\n");
+    exit(0);
+  }
+
+  words = objectReserve(buf, sizeof(unsigned short) * (curWord + dataWords));
+  entries = objectReserve(buf, sizeof(objectEntry) * entryCount);
+  symbols = objectReserve(buf, sizeof(objectSymbol) * symbolCount);
+  references = objectReserve(buf, sizeof(objectReference) * curExt);
+  strings = objectReserve(buf, stringsSize);
+  relocations = objectReserve(buf, sizeof(unsigned short) * curRel);
+
+  for (i = 0; i < curWord; i++) {
+    objectPut16(buf, words + i * sizeof(unsigned short), *(objOut + i) & OBJECT_WORD_MASK);
+  }
+  for (data = dataHead; data != NULL; data = data->next, i++) {
+    objectPut16(buf, words + i * sizeof(unsigned short), data->val & OBJECT_WORD_MASK);
+  }
+
+  for (cur = symbolHead, name = 0, i = j = 0; cur != NULL; cur = cur->next) { /* Writes the names and the entries and symbols that point to them */
+    if (cur->type == ENTRY) {
+      objectPut32(buf, entries + i * sizeof(objectEntry) + offsetof(objectEntry, name), name);
+      objectPut32(buf, entries + i * sizeof(objectEntry) + offsetof(objectEntry, address), cur->val);
+      i++;
+    } else if (cur->type == EXTERNAL) {
+      objectPut32(buf, symbols + j * sizeof(objectSymbol) + offsetof(objectSymbol, name), name);
+      externals[j++] = cur;
+    } else {
+      continue;
+    }
+    strcpy((char *) buf->data + strings + name, cur->label);
+    name += strlen(cur->label) + 1;
+  }
+
+  for (i = 0; i < curExt; i++) {
+    for (j = 0; j < symbolCount && externals[j]->label != *(extLabels + i); j++); /* extLabels point to the labels of the nodes */
+    objectPut16(buf, references + i * sizeof(objectReference) + offsetof(objectReference, address), *(extLines + i));
+    objectPut16(buf, references + i * sizeof(objectReference) + offsetof(objectReference, symbol), j);
+  }
+  free(externals);
+
+  for (i = 0; i < curRel; i++) {
+    objectPut16(buf, relocations + i * sizeof(unsigned short), *(relLines + i));
+  }
+
+  memcpy(buf->data + header, OBJECT_MAGIC, sizeof(((objectHeader *) 0)->magic));
+  objectPut16(buf, header + offsetof(objectHeader, version), OBJECT_VERSION);
+  objectPut16(buf, header + offsetof(objectHeader, headerSize), sizeof(objectHeader));
+  objectPut32(buf, header + offsetof(objectHeader, base), MEMORY_BASE);
+  objectPut32(buf, header + offsetof(objectHeader, codeWords), curWord);
+  objectPut32(buf, header + offsetof(objectHeader, dataWords), dataWords);
+  objectPut32(buf, header + offsetof(objectHeader, entryCount), entryCount);
+  objectPut32(buf, header + offsetof(objectHeader, symbolCount), symbolCount);
+  objectPut32(buf, header + offsetof(objectHeader, referenceCount), curExt);
+  objectPut32(buf, header + offsetof(objectHeader, stringsSize), stringsSize);
+  objectPut32(buf, header + offsetof(objectHeader, wordsOffset), words);
+  objectPut32(buf, header + offsetof(objectHeader, entriesOffset), entries);
+  objectPut32(buf, header + offsetof(objectHeader, symbolsOffset), symbols);
+  objectPut32(buf, header + offsetof(objectHeader, referencesOffset), references);
+  objectPut32(buf, header + offsetof(objectHeader, stringsOffset), strings);
+  objectPut32(buf, header + offsetof(objectHeader, relocationCount), curRel);
+  objectPut32(buf, header + offsetof(objectHeader, relocationsOffset), relocations);
+  objectPut32(buf, header + offsetof(objectHeader, fileSize), buf->size);
+}
+
+/*
+  Builds the binary object of the current file once and writes it to each of the binary outputs that were requested:
+  the .bo file, a POSIX shared memory object and a sealed memfd that is sent to the consumer.
+*/
+void createBinaryOutputs() {
+  objectBuffer buf;
+
+  objectInit(&buf);
+  buildObject(&buf);
+
+  if (hasOption(BINARY_OPTION)) {
+    writeBinaryObject(buf.data, buf.size);
+  }
+  if (hasOption(SHM_OPTION)) {
+    shareObject(shmPrefix, fileName, &buf);
+  }
+  if (hasOption(MEMFD_OPTION)) {
+    sendObject(atoi(memfdSocket), fileName, &buf);
+  }
+
+  objectFree(&buf);
+}
+
+/*
+  Appends the symbols of the current file to the symbol index that was given with --index.
+  Every label of the file is added with its final address(entries are marked as such), and every use of an external with
+  the line of the word that uses it.
+*/
+void createIndexRecords() {
+  symbolNodePtr cur;
+  indexSymbol *symbols;
+  int count = curExt, i = 0;
+
+  for (cur = symbolHead; cur != NULL; cur = cur->next) {
+    count += cur->type == COMMAND || cur->type == GUIDANCE || cur->type == ENTRY;
+  }
+
+  if ((symbols = malloc(sizeof(indexSymbol) * (count + 1))) == NULL) {
+    printf("Cannot allocate memory\n");
+    exit(0);
+  }
+
+  for (cur = symbolHead; cur != NULL; cur = cur->next) {
+    if (cur->type == COMMAND || cur->type == GUIDANCE || cur->type == ENTRY) {
+      symbols[i].name = cur->label;
+      symbols[i].address = cur->val;
+      symbols[i++].kind = cur->type == ENTRY ? ENTRY_RECORD : DEFINED_RECORD;
+    }
+  }
+  for (; i < count; i++) {
+    symbols[i].name = *(extLabels + i - (count - curExt));
+    symbols[i].address = *(extLines + i - (count - curExt));
+    symbols[i].kind = USE_RECORD;
+  }
+
+  indexAppend(indexPath, fileName, symbols, count);
+  free(symbols);
+}
@@ -1,10 +1,22 @@
 #ifndef OUTPUT_H
 #define OUTPUT_H
 
+#include "./object.h" /* Included here so I can use objectBuffer in some functions prototypes */
+
+typedef struct outputSlice { /* What was added to the output from a point on, used by the incremental reassembly(see incremental.h) */
+  int *words, *externalLines, *relocationLines; /* The lines of the externals and relocations are the addresses of their words */
+  char **externalLabels;
+  int wordCount, externalCount, relocationCount;
+} outputSlice;
+
 void initOutputVars(void); /* After the first scan we want to initialize some variables in this file */
 void freeOutputVars(void); /* After writing the compiled code we want to free some memory that was located to variable that held the words that were needed to be written */
 void createOutput(); /* Creates the compiled files */
 void addWords(int words[], int wordCount); /* Accepts an array of words and the length of the array and adds the words to a variable that stores all the words to be written */
 void addExternal(char *label, int line); /* Each time an external is used in the source code this function is called with the external name and the line of usage */
+void addRelocation(int line); /* Each time a label of the current file is encoded this function is called with the line of the relocatable word */
+void outputMark(outputSlice *slice); /* Remembers in a slice the amounts that were added to the output so far */
+void outputSince(outputSlice *slice); /* Points a slice that was marked to what was added to the output since */
+void buildObject(objectBuffer *buf); /* Builds the binary object of the current file in an empty buffer, called after the second scan */
 
 #endif
@@ -0,0 +1,579 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "./peephole.h"
+#include "./command.h"
+#include "./commandUtils.h"
+#include "./data.h"
+#include "./utils.h"
+#include "./strings.h"
+#include "./status.h"
+#include "./files.h"
+#include "./options.h"
+#include "./cfg.h"
+#include "./deadData.h"
+#include "./stringPool.h"
+
+/*
+  This file holds the peephole optimizer and the folding of constant indexes, see peephole.h, the control flow analysis
+  is in cfg.c, the dead data elimination in deadData.c and the string pooling in stringPool.c.
+  Each rule looks at an instruction and the instruction that follows it(ignoring the removed ones) and returns the amount
+  of words it saved by removing or rewriting them. The rules are applied until none of them saves a word, so a rule may
+  apply to instructions that were brought together by another one.
+*/
+
+#define INSTRUCTIONS_CHUNK 256 /* The amount of lines the array of lines grows by */
+
+typedef struct peepholeRule {
+  char *name; /* Describes what the rule removes in the report */
+  int (*apply)(peepholeLine *cur, peepholeLine *next); /* Returns the amount of words saved, next is NULL for the last instruction */
+  int saved; /* The amount of words the rule saved in the current file */
+} peepholeRule;
+
+static peepholeLine *lines; /* The instruction lines of the current file in their order */
+static int lineCount, lineCapacity, current; /* current is the next line of the second scan */
+static char **entries; /* The labels given to .entry */
+static int entryCount, entryCapacity;
+static int folding; /* Constant indexes are folded in the current file, set after the first scan */
+static int scanStart; /* lineIndex before the first scan, it keeps counting through both scans */
+static int numericJumps; /* A jump of the current file has an immediate value or a macro as its target, see peepholeAdd */
+
+/*
+  Returns a copy of a string without the spaces around it.
+*/
+static char *trimmed(char *str, int length) {
+  char *copy;
+
+  while (length > 0 && isspace(*str)) {
+    str++;
+    length--;
+  }
+  while (length > 0 && isspace(str[length - 1])) {
+    length--;
+  }
+
+  copy = lalloc();
+  strncpy(copy, str, length);
+  copy[length] = '\0';
+  return copy;
+}
+
+/*
+  Checks wether every instruction line is recorded, for --optimize(and its control flow analysis), --dead-data or
+  --pool-strings.
+*/
+static int recordsAll() {
+  return hasOption(OPTIMIZE_OPTION) || hasOption(DEAD_DATA_OPTION) || hasOption(POOL_STRINGS_OPTION);
+}
+
+/*
+  Accepts the label of a line(or NULL), its command, the rest of the line after the command and the IC of the line.
+  Records the line with its operands, it is called before handleFirstCommand changes the line.
+  Every line is recorded for --optimize, --dead-data and --pool-strings, otherwise only the
+  lines that may have an array operand to fold are. Jumps to a numeric address are noted either way, removing
+  instructions or folding indexes moves the instructions after them, so neither is done in that file.
+*/
+void peepholeAdd(char *label, char *command, char *args, int address) {
+  commandPtr comm = getCommand(command);
+  peepholeLine *cur;
+  char *comma;
+
+  if (comm != NULL && (comm->flags & BRANCH)) {
+    for (comma = args; isspace(*comma); comma++)
+      ;
+    numericJumps |= *comma == '#'; /* An immediate value or a macro */
+  }
+  if (!recordsAll() && (hasOption(NO_FOLD_OPTION) || strchr(args, '[') == NULL)) {
+    return;
+  }
+  if (lineCount == lineCapacity) {
+    lineCapacity += INSTRUCTIONS_CHUNK;
+    if ((lines = realloc(lines, sizeof(peepholeLine) * lineCapacity)) == NULL) {
+      printf("Cannot allocate memory\n");
+      exit(0);
+    }
+  }
+
+  cur = &lines[lineCount++];
+  memset(cur, 0, sizeof(peepholeLine));
+  cur->label = label != NULL ? copyString(label) : NULL;
+  cur->command = copyString(command);
+  cur->line = lineIndex;
+  cur->address = address;
+
+  while (cur->argCount < MAX_ARGS && *args != '\0' && *args != '\n') {
+    for (comma = args; *comma != '\0' && *comma != ','; comma++)
+      ;
+    cur->args[cur->argCount] = trimmed(args, comma - args);
+    if (*cur->args[cur->argCount] == '\0') { /* Only spaces were left */
+      free(cur->args[cur->argCount]);
+      break;
+    }
+    cur->argCount++;
+    args = *comma == ',' ? comma + 1 : comma;
+  }
+}
+
+/*
+  Accepts the rest of an .entry line and records its label.
+*/
+void peepholeEntry(char *line) {
+  char *end;
+
+  if (!recordsAll()) {
+    return;
+  }
+  while (isspace(*line)) {
+    line++;
+  }
+  for (end = line; *end != '\0' && !isspace(*end); end++)
+    ;
+
+  if (entryCount == entryCapacity) {
+    entryCapacity += INSTRUCTIONS_CHUNK;
+    if ((entries = realloc(entries, sizeof(char *) * entryCapacity)) == NULL) {
+      printf("Cannot allocate memory\n");
+      exit(0);
+    }
+  }
+  entries[entryCount++] = trimmed(line, end - line);
+}
+
+/*
+  Frees the recorded lines and entries of the previous file, called before the first scan of every file.
+*/
+void peepholeFree() {
+  int i, j;
+
+  for (i = 0; i < lineCount; i++) {
+    free(lines[i].label);
+    free(lines[i].command);
+    free(lines[i].text);
+    for (j = 0; j < lines[i].argCount; j++) {
+      free(lines[i].args[j]);
+    }
+  }
+  for (i = 0; i < entryCount; i++) {
+    free(entries[i]);
+  }
+  lineCount = entryCount = current = folding = numericJumps = 0;
+  stringPoolFree();
+  scanStart = lineIndex;
+}
+
+/*
+  Returns the symbol of an operand that is a label or an array, NULL for other operands or undeclared labels.
+*/
+symbolNodePtr peepholeSymbol(char *arg) {
+  char name[LINE_MAX], *bracket;
+  int type = getArgType(arg);
+
+  if (type != LABEL && type != ARR) {
+    return NULL;
+  }
+  strcpy(name, arg);
+  if ((bracket = strchr(name, '[')) != NULL) {
+    *bracket = '\0';
+  }
+  return symbolNodeByLabel(name);
+}
+
+/*
+  Returns the index of an array operand, a number or a macro that was validated on the first scan, 0 for other operands.
+*/
+int peepholeIndex(char *arg) {
+  char *bracket = strchr(arg, '['), index[LINE_MAX], *end;
+  symbolNodePtr mac;
+  int val = 0;
+
+  if (getArgType(arg) != ARR || bracket == NULL) {
+    return 0;
+  }
+  strcpy(index, bracket + 1);
+  if ((end = strchr(index, ']')) != NULL) {
+    *end = '\0';
+  }
+  if (parseNumber(index, WORD_MIN, WORD_MAX, &val, &end) == OK_STATUS && *end == '\0') {
+    return val;
+  }
+  return (mac = symbolNodeByLabel(index)) != NULL && mac->type == MACRO ? mac->val : 0;
+}
+
+/*
+  Accepts an array operand(LABEL[index]), the command it is given to and its position(0 for the first operand).
+  The index of an array is a number or a macro, so once the labels are known so is the address of the element, and it
+  can be encoded as a single direct operand word instead of the word of the label and the word of the index.
+  That is done when the command accepts a direct operand in that position and the label is of this file, the address
+  of an external is only known when the file is linked.
+  Returns wether the operand is folded.
+*/
+int peepholeFolds(char *arr, commandPtr comm, int position) {
+  symbolNodePtr node;
+  int modes;
+
+  if (!folding || comm == NULL || (node = peepholeSymbol(arr)) == NULL || node->type == EXTERNAL ||
+      node->type == MACRO) {
+    return 0;
+  }
+
+  modes = position == 0 ? comm->dest : comm->src; /* The first operand is validated against dest, see valAddressMode */
+  return (modes & (1 << DIRECT)) != 0;
+}
+
+/*
+  Returns the amount of words an operand of a command takes when it is not a register that shares a word.
+*/
+static int operandWords(char *arg, char *command, int position) {
+  return getArgType(arg) == ARR && !peepholeFolds(arg, getCommand(command), position) ? 2 : 1;
+}
+
+/*
+  Checks wether an operand is the immediate value 0, a number or a macro.
+*/
+static int isZero(char *arg) {
+  symbolNodePtr mac;
+  char *end;
+  int val;
+
+  switch (getArgType(arg)) {
+    case IVAL:
+      return parseNumber(arg + 1, IMMEDIATE_MIN, IMMEDIATE_MAX, &val, &end) == OK_STATUS && *end == '\0' && val == 0;
+    case MAC:
+      mac = symbolNodeByLabel(arg + 1);
+      return mac != NULL && mac->type == MACRO && mac->val == 0;
+    default:
+      return 0;
+  }
+}
+
+/*
+  Checks wether an operand may be written to, registers, labels and arrays.
+*/
+static int isWritable(char *arg) {
+  int type = getArgType(arg);
+
+  return type == REG || type == LABEL || type == ARR;
+}
+
+/*
+  Returns the first line that is not removed at or after an index, or NULL.
+*/
+static peepholeLine *nextLine(int i) {
+  for (; i < lineCount; i++) {
+    if (lines[i].words > 0) {
+      return &lines[i];
+    }
+  }
+  return NULL;
+}
+
+/*
+  Returns the index of the first line at or after an address, lineCount if there is none.
+*/
+static int firstLineAt(int address) {
+  int low = 0, high = lineCount;
+
+  while (low < high) { /* The lines are in the order of their addresses */
+    int mid = (low + high) / 2;
+
+    if (lines[mid].address < address) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+/*
+  Returns the first line that is not removed at or after an address, or NULL.
+*/
+static peepholeLine *lineAt(int address) {
+  return nextLine(firstLineAt(address));
+}
+
+/*
+  Removes a line, returns the amount of words saved.
+*/
+static int removeLine(peepholeLine *cur) {
+  int words = cur->words;
+
+  cur->words = 0;
+  return words;
+}
+
+/*
+  mov X, X does nothing.
+*/
+static int selfMove(peepholeLine *cur, peepholeLine *next) {
+  if (strcmp(cur->command, "mov") == 0 && cur->argCount == 2 && strcmp(cur->args[0], cur->args[1]) == 0 &&
+      isWritable(cur->args[0])) {
+    return removeLine(cur);
+  }
+  return 0;
+}
+
+/*
+  jmp and bne to the instruction that follows them don't change where the program continues.
+*/
+static int jumpToNext(peepholeLine *cur, peepholeLine *next) {
+  symbolNodePtr node;
+
+  if ((strcmp(cur->command, "jmp") != 0 && strcmp(cur->command, "bne") != 0) || cur->argCount != 1 || next == NULL ||
+      getArgType(cur->args[0]) != LABEL) {
+    return 0;
+  }
+  node = symbolNodeByLabel(cur->args[0]);
+  if (node != NULL && node->type == COMMAND && lineAt(node->val) == next) {
+    return removeLine(cur);
+  }
+  return 0;
+}
+
+/*
+  add #0, X and sub #0, X don't change X.
+*/
+static int addZero(peepholeLine *cur, peepholeLine *next) {
+  if ((strcmp(cur->command, "add") == 0 || strcmp(cur->command, "sub") == 0) && cur->argCount == 2 &&
+      isZero(cur->args[0]) && isWritable(cur->args[1])) {
+    return removeLine(cur);
+  }
+  return 0;
+}
+
+/*
+  inc X followed by dec X(or dec followed by inc) leave X as it was.
+  The second instruction must not have a label, a jump to it would run only one of them.
+*/
+static int incDec(peepholeLine *cur, peepholeLine *next) {
+  if (next == NULL || next->label != NULL || next->fixed || cur->argCount != 1 || next->argCount != 1 ||
+      strcmp(cur->args[0], next->args[0]) != 0 || !isWritable(cur->args[0])) {
+    return 0;
+  }
+  if ((strcmp(cur->command, "inc") == 0 && strcmp(next->command, "dec") == 0) ||
+      (strcmp(cur->command, "dec") == 0 && strcmp(next->command, "inc") == 0)) {
+    return removeLine(cur) + removeLine(next);
+  }
+  return 0;
+}
+
+/*
+  Two inc X(or dec X) are rewritten to a single add #2, X(or sub #2, X).
+  The second instruction must not have a label, a jump to it would run only one of them.
+*/
+static int incTwice(peepholeLine *cur, peepholeLine *next) {
+  int words, total;
+
+  if (next == NULL || next->label != NULL || next->fixed || cur->argCount != 1 || next->argCount != 1 ||
+      strcmp(cur->args[0], next->args[0]) != 0 || strcmp(cur->command, next->command) != 0 ||
+      (strcmp(cur->command, "inc") != 0 && strcmp(cur->command, "dec") != 0) || !isWritable(cur->args[0])) {
+    return 0;
+  }
+
+  total = cur->words + next->words;
+  words = 2 + operandWords(cur->args[0], strcmp(next->command, "inc") == 0 ? "add" : "sub", 1); /* The command word, the immediate and the operand */
+  if (words >= total) {
+    return 0;
+  }
+
+  cur->args[1] = cur->args[0];
+  cur->args[0] = copyString("#2");
+  cur->argCount = 2;
+  free(cur->command);
+  cur->command = copyString(strcmp(next->command, "inc") == 0 ? "add" : "sub");
+  cur->rewritten = 1;
+  cur->words = words;
+  removeLine(next);
+  return total - words;
+}
+
+/*
+  The rules in the order they are tried on every instruction.
+*/
+static peepholeRule rules[] = {
+  { "mov to itself", selfMove },
+  { "jump to the next instruction", jumpToNext },
+  { "add or sub of 0", addZero },
+  { "inc and dec", incDec },
+  { "inc or dec twice", incTwice }
+};
+
+/*
+  Checks wether an operand indexes an array of instructions(LABEL[i] with a label of an instruction).
+  Such an operand reaches an instruction by its distance from another one, which both removing instructions and
+  folding the indexes of the instructions between them would change, so neither is done in that file.
+*/
+static int indexesInstructions() {
+  int i, k;
+
+  for (i = 0; i < lineCount; i++) {
+    for (k = 0; k < lines[i].argCount; k++) {
+      symbolNodePtr node = peepholeSymbol(lines[i].args[k]);
+
+      if (node != NULL && node->type == COMMAND && getArgType(lines[i].args[k]) == ARR) {
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+/*
+  Marks the lines that must stay as they are: lines with a label that is an entry and lines that use an external.
+*/
+static void markFixed() {
+  int i, j, k;
+
+  for (i = 0; i < lineCount; i++) {
+    for (j = 0; lines[i].label != NULL && j < entryCount; j++) {
+      if (strcmp(lines[i].label, entries[j]) == 0) {
+        lines[i].fixed = 1;
+      }
+    }
+    for (k = 0; k < lines[i].argCount; k++) {
+      symbolNodePtr node = peepholeSymbol(lines[i].args[k]);
+
+      if (node != NULL && node->type == EXTERNAL) {
+        lines[i].fixed = 1;
+      }
+    }
+  }
+}
+
+/*
+  Returns the amount of words saved by the lines before an address.
+*/
+static int savedBefore(int address) {
+  int i = firstLineAt(address);
+
+  return i > 0 ? lines[i - 1].saved : 0;
+}
+
+/*
+  Called after the first scan.
+  Folds the constant indexes unless --no-fold was given. With --optimize it runs the control flow analysis unless
+  --no-cfg was given, which prints its own report, and then applies the rules to every instruction until none of them
+  saves a word and prints a report of the words saved by every rule. With --dead-data it removes
+  the data that the remaining instructions don't use and with --pool-strings it shares the strings that are suffixes
+  of other strings.
+  Moves the label of every instruction back by the words saved before it and updates IC to the new amount of
+  instruction words. Returns the amount of words saved.
+*/
+int peepholeOptimize() {
+  int i, j, k, saved = 0, folded = 0, flow = 0, changed = 1, optimize = hasOption(OPTIMIZE_OPTION) != 0,
+  instructionArrays = indexesInstructions();
+
+  folding = !hasOption(NO_FOLD_OPTION) && !instructionArrays && !numericJumps;
+  for (j = 0; j < sizeof(rules) / sizeof(peepholeRule); j++) {
+    rules[j].saved = 0;
+  }
+  for (i = 0; i < lineCount; i++) {
+    lines[i].line += lineIndex - scanStart; /* The second scan counts the lines of the file again */
+    for (k = 0; k < lines[i].argCount; k++) {
+      if (getArgType(lines[i].args[k]) == ARR && peepholeFolds(lines[i].args[k], getCommand(lines[i].command), k)) {
+        lines[i].folded++; /* The word of the index is not encoded */
+      }
+    }
+    lines[i].words = (i + 1 < lineCount ? lines[i + 1].address : IC) - lines[i].address - lines[i].folded; /* Only when every line is recorded */
+    folded += lines[i].folded;
+  }
+
+  if (hasOption(OPTIMIZE_OPTION) && !hasOption(NO_CFG_OPTION)) {
+    flow = cfgOptimize(lines, lineCount, entries, entryCount); /* Removes the unreachable lines before the rules look at them */
+  }
+  if (optimize && instructionArrays) {
+    printf("\n%s: an array of instructions is used, the peephole optimizer is not applied\n", fileName);
+    optimize = 0;
+  } else if (optimize && numericJumps) {
+    printf("\n%s: a jump to a numeric address is used, the peephole optimizer is not applied\n", fileName);
+    optimize = 0;
+  }
+  if (optimize) {
+    markFixed();
+  }
+
+  while (optimize && changed) {
+    changed = 0;
+    for (i = 0; i < lineCount; i++) {
+      for (j = 0; lines[i].words > 0 && !lines[i].fixed && j < sizeof(rules) / sizeof(peepholeRule); j++) {
+        int words = rules[j].apply(&lines[i], nextLine(i + 1));
+
+        rules[j].saved += words;
+        saved += words;
+        changed |= words > 0;
+      }
+    }
+  }
+
+  for (i = 0; i < lineCount; i++) {
+    lines[i].saved = recordsAll() ? (i + 1 < lineCount ? lines[i + 1].address : IC) - lines[i].address - lines[i].words :
+      lines[i].folded;
+    lines[i].saved += i > 0 ? lines[i - 1].saved : 0;
+  }
+  saved += folded;
+  if (saved + flow > 0) {
+    symbolNodePtr node;
+
+    for (node = symbolHead; node != NULL; node = node->next) { /* Labels of removed lines move to the next instruction */
+      if (node->type == COMMAND) {
+        node->val -= savedBefore(node->val);
+      }
+    }
+    IC -= saved + flow;
+  }
+  if (hasOption(DEAD_DATA_OPTION)) {
+    deadDataRemove(lines, lineCount, entries, entryCount); /* After the rules, so removed instructions don't keep data */
+  }
+  if (hasOption(POOL_STRINGS_OPTION)) {
+    stringPoolMerge(lines, lineCount, entries, entryCount);
+  }
+
+  if (optimize) {
+    printf("\n%s: the peephole optimizer saved %d words", fileName, saved);
+    if (folded > 0) {
+      printf(", %d by folding constant indexes", folded);
+    }
+    for (j = 0; j < sizeof(rules) / sizeof(peepholeRule); j++) {
+      if (rules[j].saved > 0) {
+        printf(", %d by %s", rules[j].saved, rules[j].name);
+      }
+    }
+    printf("\n");
+  }
+  return saved + flow;
+}
+
+/*
+  Accepts pointers to the command of an instruction line of the second scan and to the rest of the line.
+  Returns 0 if the line was removed and shouldn't be encoded, otherwise returns 1 and points them to the command and
+  the operands of the rewritten line when the line was rewritten.
+*/
+int peepholeRewrite(char **command, char **line) {
+  peepholeLine *cur;
+  int i;
+
+  while (current < lineCount && lines[current].line < lineIndex) {
+    current++;
+  }
+  if (current >= lineCount || lines[current].line != lineIndex) { /* The line was not recorded */
+    return 1;
+  }
+  cur = &lines[current++];
+
+  if (cur->words == 0) {
+    return 0;
+  }
+  if (cur->rewritten) {
+    free(cur->text);
+    cur->text = lalloc();
+    *cur->text = '\0';
+    for (i = 0; i < cur->argCount; i++) {
+      strcat(cur->text, i > 0 ? ", " : "");
+      strcat(cur->text, cur->args[i]);
+    }
+    *command = cur->command;
+    *line = cur->text;
+  }
+  return 1;
+}
@@ -0,0 +1,50 @@
+#ifndef PEEPHOLE_H
+#define PEEPHOLE_H
+
+/*
+  An optional optimization stage between the first scan and the encoding of the second scan(--optimize).
+  The first scan records every instruction line, after it a table of rules removes or rewrites instructions that don't
+  change what the program does, the addresses of the labels of the instructions are moved back by the words that were
+  saved before them and the second scan encodes the rewritten lines instead of the source code lines.
+  Instructions that hold a label that is an entry or that use an external are never removed or rewritten.
+
+  The same stage folds constant indexes, unless --no-fold is given: an array operand(LABEL[2], LABEL[SIZE]) whose label
+  is of the file and whose command accepts a direct operand in that position is encoded as a single relocatable direct
+  operand word that holds the address of the element, instead of the word of the label and the word of the index.
+  The first scan counts the 2 words of the index address mode, the lines with array operands are recorded so the
+  labels can be moved back once the externals are known. A file that indexes an array of instructions is not folded.
+
+  Before the rules, the control flow analysis of cfg.h removes unreachable instructions and threads jumps, unless
+  --no-cfg is given.
+*/
+
+struct command; /* See command.h */
+struct symbolNode; /* See data.h */
+
+#define MAX_ARGS 2 /* The most operands an instruction has */
+
+typedef struct peepholeLine { /* An instruction line that was recorded in the first scan */
+  char *label, /* NULL if the line has no label */
+  *command,
+  *args[MAX_ARGS],
+  *text; /* The operands of a rewritten line as they are given to the second scan */
+  int argCount,
+  line, /* lineIndex of the line, moved to the one of the second scan after the first scan */
+  address, /* The address the first scan gave the instruction */
+  words, /* The amount of words of the instruction, 0 once it is removed */
+  folded, /* The amount of words saved by folding constant indexes of the source code line */
+  saved, /* The amount of words saved by this line and the lines before it */
+  rewritten, /* The command and the operands are not the ones of the source code line */
+  fixed; /* The instruction must stay as it is, it holds an entry or uses an external */
+} peepholeLine;
+
+void peepholeAdd(char *label, char *command, char *args, int address); /* Records an instruction line of the first scan, called before handleFirstCommand */
+void peepholeEntry(char *line); /* Records the label of an .entry line of the first scan */
+int peepholeOptimize(void); /* Folds constant indexes, runs the control flow analysis, applies the rules of --optimize to the recorded lines and updates the symbol table and IC, returns the amount of words saved */
+int peepholeFolds(char *arr, struct command *comm, int position); /* Checks wether an array operand is encoded as a direct operand, position is 0 for the first operand */
+struct symbolNode *peepholeSymbol(char *arg); /* Returns the symbol of an operand that is a label or an array, NULL for other operands */
+int peepholeIndex(char *arg); /* Returns the index of an array operand, 0 for other operands */
+int peepholeRewrite(char **command, char **line); /* Replaces an instruction line of the second scan with its rewritten one, returns 0 if the line was removed */
+void peepholeFree(void); /* Frees the recorded lines of the previous file */
+
+#endif
@@ -0,0 +1,173 @@
+#define _POSIX_C_SOURCE 199309L /* Required for clock_gettime */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "./profile.h"
+
+/*
+  This file is only compiled when PROFILE is defined.
+  Holds the counters and the recorded trace events, and writes them as Chrome trace-event JSON.
+*/
+
+#define EVENTS_CHUNK 1024 /* The amount of events the events array grows by each time it is full */
+
+typedef struct traceEvent { /* A single span or counters event */
+  char *name; /* The name of the span, NULL for counter events */
+  char phase; /* 'B' for the beginning of a span, 'E' for its end and 'C' for counters */
+  double ts; /* Timestamp in microseconds from the start of the program */
+  long counters[COUNTER_AMOUNT]; /* For counter events, the values of the counters at that time */
+  long opcodes[OPCODE_AMOUNT]; /* For counter events, the values of the instruction histogram at that time */
+} traceEvent;
+
+/* The names of the counters as they will show in the trace, in the order of enum COUNTER */
+static char *counterNames[COUNTER_AMOUNT] = {
+  "symbolLookups", "symbolProbes", "commandLookups", "copyStringAllocs", "copyStringBytes",
+  "lallocAllocs", "lallocBytes", "nodeAllocs", "nodeBytes", "countArgsChars", "includeParses",
+  "includeHits"
+};
+
+static long counters[COUNTER_AMOUNT]; /* The current value of each counter */
+static long opcodes[OPCODE_AMOUNT]; /* The amount of instructions seen for each opcode */
+static char *opcodeNames[OPCODE_AMOUNT]; /* The name of each opcode, filled as opcodes are seen */
+static traceEvent *events; /* All of the recorded events */
+static int eventCount, eventSize; /* The amount of recorded events and the allocated size of events */
+static struct timespec start; /* The time of the first recorded event */
+
+/*
+  Returns the amount of microseconds that passed since the first call to this function.
+*/
+static double now() {
+  struct timespec cur;
+
+  if (start.tv_sec == 0 && start.tv_nsec == 0) {
+    clock_gettime(CLOCK_MONOTONIC, &start);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &cur);
+
+  return (cur.tv_sec - start.tv_sec) * 1e6 + (cur.tv_nsec - start.tv_nsec) / 1e3;
+}
+
+/*
+  Returns a pointer to a new event at the end of the events array, grows the array if it is full.
+*/
+static traceEvent *newEvent() {
+  if (eventCount == eventSize) {
+    eventSize += EVENTS_CHUNK;
+    events = (traceEvent *) realloc(events, sizeof(traceEvent) * eventSize);
+
+    if (events == NULL) {
+      printf("Cannot allocate memory\n");
+      exit(0);
+    }
+  }
+
+  return &events[eventCount++];
+}
+
+void profileAdd(int counter, long n) {
+  counters[counter] += n;
+}
+
+void profileAddOpcode(int opcode, char *name) {
+  if (opcode >= 0 && opcode < OPCODE_AMOUNT) {
+    opcodes[opcode]++;
+    opcodeNames[opcode] = name;
+  }
+}
+
+void profileSpan(char *name, char phase) {
+  double ts = now(); /* Taken before the event is allocated so the allocation is not part of the span */
+  traceEvent *event = newEvent();
+
+  event->name = name;
+  event->phase = phase;
+  event->ts = ts;
+}
+
+void profileCounters() {
+  int i;
+  traceEvent *event = newEvent();
+
+  event->name = NULL;
+  event->phase = 'C';
+  event->ts = now();
+
+  for (i = 0; i < COUNTER_AMOUNT; i++) {
+    event->counters[i] = counters[i];
+  }
+  for (i = 0; i < OPCODE_AMOUNT; i++) {
+    event->opcodes[i] = opcodes[i];
+  }
+}
+
+/*
+  Writes a span name as a JSON string, escaping the characters that JSON requires to be escaped.
+*/
+static void writeName(FILE *fp, char *name) {
+  putc('"', fp);
+  for (; *name; name++) {
+    if (*name == '"' || *name == '\\') {
+      putc('\\', fp);
+    }
+    putc(*name, fp);
+  }
+  putc('"', fp);
+}
+
+/*
+  Writes a single counter event as 3 trace events: the raw counters, the average probes per symbol lookup and the
+  instruction histogram. Each of them is shown as a separate counter track.
+*/
+static void writeCounters(FILE *fp, traceEvent *event) {
+  int i, first = 1;
+  long lookups = event->counters[SYMBOL_LOOKUPS];
+
+  fprintf(fp, "{\"name\":\"counters\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"tid\":1,\"args\":{", event->ts);
+  for (i = 0; i < COUNTER_AMOUNT; i++) {
+    fprintf(fp, "%s\"%s\":%ld", i ? "," : "", counterNames[i], event->counters[i]);
+  }
+  fprintf(fp, "}},\n");
+
+  fprintf(fp, "{\"name\":\"perLookup\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"tid\":1,\"args\":{", event->ts);
+  fprintf(fp, "\"probes\":%.3f}},\n", lookups ? (double) event->counters[SYMBOL_PROBES] / lookups : 0.0);
+
+  fprintf(fp, "{\"name\":\"opcodes\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"tid\":1,\"args\":{", event->ts);
+  for (i = 0; i < OPCODE_AMOUNT; i++) {
+    if (opcodeNames[i] != NULL) {
+      fprintf(fp, "%s\"%s\":%ld", first ? "" : ",", opcodeNames[i], event->opcodes[i]);
+      first = 0;
+    }
+  }
+  fprintf(fp, "}}");
+}
+
+void profileWriteTrace(char *traceFile) {
+  FILE *fp = fopen(traceFile, "w");
+  int i;
+
+  if (fp == NULL) {
+    printf("Cannot open file %s\n", traceFile);
+    return;
+  }
+
+  profileCounters(); /* The final values of the counters */
+
+  fprintf(fp, "{\"traceEvents\":[\n");
+  for (i = 0; i < eventCount; i++) {
+    if (events[i].phase == 'C') {
+      writeCounters(fp, &events[i]);
+    } else {
+      fprintf(fp, "{\"name\":");
+      writeName(fp, events[i].name);
+      fprintf(fp, ",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":1}", events[i].phase, events[i].ts);
+    }
+    fprintf(fp, "%s\n", i < eventCount - 1 ? "," : "");
+  }
+  fprintf(fp, "],\"displayTimeUnit\":\"ms\"}\n");
+
+  fclose(fp);
+  free(events);
+  events = NULL;
+  eventCount = eventSize = 0;
+}
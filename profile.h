@@ -0,0 +1,58 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+/*
+  Optional instrumentation of the hot functions of the assembler.
+  When the project is compiled with -DPROFILE (see the 'profile' target in the makefile) the macros below
+  count events and record scoped spans, and when the program exits they are written as a Chrome trace-event
+  JSON file that can be opened with Perfetto or chrome://tracing.
+  When PROFILE is not defined every macro expands to nothing, so the release build is not affected at all.
+*/
+
+#define TRACE_FILE "assembler.trace.json" /* The name of the trace file that is written to the current working directory */
+#define OPCODE_AMOUNT 16 /* The amount of opcodes, used for the instruction histogram */
+
+enum COUNTER /* Types of events that are counted */
+{
+  SYMBOL_LOOKUPS, /* Calls to symbolNodeByLabel */
+  SYMBOL_PROBES, /* Nodes visited by symbolNodeByLabel, a string compare is made for each */
+  COMMAND_LOOKUPS, /* Calls to getCommand */
+  STRING_ALLOCS, /* Allocations made by copyString */
+  STRING_BYTES, /* Bytes allocated by copyString */
+  LINE_ALLOCS, /* Allocations made by lalloc */
+  LINE_BYTES, /* Bytes allocated by lalloc */
+  NODE_ALLOCS, /* Allocations of symbol and data nodes */
+  NODE_BYTES, /* Bytes allocated for symbol and data nodes */
+  ARG_CHARS, /* Characters scanned by countArgs */
+  INCLUDE_PARSES, /* Included files that were parsed, see include.h */
+  INCLUDE_HITS, /* Included files that were taken from the cache */
+  COUNTER_AMOUNT
+};
+
+#ifdef PROFILE
+
+#define profileCount(counter, n) profileAdd(counter, n)
+#define profileOpcode(opcode, name) profileAddOpcode(opcode, name)
+#define profileBegin(name) profileSpan(name, 'B')
+#define profileEnd(name) profileSpan(name, 'E')
+#define profileSnapshot() profileCounters()
+#define profileWrite() profileWriteTrace(TRACE_FILE)
+
+void profileAdd(int counter, long n); /* Adds n to the given counter(enum COUNTER) */
+void profileAddOpcode(int opcode, char *name); /* Counts a single instruction with the given opcode for the instruction histogram */
+void profileSpan(char *name, char phase); /* Records the beginning('B') or end('E') of a span, the name must stay valid until the trace is written */
+void profileCounters(void); /* Records the current value of all the counters as counter events */
+void profileWriteTrace(char *traceFile); /* Writes all the recorded events to the given file in Chrome trace-event JSON format */
+
+#else
+
+#define profileCount(counter, n)
+#define profileOpcode(opcode, name)
+#define profileBegin(name)
+#define profileEnd(name)
+#define profileSnapshot()
+#define profileWrite()
+
+#endif
+
+#endif
@@ -11,6 +11,8 @@
 #include "./status.h"
 #include "./files.h"
 #include "./strings.h"
+#include "./structural.h"
+#include "./peephole.h"
 
 /*
   Holds functions that scan through the source code.
@@ -28,27 +30,40 @@ int lineIndex = 0; /* The source code line index that is being processed */
 
 /*
   This function takes a file pointer to a source code file and a function(That will be the function to treat each line of code(first or second scan)).
-  Reads the lines from the source code and calls each line with the function that was passed as a parameter.
-  Validates that a line doesn't exceed its max character count.
+  Reads the lines from the source code and calls scanLine for each of them with the function that was passed as a parameter.
 */
 void scan(FILE *fp, int func(char *)) {
-  char *lineCpy;
-
   while (fgets(line, LINE_MAX, fp) != NULL) { /* Reads a line form the source code and stores it in line */
-    lineIndex++;
-    if (strlen(line) == (LINE_MAX - 1) && *(line + strlen(line) - 1) != '\n') { /* Validates the character length of the line */
+    int overflow = strlen(line) == (LINE_MAX - 1) && *(line + strlen(line) - 1) != '\n'; /* The line was longer than LINE_MAX - 1 characters */
+
+    if (overflow) { /* Skips the rest of the line */
       char ch;
       while ((ch = getc(fp)) != '\n' && ch != EOF);
-      printe("\nA line can have at most %d characters", 0, LINE_MAX - 1);
-      continue;
     }
-    lineCpy = copyString(line); /* Creates a new string with the current line because the scan functions may mutate it */
-    func(lineCpy); /* Calls the parameter function with the current line */
+    scanLine(func, overflow);
   }
 
   rewind(fp); /* Returns the file pointer to the beginning of the file */
 }
 
+/*
+  Accepts a function to treat a line of code and wether the line that was read to 'line' was longer than its max character count.
+  Counts the line, validates its character length and calls the function with a copy of the line.
+*/
+void scanLine(int func(char *), int overflow) {
+  char *lineCpy;
+
+  lineIndex++;
+  if (overflow) { /* Validates the character length of the line */
+    printe("\nA line can have at most %d characters", 0, LINE_MAX - 1);
+    return;
+  }
+  lineCpy = copyString(line); /* Creates a new string with the current line because the scan functions may mutate it */
+  indexBuffer(&lineStructure, lineCpy, strlen(lineCpy)); /* Finds all the spaces and delimiters of the line in a single vectorized pass */
+  func(lineCpy); /* Calls the parameter function with the current line */
+  lineStructure.base = NULL; /* The index is only valid while the line is processed */
+}
+
 /*
   Takes a line of source code and treats it accordingly.
   Checks the type of the line (comment/gudiane/command...)
@@ -78,8 +93,12 @@ int scanFirst(char *line) {
   }
 
   if (*(word) == '.') { /* Checks if the word is a guidance or command operator */
+    if (strcmp(word + 1, "entry") == 0) { /* The optimizer keeps the instructions of entries as they are */
+      peepholeEntry(line);
+    }
     return handleGuidance(line, word, label);
   } else {
+    peepholeAdd(label, word, line, IC); /* Records the line before handleFirstCommand changes it */
     return handleFirstCommand(line, word, label);
   }
 }
@@ -109,6 +128,9 @@ int scanSecond(char *line) {
     }
     return OK_STATUS;
   } else {
+    if (peepholeRewrite(&word, &line) == 0) { /* The optimizer removed the line */
+      return OK_STATUS;
+    }
     return handleSecondCommand(line, word);
   }
 }
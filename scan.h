@@ -10,6 +10,7 @@ struct dataNode;
 struct symbolNode;
 
 void scan(FILE *fp, int func(char *)); /* Receives a file pointer, and a function, iterates through all of the lines in the file pointer and for each triggers the function parameter */
+void scanLine(int func(char *), int overflow); /* Treats the line that was read to 'line' with a function, overflow states wether the line was too long */
 int scanFirst(char *line); /* A funciton to treat a single line of code in the first scan */
 int scanSecond(char *line); /* A function to treat a single line of code in the second scan */
 
@@ -0,0 +1,196 @@
+#define _GNU_SOURCE /* Required for memfd_create and the file seals */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include "./shared.h"
+
+/*
+  This file holds the functions that hand binary objects to other processes through shared memory, see shared.h.
+*/
+
+/*
+  Writes the whole buffer to the file descriptor, returns 0 on success.
+*/
+static int writeAll(int fd, objectBuffer *buf) {
+  unsigned long written = 0;
+
+  while (written < buf->size) {
+    ssize_t n = write(fd, buf->data + written, buf->size - written);
+
+    if (n <= 0) {
+      return -1;
+    }
+    written += n;
+  }
+  return 0;
+}
+
+/*
+  Accepts a prefix, the name of a compiled file and the object that was built for it.
+  Writes the object to the POSIX shared memory object /PREFIXNAME, where every '/' of the file name is replaced with '_'
+  since shared memory names cannot contain one. The object is created read only, and replaces one from a previous run.
+  Prints the name of the shared memory object. Returns 0 on success, prints a message and returns -1 otherwise.
+*/
+int shareObject(char *prefix, char *name, objectBuffer *buf) {
+  char *shmName = malloc(strlen(prefix) + strlen(name) + 2), *p;
+  int fd;
+
+  if (shmName == NULL) {
+    printf("Cannot allocate memory\n");
+    exit(0);
+  }
+  sprintf(shmName, "/%s%s", prefix + (*prefix == '/'), name);
+  for (p = shmName + 1; *p; p++) {
+    if (*p == '/') {
+      *p = '_';
+    }
+  }
+
+  shm_unlink(shmName); /* A read only object from a previous run cannot be opened for writing */
+  fd = shm_open(shmName, O_RDWR | O_CREAT | O_EXCL, 0444);
+  if (fd < 0 || ftruncate(fd, buf->size) != 0 || writeAll(fd, buf) != 0) {
+    printf("Cannot write to shared memory %s\n", shmName);
+    if (fd >= 0) {
+      close(fd);
+      shm_unlink(shmName);
+    }
+    free(shmName);
+    return -1;
+  }
+
+  close(fd);
+  printf("%s shared as %s (%lu bytes)\n", name, shmName, buf->size);
+  free(shmName);
+  return 0;
+}
+
+/*
+  Accepts the name of a POSIX shared memory object that was written by shareObject and a struct to fill.
+  Maps the object read only. Returns 0 on success, prints a message and returns -1 otherwise.
+*/
+int objectMapShared(char *name, objectFile *obj) {
+  int fd = shm_open(name, O_RDONLY, 0);
+
+  if (fd < 0) {
+    printf("Cannot open shared memory %s\n", name);
+    return -1;
+  }
+  return objectMapFd(fd, name, obj);
+}
+
+#ifdef __linux__
+
+#define SEALS (F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) /* After these seals the content can never change */
+
+/*
+  Accepts a connected UNIX socket, the name of a compiled file and the object that was built for it.
+  Writes the object to a new memfd, seals it and sends it over the socket in a single message that holds the file name
+  and the memfd. The memfd of this process is closed, the consumer holds the only reference to it.
+  Returns 0 on success, prints a message and returns -1 otherwise.
+*/
+int sendObject(int socket, char *name, objectBuffer *buf) {
+  union { /* Aligns the control message buffer */
+    struct cmsghdr header;
+    char buf[CMSG_SPACE(sizeof(int))];
+  } control;
+  struct msghdr msg;
+  struct cmsghdr *cmsg;
+  struct iovec iov;
+  int fd = memfd_create(name, MFD_CLOEXEC | MFD_ALLOW_SEALING), status = 0;
+
+  if (fd < 0 || writeAll(fd, buf) != 0 || fcntl(fd, F_ADD_SEALS, SEALS) != 0) {
+    printf("Cannot write to memfd of %s\n", name);
+    if (fd >= 0) {
+      close(fd);
+    }
+    return -1;
+  }
+
+  memset(&msg, 0, sizeof(msg));
+  memset(&control, 0, sizeof(control));
+  iov.iov_base = name;
+  iov.iov_len = strlen(name) + 1 < SHARED_NAME_MAX ? strlen(name) + 1 : SHARED_NAME_MAX;
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+  cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+  memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+  if (sendmsg(socket, &msg, 0) < 0) {
+    printf("Cannot send the memfd of %s\n", name);
+    status = -1;
+  }
+
+  close(fd);
+  return status;
+}
+
+/*
+  Accepts a UNIX socket that objects are sent over with sendObject, a buffer of SHARED_NAME_MAX characters for the name
+  and a struct to fill.
+  Receives a single object, checks that it is sealed against writes and maps it read only.
+  Returns 1 when an object was received, 0 when the sender closed the socket, prints a message and returns -1 on error.
+*/
+int receiveObject(int socket, char *name, objectFile *obj) {
+  union {
+    struct cmsghdr header;
+    char buf[CMSG_SPACE(sizeof(int))];
+  } control;
+  struct msghdr msg;
+  struct cmsghdr *cmsg;
+  struct iovec iov;
+  ssize_t n;
+  int fd;
+
+  memset(&msg, 0, sizeof(msg));
+  iov.iov_base = name;
+  iov.iov_len = SHARED_NAME_MAX - 1;
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+
+  if ((n = recvmsg(socket, &msg, MSG_CMSG_CLOEXEC)) <= 0) {
+    return n == 0 ? 0 : -1;
+  }
+  name[n] = '\0';
+
+  cmsg = CMSG_FIRSTHDR(&msg);
+  if (cmsg == NULL || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+    printf("No memfd was received with %s\n", name);
+    return -1;
+  }
+  memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+
+  if ((fcntl(fd, F_GET_SEALS) & SEALS) != SEALS) {
+    printf("The memfd of %s is not sealed\n", name);
+    close(fd);
+    return -1;
+  }
+
+  return objectMapFd(fd, name, obj) == 0 ? 1 : -1;
+}
+
+#else
+
+int sendObject(int socket, char *name, objectBuffer *buf) {
+  printf("memfd is not supported on this system\n");
+  return -1;
+}
+
+int receiveObject(int socket, char *name, objectFile *obj) {
+  printf("memfd is not supported on this system\n");
+  return -1;
+}
+
+#endif
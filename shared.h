@@ -0,0 +1,24 @@
+#ifndef SHARED_H
+#define SHARED_H
+
+/*
+  Hands the binary object of each compiled file to another process through memory instead of the filesystem.
+  The segment holds exactly the bytes of the .bo file(see object.h), so it is mapped read only and used in place.
+
+  --shm PREFIX   The object is written to a POSIX shared memory object named PREFIX followed by the file name, that is
+                 made read only. Its name is printed, the consumer opens it with shm_open and removes it with shm_unlink.
+  --memfd FD     FD is a connected UNIX socket the assembler inherited from the consumer(eg: one end of a socketpair).
+                 The object is written to a memfd that is sealed against any change, and the memfd is sent over the
+                 socket together with the file name. The consumer maps it read only, nothing is left behind to remove.
+*/
+
+#include "./object.h"
+
+#define SHARED_NAME_MAX 256 /* The maximum length of a file name that is sent with a memfd */
+
+int shareObject(char *prefix, char *name, objectBuffer *buf); /* Writes an object to a POSIX shared memory object, returns 0 on success */
+int sendObject(int socket, char *name, objectBuffer *buf); /* Writes an object to a sealed memfd and sends it over the socket, returns 0 on success */
+int receiveObject(int socket, char *name, objectFile *obj); /* Receives an object that was sent with sendObject and maps it, returns 1 when one was received, 0 at the end and -1 on error */
+int objectMapShared(char *name, objectFile *obj); /* Maps an object from a POSIX shared memory object, returns 0 on success */
+
+#endif
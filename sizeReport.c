@@ -0,0 +1,338 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "./sizeReport.h"
+#include "./command.h"
+#include "./commandUtils.h"
+#include "./data.h"
+#include "./utils.h"
+#include "./files.h"
+
+/*
+  This file holds the size report, see sizeReport.h.
+*/
+
+#define NO_LABEL "(no label)" /* The name the words before the first label are attributed to */
+#define MAX_OPERANDS 2 /* The most operands an instruction has */
+
+/*
+  The estimated cycles of an instruction are a cycle for every word that is fetched, the cycles of its opcode and the
+  cycles of the address mode of each of its operands.
+*/
+static int opcodeCycles[] = { 1, 1, 1, 1, 1, 1, 1, 1, 1, /* mov cmp add sub not clr lea inc dec */
+                              2, 2, /* jmp bne, the program counter is replaced */
+                              4, 4, /* red prn, wait for the device */
+                              3, 3, /* jsr rts, push or pop the return address */
+                              1 }; /* stop */
+static int modeCycles[MAX_ADDRESS_MODE] = { 0, /* IMMED, the value is in the operand word */
+                                            1, /* DIRECT, reads the memory */
+                                            2, /* INDEX, adds the index and reads the memory */
+                                            0 }; /* REGISTER_MODE */
+
+typedef struct reportLabel { /* A label of the file and the words attributed to it */
+  char *label;
+  int address, order, /* The order of the label in the symbol table, breaks the ties of labels at the same address */
+  codeWords, dataWords, cycles;
+} reportLabel;
+
+typedef struct reportBlock { /* A basic block of the instructions */
+  reportLabel *label; /* The nearest label before the block */
+  int address, words, instructions, cycles;
+} reportBlock;
+
+static reportLabel *labels, noLabel;
+static int labelCount;
+
+/*
+  Compares 2 labels by their address for qsort.
+*/
+static int compareAddresses(const void *a, const void *b) {
+  const reportLabel *x = a, *y = b;
+
+  return x->address != y->address ? x->address - y->address : x->order - y->order;
+}
+
+/*
+  Compares 2 labels(pointers to labels) by their words for qsort, the largest first.
+*/
+static int compareWords(const void *a, const void *b) {
+  reportLabel *x = *(reportLabel **) a, *y = *(reportLabel **) b;
+  int diff = (y->codeWords + y->dataWords) - (x->codeWords + x->dataWords);
+
+  return diff != 0 ? diff : x->address - y->address;
+}
+
+/*
+  Compares 2 labels(pointers to labels) by their cycles for qsort, the most expensive first.
+*/
+static int compareCycles(const void *a, const void *b) {
+  reportLabel *x = *(reportLabel **) a, *y = *(reportLabel **) b;
+
+  return y->cycles != x->cycles ? y->cycles - x->cycles : compareWords(a, b);
+}
+
+/*
+  Compares 2 blocks by their cycles for qsort, the most expensive first.
+*/
+static int compareBlocks(const void *a, const void *b) {
+  const reportBlock *x = a, *y = b;
+
+  return y->cycles != x->cycles ? y->cycles - x->cycles : x->address - y->address;
+}
+
+/*
+  Checks wether an instruction ends a basic block, a jump, rts or stop.
+*/
+static int endsBlock(commandPtr comm) {
+  return (comm->flags & ENDS_BLOCK) != 0;
+}
+
+/*
+  Returns the nearest label at or before an address, the label the words before the first label are attributed to
+  if there is none. Of the labels at the same address the last one is returned.
+*/
+static reportLabel *labelAt(int address) {
+  int low = 0, high = labelCount;
+
+  while (low < high) { /* Finds the first label after the address */
+    int mid = (low + high) / 2;
+
+    if (labels[mid].address <= address) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low > 0 ? &labels[low - 1] : &noLabel;
+}
+
+/*
+  Checks wether a symbol is a label of the file. A label given to .entry is of the instructions or of the data by its
+  address, the instructions are below MEMORY_BASE + IC and the data after them, so the words after it are attributed to
+  it like to any other label.
+*/
+static int isLabel(symbolNodePtr node) {
+  return node->type == COMMAND || node->type == GUIDANCE || node->type == ENTRY;
+}
+
+/*
+  Collects the labels of the instructions and of the data in the order of their addresses.
+*/
+static void collectLabels() {
+  symbolNodePtr node;
+  int i = 0;
+
+  for (node = symbolHead, labelCount = 0; node != NULL; node = node->next) {
+    labelCount += isLabel(node);
+  }
+  if ((labels = calloc(labelCount + 1, sizeof(reportLabel))) == NULL) {
+    printf("Cannot allocate memory\n");
+    exit(0);
+  }
+  for (node = symbolHead; node != NULL; node = node->next) {
+    if (isLabel(node)) {
+      labels[i].label = node->label;
+      labels[i].address = node->val;
+      labels[i].order = i;
+      i++;
+    }
+  }
+  qsort(labels, labelCount, sizeof(reportLabel), compareAddresses);
+
+  memset(&noLabel, 0, sizeof(reportLabel));
+  noLabel.label = NO_LABEL;
+  noLabel.address = MEMORY_BASE;
+}
+
+/*
+  Accepts the instruction words and their amount and an array with room for a block for each instruction.
+  Decodes the instructions, attributes their words and cycles to the labels and splits them into basic blocks.
+  Returns the amount of blocks.
+*/
+static int attributeCode(int words[], int wordCount, reportBlock blocks[]) {
+  int i, length, modes[MAX_OPERANDS], blockCount = 0, ends = 1;
+
+  for (i = 0; i < wordCount; i += length) {
+    commandPtr comm = decodeCommandWord(words[i], modes, &length);
+    reportLabel *label = labelAt(MEMORY_BASE + i);
+    int cycles, k;
+
+    if (comm == NULL || i + length > wordCount) { /* Should not happen, the words were encoded by the second scan */
+      length = cycles = 1;
+    } else {
+      for (k = 0, cycles = length + opcodeCycles[comm->opcode]; k < comm->args; k++) {
+        cycles += modeCycles[modes[k]];
+      }
+    }
+    label->codeWords += length;
+    label->cycles += cycles;
+
+    if (ends || (label != &noLabel && label->address == MEMORY_BASE + i)) {
+      memset(&blocks[blockCount], 0, sizeof(reportBlock));
+      blocks[blockCount].label = label;
+      blocks[blockCount++].address = MEMORY_BASE + i;
+    }
+    blocks[blockCount - 1].words += length;
+    blocks[blockCount - 1].instructions++;
+    blocks[blockCount - 1].cycles += cycles;
+
+    ends = comm == NULL || endsBlock(comm);
+  }
+  return blockCount;
+}
+
+/*
+  Accepts the amount of instruction words and attributes the data words to the labels.
+  Returns the amount of data words.
+*/
+static int attributeData(int wordCount) {
+  dataNodePtr cur;
+  int count = 0;
+
+  for (cur = dataHead; cur != NULL; cur = cur->next, count++) {
+    labelAt(MEMORY_BASE + wordCount + cur->index)->dataWords++;
+  }
+  return count;
+}
+
+/*
+  Accepts a file and a string and writes the string to the file as a JSON string.
+*/
+static void writeJsonString(FILE *fp, char *str) {
+  putc('"', fp);
+  for (; *str != '\0'; str++) {
+    if (*str == '"' || *str == '\\') {
+      putc('\\', fp);
+    }
+    putc(*str, fp);
+  }
+  putc('"', fp);
+}
+
+/*
+  Accepts a file and a block and writes the name of the block, its label and the words from the label.
+*/
+static void writeBlockName(FILE *fp, reportBlock *block) {
+  if (block->address == block->label->address) {
+    fprintf(fp, "%s", block->label->label);
+  } else {
+    fprintf(fp, "%s+%d", block->label->label, block->address - block->label->address);
+  }
+}
+
+/*
+  Accepts a file and the labels sorted for one of the tables and writes the table.
+*/
+static void writeLabelTable(FILE *fp, char *title, reportLabel *sorted[], int count) {
+  int i;
+
+  fprintf(fp, "\n%s:\n  %6s %6s %6s %7s %8s  %s\n", title, "Words", "Code", "Data", "Cycles", "Address", "Label");
+  for (i = 0; i < count; i++) {
+    fprintf(fp, "  %6d %6d %6d %7d %8d  %s\n", sorted[i]->codeWords + sorted[i]->dataWords, sorted[i]->codeWords,
+            sorted[i]->dataWords, sorted[i]->cycles, sorted[i]->address, sorted[i]->label);
+  }
+}
+
+/*
+  Writes the report as text, the labels ranked by their words and by their cycles and the blocks ranked by their cycles.
+*/
+static void writeText(FILE *fp, reportLabel *bySize[], reportLabel *byCycles[], int count, reportBlock blocks[],
+                      int blockCount, int codeWords, int dataWords) {
+  int memory = MEMORY_SIZE - MEMORY_BASE, i;
+
+  fprintf(fp, "Size report of %s\n\n", fileName);
+  fprintf(fp, "Memory: %d code words + %d data words = %d of %d words(%.1f%%), ", codeWords, dataWords,
+          codeWords + dataWords, memory, 100.0 * (codeWords + dataWords) / memory);
+  if (codeWords + dataWords > memory) {
+    fprintf(fp, "%d words over the memory size\n", codeWords + dataWords - memory);
+  } else {
+    fprintf(fp, "%d words free\n", memory - codeWords - dataWords);
+  }
+
+  writeLabelTable(fp, "Labels by size", bySize, count);
+  writeLabelTable(fp, "Labels by cost", byCycles, count);
+
+  fprintf(fp, "\nBasic blocks by cost:\n  %7s %6s %12s %8s  %s\n", "Cycles", "Words", "Instructions", "Address", "Block");
+  for (i = 0; i < blockCount; i++) {
+    fprintf(fp, "  %7d %6d %12d %8d  ", blocks[i].cycles, blocks[i].words, blocks[i].instructions, blocks[i].address);
+    writeBlockName(fp, &blocks[i]);
+    putc('\n', fp);
+  }
+}
+
+/*
+  Writes the report as JSON, the labels in the order of their words and the blocks in the order of their cycles.
+*/
+static void writeJson(FILE *fp, reportLabel *bySize[], int count, reportBlock blocks[], int blockCount, int codeWords,
+                      int dataWords) {
+  int i;
+
+  fprintf(fp, "{\n  \"file\": ");
+  writeJsonString(fp, fileName);
+  fprintf(fp, ",\n  \"codeWords\": %d,\n  \"dataWords\": %d,\n  \"memoryWords\": %d,\n  \"usedWords\": %d,\n  \"labels\": [",
+          codeWords, dataWords, MEMORY_SIZE - MEMORY_BASE, codeWords + dataWords);
+  for (i = 0; i < count; i++) {
+    fprintf(fp, "%s\n    { \"label\": ", i ? "," : "");
+    writeJsonString(fp, bySize[i]->label);
+    fprintf(fp, ", \"address\": %d, \"codeWords\": %d, \"dataWords\": %d, \"cycles\": %d }", bySize[i]->address,
+            bySize[i]->codeWords, bySize[i]->dataWords, bySize[i]->cycles);
+  }
+  fprintf(fp, "%s],\n  \"blocks\": [", count ? "\n  " : "");
+  for (i = 0; i < blockCount; i++) {
+    fprintf(fp, "%s\n    { \"block\": \"", i ? "," : "");
+    writeBlockName(fp, &blocks[i]);
+    fprintf(fp, "\", \"address\": %d, \"words\": %d, \"instructions\": %d, \"cycles\": %d }", blocks[i].address,
+            blocks[i].words, blocks[i].instructions, blocks[i].cycles);
+  }
+  fprintf(fp, "%s]\n}\n", blockCount ? "\n  " : "");
+}
+
+/*
+  Accepts the instruction words of the file(the words of the second scan) and their amount.
+  Should be called after the second scan, once the labels hold their final addresses.
+  Attributes the words and the cycles to the labels and the blocks, writes the report to the .size and .size.json
+  files and prints how much of the memory the file takes.
+*/
+void sizeReport(int words[], int wordCount) {
+  reportLabel **bySize, **byCycles;
+  reportBlock *blocks;
+  FILE *text = createSizeReport(0), *json = createSizeReport(1);
+  int blockCount, dataWords, count = 0, i;
+
+  if (text == NULL || json == NULL) {
+    return;
+  }
+
+  collectLabels();
+  if ((blocks = malloc(sizeof(reportBlock) * (wordCount + 1))) == NULL ||
+      (bySize = malloc(sizeof(reportLabel *) * (labelCount + 1))) == NULL ||
+      (byCycles = malloc(sizeof(reportLabel *) * (labelCount + 1))) == NULL) {
+    printf("Cannot allocate memory\n");
+    exit(0);
+  }
+
+  blockCount = attributeCode(words, wordCount, blocks);
+  dataWords = attributeData(wordCount);
+
+  if (noLabel.codeWords + noLabel.dataWords > 0) {
+    bySize[count++] = &noLabel;
+  }
+  for (i = 0; i < labelCount; i++) {
+    bySize[count++] = &labels[i];
+  }
+  memcpy(byCycles, bySize, sizeof(reportLabel *) * count);
+  qsort(bySize, count, sizeof(reportLabel *), compareWords);
+  qsort(byCycles, count, sizeof(reportLabel *), compareCycles);
+  qsort(blocks, blockCount, sizeof(reportBlock), compareBlocks);
+
+  writeText(text, bySize, byCycles, count, blocks, blockCount, wordCount, dataWords);
+  writeJson(json, bySize, count, blocks, blockCount, wordCount, dataWords);
+  printf("\n%s: %d of %d words of memory(%.1f%%), the size report was written to %s%s\n", fileName,
+         wordCount + dataWords, MEMORY_SIZE - MEMORY_BASE, 100.0 * (wordCount + dataWords) / (MEMORY_SIZE - MEMORY_BASE),
+         fileName, SIZE_EXT);
+
+  free(labels);
+  free(blocks);
+  free(bySize);
+  free(byCycles);
+}
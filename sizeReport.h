@@ -0,0 +1,16 @@
+#ifndef SIZE_REPORT_H
+#define SIZE_REPORT_H
+
+/*
+  The size report of a file(--size-report), written after the second scan to NAME.size as sorted text and to
+  NAME.size.json.
+  Every instruction word and every data word is attributed to the nearest label before it(the words before the first
+  label to "(no label)"). The instructions are decoded back from their words, each one is given an estimated cost in
+  cycles from the tables of sizeReport.c and the costs are summed up for each label and for each basic block, a block
+  starts at a label and after jmp, bne, jsr, rts and stop. The labels are ranked by their words and by their cycles
+  and the blocks by their cycles, with the amount of memory the file takes out of the MEMORY_SIZE words of the machine.
+*/
+
+void sizeReport(int words[], int wordCount); /* Accepts the instruction words of the file and their amount and writes the size report */
+
+#endif
@@ -0,0 +1,273 @@
+#define _XOPEN_SOURCE 700 /* Required for realpath, mmap and the nanoseconds of the modification time */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "./snapshot.h"
+#include "./object.h"
+#include "./guidance.h"
+#include "./scan.h"
+#include "./data.h"
+#include "./utils.h"
+#include "./strings.h"
+#include "./files.h"
+#include "./status.h"
+
+/*
+  This file holds the functions that create, load and use the symbol snapshots, see snapshot.h.
+*/
+
+typedef char snapshotHeaderSizeCheck[sizeof(snapshotHeader) == 48 && sizeof(snapshotSymbol) == 8 ? 1 : -1]; /* The mapped structs require 16 and 32 bit shorts and ints */
+
+static snapshotHeader *snapshot; /* The snapshot that was loaded, NULL if none was */
+
+/*
+  Accepts an open file.
+  Returns the 32 bit FNV-1a hash of its content from its start.
+*/
+static unsigned long hashFile(FILE *fp) {
+  unsigned long hash = 2166136261UL;
+  int ch;
+
+  rewind(fp);
+  while ((ch = getc(fp)) != EOF) {
+    hash = ((hash ^ (unsigned char) ch) * 16777619UL) & 0xffffffffUL;
+  }
+  return hash;
+}
+
+/*
+  Accepts a line of a definition source.
+  Checks that it is empty, a comment, a .define or an .extern line and handles it like the first scan does.
+  Returns a status.
+*/
+static int scanDefinitions(char *line) {
+  char *word = getWord(&line), *label = NULL;
+
+  if (*word == '\0' || *word == ';') {
+    return OK_STATUS;
+  }
+  if (word[strlen(word) - 1] == ':') {
+    word[strlen(word) - 1] = '\0';
+    label = word;
+    word = getWord(&line);
+  }
+  if (strcmp(word, ".define") != 0 && strcmp(word, ".extern") != 0) {
+    printe("A definition source can only have .define and .extern lines", 0);
+    return INVALID_SYNTAX;
+  }
+  return handleGuidance(line, word, label);
+}
+
+/*
+  Accepts a buffer the symbols of the symbol table were scanned to, the real path of their source, its status and its hash.
+  Builds the snapshot in the buffer.
+*/
+static void buildSnapshot(objectBuffer *buf, char *source, struct stat *info, unsigned long hash) {
+  unsigned long header = objectReserve(buf, sizeof(snapshotHeader)), symbols, strings, count = 0, i;
+  symbolNodePtr cur;
+
+  for (cur = symbolHead; cur != NULL; cur = cur->next) {
+    count++;
+  }
+  symbols = objectReserve(buf, count * sizeof(snapshotSymbol));
+  strings = objectReserve(buf, 0);
+
+  for (cur = symbolHead, i = 0; cur != NULL; cur = cur->next, i++) {
+    unsigned long symbol = symbols + i * sizeof(snapshotSymbol);
+
+    objectPut32(buf, symbol + offsetof(snapshotSymbol, name), objectAppend(buf, cur->label, strlen(cur->label) + 1) - strings);
+    objectPut16(buf, symbol + offsetof(snapshotSymbol, val), cur->val);
+    objectPut16(buf, symbol + offsetof(snapshotSymbol, type), cur->type);
+  }
+  objectPut32(buf, header + offsetof(snapshotHeader, source), objectAppend(buf, source, strlen(source) + 1) - strings);
+
+  memcpy(buf->data + header, SNAPSHOT_MAGIC, 4);
+  objectPut16(buf, header + offsetof(snapshotHeader, version), SNAPSHOT_VERSION);
+  objectPut16(buf, header + offsetof(snapshotHeader, headerSize), sizeof(snapshotHeader));
+  objectPut32(buf, header + offsetof(snapshotHeader, symbolCount), count);
+  objectPut32(buf, header + offsetof(snapshotHeader, symbolsOffset), symbols);
+  objectPut32(buf, header + offsetof(snapshotHeader, stringsSize), buf->size - strings);
+  objectPut32(buf, header + offsetof(snapshotHeader, stringsOffset), strings);
+  objectPut32(buf, header + offsetof(snapshotHeader, sourceSize), info->st_size);
+  objectPut32(buf, header + offsetof(snapshotHeader, sourceSeconds), info->st_mtim.tv_sec);
+  objectPut32(buf, header + offsetof(snapshotHeader, sourceNanoseconds), info->st_mtim.tv_nsec);
+  objectPut32(buf, header + offsetof(snapshotHeader, sourceHash), hash);
+  objectPut32(buf, header + offsetof(snapshotHeader, fileSize), buf->size);
+}
+
+/*
+  Accepts the name of a definition source without its extension and the name of the snapshot.
+  Scans the source with the functions of the first scan and writes the symbols it created to the snapshot. The snapshot
+  is written to a temporary file that is renamed over it, so an assembler that maps the old one isn't affected.
+  Returns 0 on success, prints the errors and returns -1 otherwise.
+*/
+int snapshotCreate(char *name, char *snapshotFile) {
+  char *sourceFile = addExtension(name, ASSEMBLY_EXT), *tmpFile = addExtension(snapshotFile, ".tmp"), *real;
+  FILE *fp = openFile(sourceFile, "r"), *out;
+  struct stat info;
+  unsigned long hash;
+  objectBuffer buf;
+  int status = -1;
+
+  if (fp == NULL) {
+    frees(2, sourceFile, tmpFile);
+    return -1;
+  }
+  if ((real = realpath(sourceFile, NULL)) == NULL || fstat(fileno(fp), &info) != 0) {
+    printf("Cannot open file %s\n", sourceFile);
+    fclose(fp);
+    frees(3, sourceFile, tmpFile, real);
+    return -1;
+  }
+
+  fileName = name;
+  lineIndex = 0;
+  scanCount = FIRST;
+  error = OK;
+  symbolHead = NULL;
+  scan(fp, scanDefinitions);
+  hash = hashFile(fp);
+  fclose(fp);
+
+  if (error != OK) {
+    printf("An error has been found, failed to create a snapshot of %s\n", name);
+  } else {
+    objectInit(&buf);
+    buildSnapshot(&buf, real, &info, hash);
+    if ((out = openFile(tmpFile, "wb")) != NULL) {
+      if (fwrite(buf.data, 1, buf.size, out) == buf.size && fclose(out) == 0 && rename(tmpFile, snapshotFile) == 0) {
+        status = 0;
+      } else {
+        printf("Cannot write to file %s\n", snapshotFile);
+        remove(tmpFile);
+      }
+    }
+    objectFree(&buf);
+  }
+
+  symbolNodeFree(symbolHead);
+  symbolHead = NULL;
+  frees(3, sourceFile, tmpFile, real);
+  return status;
+}
+
+/*
+  Accepts a mapped snapshot and its size.
+  Returns wether its sections and the labels of its symbols are inside of it.
+*/
+static int validSnapshot(snapshotHeader *header, unsigned long size) {
+  snapshotSymbol *symbols = (snapshotSymbol *) ((char *) header + header->symbolsOffset);
+  char *strings = (char *) header + header->stringsOffset;
+  unsigned long i;
+
+  if (header->fileSize != size || header->symbolsOffset % 4 != 0 || header->symbolsOffset < sizeof(snapshotHeader) ||
+      header->symbolsOffset + (unsigned long) header->symbolCount * sizeof(snapshotSymbol) > size ||
+      header->stringsOffset + (unsigned long) header->stringsSize > size || header->stringsSize == 0 ||
+      strings[header->stringsSize - 1] != '\0' || header->source >= header->stringsSize) {
+    return 0;
+  }
+  for (i = 0; i < header->symbolCount; i++) {
+    if (symbols[i].name >= header->stringsSize || (symbols[i].type != MACRO && symbols[i].type != EXTERNAL)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/*
+  Accepts the name of a snapshot.
+  Maps it and validates it, and checks that the source it was created from didn't change(see snapshot.h). The snapshot
+  stays mapped until the program ends, snapshotSeed uses it.
+  Returns 0 on success, prints a message and returns -1 otherwise.
+*/
+int snapshotLoad(char *snapshotFile) {
+  int fd = open(snapshotFile, O_RDONLY);
+  struct stat st, info;
+  snapshotHeader *header;
+  char *source;
+  FILE *fp;
+  void *map;
+
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    printf("Cannot open file %s\n", snapshotFile);
+    if (fd >= 0) {
+      close(fd);
+    }
+    return -1;
+  }
+  if (st.st_size < sizeof(snapshotHeader) ||
+      (map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED) {
+    printf("%s is not a snapshot\n", snapshotFile);
+    close(fd);
+    return -1;
+  }
+  close(fd); /* The mapping stays valid after the file is closed */
+
+  header = map;
+  if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0) {
+    printf("%s is not a snapshot\n", snapshotFile);
+  } else if (header->version != SNAPSHOT_VERSION || header->headerSize != sizeof(snapshotHeader)) {
+    printf("%s was created for version %d of the snapshots, version %d is required, create it again with obsnap\n",
+           snapshotFile, header->version, SNAPSHOT_VERSION);
+  } else if (!validSnapshot(header, st.st_size)) {
+    printf("%s is not a valid snapshot\n", snapshotFile);
+  } else if (stat(source = (char *) map + header->stringsOffset + header->source, &info) != 0) {
+    printf("Cannot open %s to check the snapshot %s\n", source, snapshotFile);
+  } else if (info.st_size == header->sourceSize && (info.st_mtim.tv_sec & 0xffffffffUL) == header->sourceSeconds &&
+             info.st_mtim.tv_nsec == header->sourceNanoseconds) { /* Fresh without reading the source */
+    snapshot = header;
+    return 0;
+  } else if ((fp = fopen(source, "rb")) == NULL) {
+    printf("Cannot open %s to check the snapshot %s\n", source, snapshotFile);
+  } else {
+    unsigned long hash = hashFile(fp);
+
+    fclose(fp);
+    if (info.st_size == header->sourceSize && hash == header->sourceHash) { /* The source was only touched */
+      snapshot = header;
+      return 0;
+    }
+    printf("The snapshot %s is stale, %s changed after it was created, create it again with obsnap\n", snapshotFile,
+           source);
+  }
+
+  munmap(map, st.st_size);
+  return -1;
+}
+
+/*
+  Should be called when the symbol table of a new file is empty.
+  Adds the symbols of the loaded snapshot to it in their order, their labels point into the mapped snapshot.
+*/
+void snapshotSeed(void) {
+  snapshotSymbol *symbols;
+  symbolNodePtr new, tail = NULL;
+  char *strings;
+  unsigned long i;
+
+  if (snapshot == NULL) {
+    return;
+  }
+
+  symbols = (snapshotSymbol *) ((char *) snapshot + snapshot->symbolsOffset);
+  strings = (char *) snapshot + snapshot->stringsOffset;
+  for (i = 0; i < snapshot->symbolCount; i++) {
+    new = salloc();
+    new->label = strings + symbols[i].name; /* The labels of the symbol table are never changed or freed */
+    new->val = symbols[i].val;
+    new->type = symbols[i].type;
+    new->next = NULL;
+    if (tail == NULL) {
+      symbolHead = new;
+    } else {
+      tail->next = new;
+    }
+    tail = new;
+  }
+}
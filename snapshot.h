@@ -0,0 +1,51 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+/*
+  Precompiled symbol snapshots of definition sources, for runs of the assembler that compile a single module each.
+  A definition source has only .define and .extern lines(and comments and empty lines). 'obsnap' scans it once and
+  writes the symbols it creates to a snapshot(NAME.snap), and --preload SNAPSHOT maps the snapshot when the assembler
+  starts and adds its symbols to the symbol table before every file is scanned, the source is neither read nor parsed.
+
+  Layout, all fields little endian and every section starts at an offset that is a multiple of 4(like object.h):
+  header      a snapshotHeader
+  symbols     a snapshotSymbol for each symbol, in the order of the symbol table
+  strings     the null terminated labels, and the real path of the definition source
+
+  The snapshot keeps the size, the modification time and a hash of the source it was created from. When it is loaded
+  the source is checked: if its size and modification time are the same it is fresh, otherwise the source is read and
+  hashed, a source that was only touched is still fresh and a changed one makes the snapshot stale, it is an error.
+  A snapshot of another version of the format is an error too.
+*/
+
+#define SNAPSHOT_MAGIC "ASPS" /* The first 4 bytes of every snapshot */
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_EXT ".snap"
+
+typedef struct snapshotHeader {
+  char magic[4];
+  unsigned short version,
+  headerSize; /* The size of this struct, the symbols start after it */
+  unsigned int symbolCount,
+  symbolsOffset,
+  stringsSize, /* The size of the strings section in bytes */
+  stringsOffset,
+  source, /* The offset of the path of the source in the strings section */
+  sourceSize, /* The size, the modification time and the hash of the source when the snapshot was created */
+  sourceSeconds,
+  sourceNanoseconds,
+  sourceHash,
+  fileSize;
+} snapshotHeader;
+
+typedef struct snapshotSymbol {
+  unsigned int name; /* The offset of the label in the strings section */
+  short val;
+  unsigned short type; /* enum SYMBOL_TYPE, MACRO or EXTERNAL */
+} snapshotSymbol;
+
+int snapshotCreate(char *name, char *snapshotFile); /* Scans the definition source NAME.as and writes its snapshot, returns 0 on success */
+int snapshotLoad(char *snapshotFile); /* Maps a snapshot and checks that its source didn't change, returns 0 on success */
+void snapshotSeed(void); /* Adds the symbols of the loaded snapshot to the empty symbol table, nothing if none was loaded */
+
+#endif
@@ -10,6 +10,7 @@ enum STATUS
   INVALID_ARGUMENT,
   INVALID_SYNTAX,
   UNKNOWN_OPERATOR,
+  OUT_OF_RANGE,
   BAD_STATUS
 };
 
@@ -0,0 +1,325 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "./stringPool.h"
+#include "./data.h"
+#include "./utils.h"
+#include "./strings.h"
+#include "./options.h"
+#include "./files.h"
+
+/*
+  This file holds the string pooling, see stringPool.h.
+*/
+
+#define STRINGS_CHUNK 256 /* The amount of strings the array of strings grows by */
+
+typedef struct pooledString { /* A .string with a label that was interned in the first scan */
+  char *label;
+  int length, /* The amount of words, the characters and the 0 that ends them */
+  start, /* The address of the first word in the data table */
+  *words, /* The words of the string, read from the data table */
+  host, /* The index of the string whose tail holds this one, the index of this string when it is laid out */
+  valid, /* The label starts a block that holds only the string */
+  excluded; /* Something could tell if the string was shared, see stringPool.h */
+} pooledString;
+
+static pooledString *strings; /* The strings of the current file in the order of the source code */
+static int stringCount, stringCapacity;
+static int *byStart, /* The indexes of the valid strings, in the order of their addresses */
+*removedBefore, /* The amount of words removed before each string of byStart */
+validCount;
+
+static char *writers[] = { "mov", "add", "sub", "not", "clr", "lea", "inc", "dec", "red" }; /* The commands that write their last operand */
+
+/*
+  Accepts the label of a .string and the amount of words it added to the data table, the characters and the 0.
+  Records the string when --pool-strings was given.
+*/
+void stringPoolAdd(char *label, int length) {
+  if (!hasOption(POOL_STRINGS_OPTION)) {
+    return;
+  }
+
+  if (stringCount == stringCapacity) {
+    stringCapacity += STRINGS_CHUNK;
+    if ((strings = realloc(strings, sizeof(pooledString) * stringCapacity)) == NULL) {
+      printf("Cannot allocate memory\n");
+      exit(0);
+    }
+  }
+
+  memset(&strings[stringCount], 0, sizeof(pooledString));
+  strings[stringCount].label = copyString(label);
+  strings[stringCount].length = length;
+  strings[stringCount].host = stringCount;
+  stringCount++;
+}
+
+/*
+  Frees the strings of the previous file.
+*/
+void stringPoolFree() {
+  int i;
+
+  for (i = 0; i < stringCount; i++) {
+    free(strings[i].label);
+    free(strings[i].words);
+  }
+  stringCount = 0;
+}
+
+/*
+  Compares 2 ints for qsort.
+*/
+static int compareInts(const void *a, const void *b) {
+  return *(const int *) a - *(const int *) b;
+}
+
+/*
+  Compares the characters of 2 strings(indexes to strings) from the last one backwards for qsort.
+  A string comes before the strings it is a suffix of.
+*/
+static int compareTails(const void *a, const void *b) {
+  pooledString *x = &strings[*(const int *) a], *y = &strings[*(const int *) b];
+  int i;
+
+  for (i = 1; i <= x->length && i <= y->length; i++) {
+    if (x->words[x->length - i] != y->words[y->length - i]) {
+      return x->words[x->length - i] - y->words[y->length - i];
+    }
+  }
+  return x->length - y->length;
+}
+
+/*
+  Checks wether a string(an index to strings) is a suffix of another one.
+*/
+static int isSuffix(int a, int b) {
+  pooledString *x = &strings[a], *y = &strings[b];
+
+  return x->length <= y->length &&
+         memcmp(x->words, y->words + y->length - x->length, sizeof(int) * x->length) == 0;
+}
+
+/*
+  Returns the position in byStart of the valid string that holds an address of the data table, -1 if there is none.
+*/
+static int stringAt(int address) {
+  int low = 0, high = validCount;
+
+  while (low < high) { /* Finds the first string that starts after the address */
+    int mid = (low + high) / 2;
+
+    if (strings[byStart[mid]].start <= address) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  low--;
+  return low >= 0 && address < strings[byStart[low]].start + strings[byStart[low]].length ? low : -1;
+}
+
+/*
+  Returns the amount of words removed before an address of the data table.
+*/
+static int wordsRemovedBefore(int address) {
+  int low = 0, high = validCount;
+
+  while (low < high) {
+    int mid = (low + high) / 2;
+
+    if (strings[byStart[mid]].start < address) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return removedBefore[low];
+}
+
+/*
+  Finds the valid strings: the label of the string starts a block of the data table that holds only the string.
+  The label of a string that was removed by the dead data elimination shares its address with another label or
+  points to the end of the data table.
+*/
+static void findValid() {
+  symbolNodePtr node;
+  int *starts, count = 0, i;
+
+  for (node = symbolHead; node != NULL; node = node->next) {
+    count += node->type == GUIDANCE;
+  }
+  if ((starts = malloc(sizeof(int) * (count + 1))) == NULL || (byStart = malloc(sizeof(int) * (stringCount + 1))) == NULL ||
+      (removedBefore = malloc(sizeof(int) * (stringCount + 1))) == NULL) {
+    printf("Cannot allocate memory\n");
+    exit(0);
+  }
+  for (node = symbolHead, i = 0; node != NULL; node = node->next) {
+    if (node->type == GUIDANCE) {
+      starts[i++] = node->val;
+    }
+  }
+  qsort(starts, count, sizeof(int), compareInts);
+
+  for (i = validCount = 0; i < stringCount; i++) {
+    int *found;
+
+    if ((node = symbolNodeByLabel(strings[i].label)) == NULL || node->type != GUIDANCE ||
+        (found = bsearch(&node->val, starts, count, sizeof(int), compareInts)) == NULL) {
+      continue;
+    }
+    strings[i].start = node->val;
+    while (found > starts && found[-1] == node->val) { /* The first label at the address */
+      found--;
+    }
+    strings[i].valid = found + 1 == starts + count ? node->val + strings[i].length == DC :
+                       found[1] != node->val && node->val + strings[i].length == found[1];
+    if (strings[i].valid) {
+      byStart[validCount++] = i; /* The strings were recorded in the order of their addresses */
+    }
+  }
+  free(starts);
+}
+
+/*
+  Excludes the strings that are entries, that are written, that an index reaches past and that another label's index
+  reaches into.
+*/
+static void exclude(peepholeLine lines[], int lineCount, char *entries[], int entryCount) {
+  int i, j, k;
+
+  for (i = 0; i < lineCount; i++) {
+    int writes = 0;
+
+    for (j = 0; j < sizeof(writers) / sizeof(char *); j++) {
+      writes |= strcmp(lines[i].command, writers[j]) == 0;
+    }
+    for (k = 0; lines[i].words > 0 && k < lines[i].argCount; k++) {
+      symbolNodePtr node = peepholeSymbol(lines[i].args[k]);
+      int own, element;
+
+      if (node == NULL || node->type != GUIDANCE) {
+        continue;
+      }
+      own = stringAt(node->val);
+      element = stringAt(node->val + peepholeIndex(lines[i].args[k]));
+
+      if (own >= 0 && (element != own || (writes && k == lines[i].argCount - 1))) {
+        strings[byStart[own]].excluded = 1;
+      }
+      if (element >= 0 && (element != own || (writes && k == lines[i].argCount - 1))) {
+        strings[byStart[element]].excluded = 1;
+      }
+    }
+  }
+
+  for (i = 0; i < validCount; i++) {
+    for (j = 0; j < entryCount; j++) {
+      if (strcmp(strings[byStart[i]].label, entries[j]) == 0) {
+        strings[byStart[i]].excluded = 1;
+      }
+    }
+  }
+}
+
+/*
+  Accepts the recorded lines of a file, the labels given to .entry and the amount of each.
+  Shares the strings that are suffixes of other strings, removes their words from the data table, moves the data
+  labels and updates DC. Prints a report when a string was shared.
+  Returns the amount of words saved.
+*/
+int stringPoolMerge(peepholeLine lines[], int lineCount, char *entries[], int entryCount) {
+  symbolNodePtr node;
+  dataNodePtr cur, prev = NULL, next;
+  int *order, count = 0, shared = 0, removed = 0, i;
+
+  if (stringCount == 0) {
+    return 0;
+  }
+  findValid();
+  exclude(lines, lineCount, entries, entryCount);
+
+  for (i = 0; i < validCount; i++) {
+    if ((strings[byStart[i]].words = malloc(sizeof(int) * strings[byStart[i]].length)) == NULL) {
+      printf("Cannot allocate memory\n");
+      exit(0);
+    }
+  }
+  for (cur = dataHead; cur != NULL; cur = cur->next) { /* Reads the words of the strings */
+    int s = stringAt(cur->index);
+
+    if (s >= 0) {
+      strings[byStart[s]].words[cur->index - strings[byStart[s]].start] = cur->val;
+    }
+  }
+
+  if ((order = malloc(sizeof(int) * (validCount + 1))) == NULL) {
+    printf("Cannot allocate memory\n");
+    exit(0);
+  }
+  for (i = 0; i < validCount; i++) {
+    if (!strings[byStart[i]].excluded) {
+      order[count++] = byStart[i];
+    }
+  }
+  qsort(order, count, sizeof(int), compareTails);
+  for (i = count - 2; i >= 0; i--) { /* A suffix comes right before a string that holds it, the last one holds them all */
+    if (isSuffix(order[i], order[i + 1])) {
+      strings[order[i]].host = strings[order[i + 1]].host;
+    }
+  }
+  free(order);
+
+  for (i = 0; i < validCount; i++) {
+    pooledString *s = &strings[byStart[i]];
+
+    removedBefore[i] = removed;
+    if (s->host != byStart[i]) {
+      removed += s->length;
+      shared++;
+    }
+  }
+  removedBefore[validCount] = removed;
+
+  if (removed > 0) {
+    for (cur = dataHead; cur != NULL; cur = next) { /* Unlinks the words of the shared strings */
+      int s = stringAt(cur->index);
+
+      next = cur->next;
+      if (s >= 0 && strings[byStart[s]].host != byStart[s]) {
+        if (prev == NULL) {
+          dataHead = next;
+        } else {
+          prev->next = next;
+        }
+        free(cur->label);
+        free(cur);
+      } else {
+        cur->index -= wordsRemovedBefore(cur->index);
+        prev = cur;
+      }
+    }
+    dataTail = prev;
+
+    for (node = symbolHead; node != NULL; node = node->next) {
+      int s = node->type == GUIDANCE ? stringAt(node->val) : -1;
+
+      if (s >= 0 && strings[byStart[s]].host != byStart[s]) { /* Points into the tail of the string that holds it */
+        pooledString *host = &strings[strings[byStart[s]].host];
+
+        node->val = host->start - wordsRemovedBefore(host->start) + host->length - strings[byStart[s]].length;
+      } else if (node->type == GUIDANCE) {
+        node->val -= wordsRemovedBefore(node->val);
+      }
+    }
+    DC -= removed;
+
+    printf("\n%s: string pooling shared %d of %d strings, saved %d words\n", fileName, shared, stringCount, removed);
+  }
+
+  free(byStart);
+  free(removedBefore);
+  return removed;
+}
@@ -0,0 +1,23 @@
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include "./peephole.h" /* Included here so I can use peepholeLine in the prototype */
+
+/*
+  String pooling, an optional stage of peephole.h that runs after the first scan(--pool-strings).
+  Every .string with a label is interned by createString. After the first scan the strings are sorted by their
+  characters from the last one(the 0 that ends them) backwards, so a string that is a suffix of another one, or equal
+  to it, comes right before a string that holds it. Each such string is removed from the data table and its label
+  points into the tail of the string that holds it, the rest of the data is moved back and DC is updated, all before
+  updateSymbolIndex adds IC to the data labels.
+
+  A string is only shared when nothing can tell: it is not pooled when its label is an entry(another file may write
+  it), when an instruction writes it, when an index reaches past its 0 or when another label's index reaches into it.
+  A .string that is followed by data without a label(which belongs to its label) is not pooled either.
+*/
+
+void stringPoolAdd(char *label, int length); /* Interns a .string with a label and its amount of words, called by createString */
+int stringPoolMerge(peepholeLine lines[], int lineCount, char *entries[], int entryCount); /* Shares the strings that are suffixes of others and prints a report, returns the amount of words saved */
+void stringPoolFree(void); /* Frees the strings of the previous file */
+
+#endif
@@ -5,6 +5,8 @@
 #include "./strings.h"
 #include "./status.h"
 #include "./utils.h"
+#include "./profile.h"
+#include "./structural.h"
 
 /*
   This file holds many functions that help deal with strings.
@@ -32,13 +34,18 @@ char *addExtension(char *fileName, char *ext) {
 /*
   Accepts a pointer to a string.
   Points the string forward after every space.
+  If the string is part of the indexed source code line the structural index is used to jump over the spaces.
   Returns the amount of steps forwarded.
 */
 int skipSpace(char **str) {
-  int i = 0;
+  int i = 0, pos = indexedPosition(&lineStructure, *str);
 
-  while (isspace(*(*str + i)))
-    i++;
+  if (pos >= 0) {
+    i = nextNonStructural(&lineStructure, pos, classBit(WHITESPACE_CLASS)) - pos;
+  } else {
+    while (isspace(*(*str + i)))
+      i++;
+  }
 
   *str = *str + i;
   return i;
@@ -51,12 +58,18 @@ int skipSpace(char **str) {
 */
 char *getWord(char **line) {
   char ch, *word;
-  int i = 0;
+  int i = 0, pos;
 
   skipSpace(line); /* We point the line forward to the first character that is not a space */
   word = *line;
-  while ((ch = *(*line + i)) && !isspace(ch)) { /* For each character that is not a space we point line forward */
-    (*line)++;
+  pos = indexedPosition(&lineStructure, *line);
+
+  if (pos >= 0) { /* Jumps straight to the next space using the structural index */
+    *line = lineStructure.base + nextStructural(&lineStructure, pos, classBit(WHITESPACE_CLASS));
+  } else {
+    while ((ch = *(*line + i)) && !isspace(ch)) { /* For each character that is not a space we point line forward */
+      (*line)++;
+    }
   }
 
   **line = '\0'; /* Delimits the word and the source code line */
@@ -117,11 +130,16 @@ char toSpecialChar(char *str) {
   Returns the amount of arguments, if there are syntax errors then returns a negative number.
 */
 int countArgs(char *line) {
-  int num = 0, start = 0, end = 0, i;
+  int num = 0, start = 0, end = 0, i, pos = indexedPosition(&lineStructure, line);
   char ch;
 
+  if (pos >= 0) {
+    return countArgsIndexed(pos);
+  }
+
   for (i = 0; i < strlen(line); i++) {
     ch = *(line + i);
+    profileCount(ARG_CHARS, 1);
     if (isspace(ch)) {
       if (start == 1) {
         end = 1;
@@ -152,6 +170,55 @@ int countArgs(char *line) {
   return num;
 }
 
+/*
+  Works exactly like countArgs for a line that starts at the given position of the indexed source code line.
+  Instead of testing every character it jumps from one space or comma to the next, every run of other characters
+  in between is a part of an argument.
+*/
+int countArgsIndexed(int pos) {
+  int num = 0, start = 0, end = 0, next, classes = classBit(WHITESPACE_CLASS) | classBit(COMMA_CLASS);
+
+  profileCount(ARG_CHARS, lineStructure.length - pos);
+
+  while (pos < lineStructure.length) {
+    next = nextStructural(&lineStructure, pos, classes);
+
+    if (next > pos) { /* A run of characters that are neither spaces nor commas */
+      if (end == 1) { /* It means 2 arguments were seperated only by spaces */
+        printe("Arguments must be seperated by commas", 0);
+        return -2;
+      }
+      if (start == 0) {
+        num++;
+      }
+      start = 1;
+    }
+
+    if (next == lineStructure.length) {
+      break;
+    }
+
+    if (*(lineStructure.base + next) == ',') {
+      if (start == 0) { /* This means there were 2 commas in a row */
+        printe("A comma cannot be preceeded by blank space", 0);
+        return -1;
+      }
+      start = end = 0;
+    } else if (start == 1) {
+      end = 1;
+    }
+
+    pos = next + 1;
+  }
+
+  if (start == 0 && num != 0) { /* This means the line ended with a comma ',' */
+    printe("Line cannot end with a comma", 0);
+    return -3;
+  }
+
+  return num;
+}
+
 /*
   Accepts a string, allocates memory and copies the parameter string to the allocated memory.
   Returns the char * to that new string.
@@ -164,6 +231,8 @@ char *copyString(char *str) {
     printf("Cannot allocate memory\n");
     exit(0);
   }
+  profileCount(STRING_ALLOCS, 1);
+  profileCount(STRING_BYTES, strlen(str) + 1);
 
   for (i = 0; i <= strlen(str); i++) {
     *(new + i) = *(str + i);
@@ -212,6 +281,48 @@ int checkNumeric(char *str) {
   return OK_STATUS;
 }
 
+/*
+  Accepts a string that starts with a number(can be signed, started with + or -), the range the number must be in,
+  a pointer to an int that will hold the value, and a pointer to a string that will point to the first character after the number.
+  Validates, converts and checks the range in a single pass over the digits.
+  Returns OK_STATUS if a number was found and it is in range, OUT_OF_RANGE if it was found but exceeds the range, and INVALID_ARGUMENT
+  if the string does not start with a number.
+  The caller decides what may follow the number, eg: for a whole operand end should point to a null terminator.
+*/
+int parseNumber(char *str, int min, int max, int *val, char **end) {
+  long num = 0, limit;
+  int negative = 0, inRange = 1;
+  char *start;
+
+  if (*str == '+' || *str == '-') { /* Checks if the first character is a sign, if so points it forward */
+    negative = *str == '-';
+    str++;
+  }
+
+  limit = negative ? -(long) min : max; /* The largest magnitude the number can have */
+  start = str;
+
+  while (*str >= '0' && *str <= '9') { /* Accumulates the digits, once out of range keeps scanning only to find the end */
+    if (inRange) {
+      num = num * 10 + (*str - '0');
+      inRange = num <= limit;
+    }
+    str++;
+  }
+
+  *end = str;
+
+  if (str == start) { /* No digits were found */
+    return INVALID_ARGUMENT;
+  }
+  if (!inRange) {
+    return OUT_OF_RANGE;
+  }
+
+  *val = negative ? (int) -num : (int) num;
+  return OK_STATUS;
+}
+
 /*
   Takes as a parameter an argument that is of type array. eg: STR[1]
   Eliminates the braces from that string with null terminators and returns a pointer
@@ -259,11 +370,18 @@ int isAlphaNumeric(char *str) {
 */
 char *getArg(char **line) {
   char ch, *arg;
+  int pos;
 
   skipSpace(line);
   arg = *line;
-  while ((ch = **line) && !isspace(ch) && ch != ',') {
-    (*line)++;
+  pos = indexedPosition(&lineStructure, *line);
+
+  if (pos >= 0) { /* Jumps straight to the next space or comma using the structural index */
+    *line = lineStructure.base + nextStructural(&lineStructure, pos, classBit(WHITESPACE_CLASS) | classBit(COMMA_CLASS));
+  } else {
+    while ((ch = **line) && !isspace(ch) && ch != ',') {
+      (*line)++;
+    }
   }
 
   (**line) = '\0';
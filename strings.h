@@ -9,9 +9,11 @@ char *getWord(char **line); /* Takes a pointer to a string, Delimits the first w
 char *toBinaryString(int num, int length); /* Turns a number to string of its binary representation, the amount of bits will be the second argument */
 char toSpecialChar(char *str); /* Takes a string of binary digits and returns the speical character representation of the first digits */
 int countArgs(char *line); /* Takes a line of source code and count how many arguments are there, argument are delimited by commas ',' */
+int countArgsIndexed(int pos); /* Works like countArgs for the part of the indexed source code line that starts at the given position */
 char *copyString(char *str); /* Takes a string, creates a new one and copies all of the character of the original string to it, returns the new string */
 int checkNumericUnsigned(char *str); /* Checks if a string characters are all digits */
 int checkNumeric(char *str); /* Checks if a string characters are all digits, except for the first one that can also be a sign '+'/'-' */
+int parseNumber(char *str, int min, int max, int *val, char **end); /* Parses a signed number in a single pass, stores its value in val and the character after it in end, returns wether it is a number in the range [min, max] */
 char *getIndexFromArr(char *arr); /* Takes a string that represents an array argument, replaces the braces with null terminators and returns a pointer to the start of the index */
 int isAlphaNumeric(char *str); /* Takes a string and checks if all characters are alphanumeric */
 char *getArg(char **line); /* Takes a pointer to a line of source code, returns the first argument stumpled upon and points the line after that argument */
@@ -0,0 +1,333 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "./structural.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define VECTOR_INDEX /* SSE2 and AVX2 implementations are compiled only for x86-64(where SSE2 is always present) with a compiler that supports them */
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+/*
+  Builds the structural index of a buffer and searches it.
+  The scalar implementation is the reference, the vectorized implementations must produce the exact same bitmaps.
+*/
+
+#define WORD_BITS (sizeof(unsigned long) * CHAR_BIT) /* The amount of bits in a single word of a bitmap */
+#define BLOCK 32 /* The amount of characters the vectorized implementations handle at once, AVX2 in 1 step and SSE2 in 2 */
+
+structuralIndex lineStructure;
+
+/*
+  Returns wether ch is of the whitespace class, the same characters isspace accepts in the C locale.
+*/
+#define isWhitespace(ch) ((ch) == ' ' || ((ch) >= '\t' && (ch) <= '\r'))
+
+/*
+  Makes sure the bitmaps of the index are large enough for length characters and clears them.
+*/
+static void prepareIndex(structuralIndex *idx, char *buf, int length) {
+  int words = (length + BLOCK) / WORD_BITS + 1, i; /* Enough for the length rounded up to a whole block */
+
+  if (words > idx->words) {
+    for (i = 0; i < CLASS_AMOUNT; i++) {
+      idx->masks[i] = (unsigned long *) realloc(idx->masks[i], sizeof(unsigned long) * words);
+
+      if (idx->masks[i] == NULL) {
+        printf("Cannot allocate memory\n");
+        exit(0);
+      }
+    }
+    idx->words = words;
+  }
+
+  for (i = 0; i < CLASS_AMOUNT; i++) {
+    memset(idx->masks[i], 0, sizeof(unsigned long) * idx->words);
+  }
+
+  idx->base = buf;
+  idx->length = length;
+}
+
+/*
+  The reference implementation, tests the characters one by one.
+*/
+static void indexScalar(structuralIndex *idx, char *buf, int length) {
+  int i;
+
+  for (i = 0; i < length; i++) {
+    char ch = buf[i];
+    unsigned long bit = 1UL << (i % WORD_BITS);
+    int word = i / WORD_BITS;
+
+    if (isWhitespace(ch)) {
+      idx->masks[WHITESPACE_CLASS][word] |= bit;
+    }
+    if (ch == '\n') {
+      idx->masks[NEWLINE_CLASS][word] |= bit;
+    }
+    if (ch == ',') {
+      idx->masks[COMMA_CLASS][word] |= bit;
+    }
+    if (ch == '"') {
+      idx->masks[QUOTE_CLASS][word] |= bit;
+    }
+    if (ch == '[' || ch == ']') {
+      idx->masks[BRACKET_CLASS][word] |= bit;
+    }
+    if (ch == ';') {
+      idx->masks[COMMENT_CLASS][word] |= bit;
+    }
+  }
+}
+
+#ifdef VECTOR_INDEX
+
+/*
+  Stores the masks of a single block into the bitmaps, pos is a multiple of BLOCK so the block never spans 2 words.
+*/
+static void storeBlock(structuralIndex *idx, int pos, unsigned long *blockMasks) {
+  int i;
+
+  for (i = 0; i < CLASS_AMOUNT; i++) {
+    idx->masks[i][pos / WORD_BITS] |= blockMasks[i] << (pos % WORD_BITS);
+  }
+}
+
+/*
+  Calls the block function for every block of the buffer, the last partial block is copied to a zero padded
+  buffer first so no character after the buffer is read. Zeros are not of any class.
+*/
+#define forEachBlock(idx, buf, length, blockFunc)                     \
+  {                                                                   \
+    unsigned long blockMasks[CLASS_AMOUNT];                           \
+    char tail[BLOCK];                                                 \
+    int pos;                                                          \
+                                                                      \
+    for (pos = 0; pos + BLOCK <= length; pos += BLOCK) {              \
+      blockFunc(buf + pos, blockMasks);                               \
+      storeBlock(idx, pos, blockMasks);                               \
+    }                                                                 \
+    if (pos < length) {                                               \
+      memset(tail, 0, BLOCK);                                         \
+      memcpy(tail, buf + pos, length - pos);                          \
+      blockFunc(tail, blockMasks);                                    \
+      storeBlock(idx, pos, blockMasks);                               \
+    }                                                                 \
+  }
+
+/*
+  Classifies 16 characters with SSE2 and adds their masks to blockMasks at the given shift.
+*/
+static void classifySSE2(char *p, unsigned long *blockMasks, int shift) {
+  __m128i chars = _mm_loadu_si128((__m128i *) p);
+  __m128i space = _mm_or_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8(' ')),
+                               _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('\t' - 1)),
+                                             _mm_cmpgt_epi8(_mm_set1_epi8('\r' + 1), chars)));
+  __m128i brackets = _mm_or_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8('[')), _mm_cmpeq_epi8(chars, _mm_set1_epi8(']')));
+
+  blockMasks[WHITESPACE_CLASS] |= (unsigned long) _mm_movemask_epi8(space) << shift;
+  blockMasks[NEWLINE_CLASS] |= (unsigned long) _mm_movemask_epi8(_mm_cmpeq_epi8(chars, _mm_set1_epi8('\n'))) << shift;
+  blockMasks[COMMA_CLASS] |= (unsigned long) _mm_movemask_epi8(_mm_cmpeq_epi8(chars, _mm_set1_epi8(','))) << shift;
+  blockMasks[QUOTE_CLASS] |= (unsigned long) _mm_movemask_epi8(_mm_cmpeq_epi8(chars, _mm_set1_epi8('"'))) << shift;
+  blockMasks[BRACKET_CLASS] |= (unsigned long) _mm_movemask_epi8(brackets) << shift;
+  blockMasks[COMMENT_CLASS] |= (unsigned long) _mm_movemask_epi8(_mm_cmpeq_epi8(chars, _mm_set1_epi8(';'))) << shift;
+}
+
+static void blockSSE2(char *p, unsigned long *blockMasks) {
+  memset(blockMasks, 0, sizeof(unsigned long) * CLASS_AMOUNT);
+  classifySSE2(p, blockMasks, 0);
+  classifySSE2(p + BLOCK / 2, blockMasks, BLOCK / 2);
+}
+
+/*
+  The AVX2 masks are 32 bits, they are cast to unsigned int first so the sign of the int movemask returns is not extended.
+*/
+__attribute__((target("avx2")))
+static void blockAVX2(char *p, unsigned long *blockMasks) {
+  __m256i chars = _mm256_loadu_si256((__m256i *) p);
+  __m256i space = _mm256_or_si256(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8(' ')),
+                                  _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8('\t' - 1)),
+                                                   _mm256_cmpgt_epi8(_mm256_set1_epi8('\r' + 1), chars)));
+  __m256i brackets = _mm256_or_si256(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8('[')), _mm256_cmpeq_epi8(chars, _mm256_set1_epi8(']')));
+
+  blockMasks[WHITESPACE_CLASS] = (unsigned int) _mm256_movemask_epi8(space);
+  blockMasks[NEWLINE_CLASS] = (unsigned int) _mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8('\n')));
+  blockMasks[COMMA_CLASS] = (unsigned int) _mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8(',')));
+  blockMasks[QUOTE_CLASS] = (unsigned int) _mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8('"')));
+  blockMasks[BRACKET_CLASS] = (unsigned int) _mm256_movemask_epi8(brackets);
+  blockMasks[COMMENT_CLASS] = (unsigned int) _mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8(';')));
+}
+
+static void indexSSE2(structuralIndex *idx, char *buf, int length) {
+  forEachBlock(idx, buf, length, blockSSE2)
+}
+
+static void indexAVX2(structuralIndex *idx, char *buf, int length) {
+  forEachBlock(idx, buf, length, blockAVX2)
+}
+
+#endif
+
+/*
+  Returns the implementation that indexBuffer uses, the CPU is checked only on the first call.
+*/
+int indexLevel() {
+  static int level = -1;
+
+  if (level < 0) {
+#ifdef VECTOR_INDEX
+    __builtin_cpu_init();
+    level = __builtin_cpu_supports("avx2") ? AVX2_LEVEL : SSE2_LEVEL;
+#else
+    level = SCALAR_LEVEL;
+#endif
+  }
+
+  return level;
+}
+
+void indexBufferLevel(structuralIndex *idx, char *buf, int length, int level) {
+  prepareIndex(idx, buf, length);
+
+  switch (level) {
+#ifdef VECTOR_INDEX
+    case AVX2_LEVEL:
+      indexAVX2(idx, buf, length);
+      break;
+    case SSE2_LEVEL:
+      indexSSE2(idx, buf, length);
+      break;
+#endif
+    default:
+      indexScalar(idx, buf, length);
+  }
+}
+
+void indexBuffer(structuralIndex *idx, char *buf, int length) {
+  indexBufferLevel(idx, buf, length, indexLevel());
+}
+
+int indexedPosition(structuralIndex *idx, char *p) {
+  if (idx->base == NULL || p < idx->base || p > idx->base + idx->length) {
+    return -1;
+  }
+
+  return p - idx->base;
+}
+
+/*
+  Returns the index of the lowest set bit of a word that is not 0.
+*/
+static int lowestBit(unsigned long word) {
+#ifdef __GNUC__
+  return __builtin_ctzl(word);
+#else
+  int i = 0;
+
+  while (!(word & 1UL)) {
+    word >>= 1;
+    i++;
+  }
+  return i;
+#endif
+}
+
+/*
+  Returns the index of the highest set bit of a word that is not 0.
+*/
+static int highestBit(unsigned long word) {
+#ifdef __GNUC__
+  return WORD_BITS - 1 - __builtin_clzl(word);
+#else
+  int i = WORD_BITS - 1;
+
+  while (!(word & (1UL << i))) {
+    i--;
+  }
+  return i;
+#endif
+}
+
+/*
+  Returns the word at the given index of the union of the bitmaps of the classes, inverted if invert is set.
+  Bits after the length are always cleared.
+*/
+static unsigned long classWord(structuralIndex *idx, int word, int classes, int invert) {
+  unsigned long bits = 0;
+  int i;
+
+  for (i = 0; i < CLASS_AMOUNT; i++) {
+    if (classes & classBit(i)) {
+      bits |= idx->masks[i][word];
+    }
+  }
+
+  if (invert) {
+    bits = ~bits;
+  }
+  if ((word + 1) * WORD_BITS > idx->length) { /* The last word, clears the bits after the length */
+    int used = idx->length - word * WORD_BITS;
+
+    bits &= used > 0 ? ~0UL >> (WORD_BITS - used) : 0;
+  }
+
+  return bits;
+}
+
+/*
+  Searches forward from pos for the first set bit of the union of the classes, or the first clear bit if invert is set.
+*/
+static int searchForward(structuralIndex *idx, int pos, int classes, int invert) {
+  int word = pos / WORD_BITS;
+  unsigned long bits;
+
+  if (pos >= idx->length) {
+    return idx->length;
+  }
+
+  bits = classWord(idx, word, classes, invert) & (~0UL << (pos % WORD_BITS));
+
+  while (bits == 0) {
+    if (++word * WORD_BITS >= idx->length) {
+      return idx->length;
+    }
+    bits = classWord(idx, word, classes, invert);
+  }
+
+  return word * WORD_BITS + lowestBit(bits);
+}
+
+int nextStructural(structuralIndex *idx, int pos, int classes) {
+  return searchForward(idx, pos, classes, 0);
+}
+
+int nextNonStructural(structuralIndex *idx, int pos, int classes) {
+  return searchForward(idx, pos, classes, 1);
+}
+
+int lastNonStructural(structuralIndex *idx, int pos, int classes) {
+  int word;
+  unsigned long bits;
+
+  if (pos > idx->length) {
+    pos = idx->length;
+  }
+  if (--pos < 0) { /* pos is now the last position that may be returned */
+    return -1;
+  }
+
+  word = pos / WORD_BITS;
+  bits = classWord(idx, word, classes, 1) & (~0UL >> (WORD_BITS - 1 - pos % WORD_BITS));
+
+  while (bits == 0) {
+    if (--word < 0) {
+      return -1;
+    }
+    bits = classWord(idx, word, classes, 1);
+  }
+
+  return word * WORD_BITS + highestBit(bits);
+}
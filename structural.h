@@ -0,0 +1,50 @@
+#ifndef STRUCTURAL_H
+#define STRUCTURAL_H
+
+/*
+  A structural index of a buffer: for each class of structural character(whitespace, commas, quotes...) a bitmap
+  with a bit set for every position in the buffer that holds a character of that class.
+  The index is built in a single vectorized pass(SSE2, or AVX2 when the CPU supports it) and the line tokenizer
+  uses it to jump between delimiters instead of testing every character.
+  The index describes the buffer as it was when it was built, the tokenizer only searches ahead of the characters
+  it replaced with null terminators, so the index stays valid while the line is being processed.
+*/
+
+enum STRUCTURAL_CLASS /* Classes of structural characters */
+{
+  WHITESPACE_CLASS, /* Every character isspace returns true for in the C locale */
+  NEWLINE_CLASS,
+  COMMA_CLASS,
+  QUOTE_CLASS,
+  BRACKET_CLASS, /* '[' and ']' */
+  COMMENT_CLASS, /* ';' */
+  CLASS_AMOUNT
+};
+
+enum INDEX_LEVEL /* Implementations of the index builder */
+{
+  SCALAR_LEVEL,
+  SSE2_LEVEL,
+  AVX2_LEVEL
+};
+
+#define classBit(c) (1 << (c)) /* Classes are passed to the search functions as a bitmask of classBit's */
+
+typedef struct structuralIndex {
+  char *base; /* The buffer that was indexed, NULL when the index is not in use */
+  int length; /* The amount of characters that were indexed */
+  int words; /* The amount of words in each bitmap */
+  unsigned long *masks[CLASS_AMOUNT]; /* A bitmap for each class */
+} structuralIndex;
+
+extern structuralIndex lineStructure; /* The index of the source code line that is currently being scanned */
+
+void indexBuffer(structuralIndex *idx, char *buf, int length); /* Builds the index of buf with the best implementation the CPU supports */
+void indexBufferLevel(structuralIndex *idx, char *buf, int length, int level); /* Builds the index of buf with the given implementation(enum INDEX_LEVEL) */
+int indexLevel(void); /* Returns the implementation indexBuffer uses on this CPU(enum INDEX_LEVEL) */
+int indexedPosition(structuralIndex *idx, char *p); /* Returns the position of p in the indexed buffer, or -1 if p is outside of it */
+int nextStructural(structuralIndex *idx, int pos, int classes); /* Returns the first position from pos that holds a character of one of the classes, or the length */
+int nextNonStructural(structuralIndex *idx, int pos, int classes); /* Returns the first position from pos that doesn't hold a character of the classes, or the length */
+int lastNonStructural(structuralIndex *idx, int pos, int classes); /* Returns the last position before pos that doesn't hold a character of the classes, or -1 */
+
+#endif
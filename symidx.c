@@ -0,0 +1,245 @@
+/*
+  Queries and maintains the symbol index the assembler appends to with --index.
+
+  USAGE:
+  symidx INDEX NAME...  Prints every definition, entry and use of each name: its kind, module and address
+  symidx -s INDEX       Prints statistics of the index and the time of a lookup
+  symidx -c INDEX       Compacts the index: sizes its directory to the amount of records and sorts every chain by name,
+                        then by module
+  To create the program use 'make symidx'.
+*/
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "./symindex.h"
+
+#define MAX_PATH 1024
+#define LOOKUP_ROUNDS 1000000 /* The amount of lookups that are timed by -s */
+
+static char *kindNames[] = { "module", "defined", "entry", "use" };
+static indexFile sortIndex; /* The index whose records are sorted by compareRecords */
+
+#define recordSize(record) ((sizeof(indexRecord) + (record)->length + 1 + OBJECT_ALIGN - 1) / OBJECT_ALIGN * OBJECT_ALIGN)
+#define firstRecord(idx) (sizeof(indexHeader) + sizeof(unsigned int) * (idx)->header->bucketCount)
+
+/*
+  Prints every record of each of the names.
+*/
+static void lookupNames(indexFile *idx, char **names, int count) {
+  int i;
+
+  for (i = 0; i < count; i++) {
+    indexRecord *record = indexFirst(idx, names[i]);
+
+    if (record == NULL) {
+      printf("%s\tnot found\n", names[i]);
+    }
+    for (; record != NULL; record = indexNext(idx, record, names[i])) {
+      printf("%s\t%s\t%s\t%04u\n", names[i], kindNames[record->kind < USE_RECORD ? record->kind : USE_RECORD],
+             indexName(indexRecordAt(idx, record->module)), record->address);
+    }
+  }
+}
+
+/*
+  Prints the amount of records, the lengths of the chains and the average time of a lookup of a name from the index.
+*/
+static void printStats(indexFile *idx) {
+  unsigned long used = 0, longest = 0, i, offset;
+  char **names = malloc(sizeof(char *) * (idx->header->recordCount + 1));
+  struct timespec start, end;
+  long found = 0, count = 0;
+
+  for (i = 0; i < idx->header->bucketCount; i++) {
+    unsigned long length = 0;
+
+    for (offset = idx->directory[i]; offset != 0; offset = indexRecordAt(idx, offset)->next) {
+      length++;
+    }
+    used += length > 0;
+    longest = length > longest ? length : longest;
+  }
+
+  printf("modules\t%u\nrecords\t%u\nbuckets\t%u\nused buckets\t%lu\nlongest chain\t%lu\nsize\t%u\n", idx->header->moduleCount,
+         idx->header->recordCount, idx->header->bucketCount, used, longest, idx->header->fileSize);
+
+  if (names == NULL || idx->header->recordCount == 0) {
+    free(names);
+    return;
+  }
+
+  for (offset = firstRecord(idx); offset < idx->header->fileSize; offset += recordSize(indexRecordAt(idx, offset))) {
+    if (indexRecordAt(idx, offset)->kind != MODULE_RECORD) {
+      names[count++] = indexName(indexRecordAt(idx, offset));
+    }
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (i = 0; i < LOOKUP_ROUNDS; i++) { /* Looks up names spread over the whole index */
+    found += indexFirst(idx, names[(i * 7919) % count]) != NULL;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  printf("lookup\t%.3f us\nfound\t%ld of %d\n", ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / LOOKUP_ROUNDS / 1000,
+         found, LOOKUP_ROUNDS);
+  free(names);
+}
+
+/*
+  Orders the symbol records by name, then by module name, kind and address.
+*/
+static int compareRecords(const void *a, const void *b) {
+  indexRecord *x = indexRecordAt(&sortIndex, *(unsigned long *) a), *y = indexRecordAt(&sortIndex, *(unsigned long *) b);
+  int cmp = strcmp(indexName(x), indexName(y));
+
+  if (cmp == 0) {
+    cmp = strcmp(indexName(indexRecordAt(&sortIndex, x->module)), indexName(indexRecordAt(&sortIndex, y->module)));
+  }
+  if (cmp == 0) {
+    cmp = x->kind != y->kind ? x->kind - y->kind : x->address - y->address;
+  }
+  return cmp;
+}
+
+/*
+  Returns the new offset of a module record, the old offsets are in ascending order.
+*/
+static unsigned long findModule(unsigned long *oldOffsets, unsigned long *newOffsets, unsigned long count, unsigned long offset) {
+  unsigned long low = 0, high = count;
+
+  while (low + 1 < high) {
+    unsigned long mid = (low + high) / 2;
+
+    if (oldOffsets[mid] <= offset) {
+      low = mid;
+    } else {
+      high = mid;
+    }
+  }
+  return newOffsets[low];
+}
+
+/*
+  Copies a record and its name to the end of the buffer, returns its offset.
+*/
+static unsigned long copyRecord(objectBuffer *buf, indexRecord *record) {
+  unsigned long offset = objectReserve(buf, sizeof(indexRecord) + record->length + 1);
+
+  memcpy(buf->data + offset, record, sizeof(indexRecord) + record->length + 1);
+  return offset;
+}
+
+/*
+  Rewrites the index: the module records first, then the symbol records sorted by compareRecords, linked so every chain
+  is in the same order. The directory has at least twice as many buckets as records.
+  The new index is written next to the old one and renamed over it while the exclusive lock of the old one is held,
+  appenders that wait for that lock notice the file was replaced and open the new one.
+*/
+static int compact(char *fileName, indexFile *idx) {
+  unsigned long count = 0, modules = 0, buckets = 1024, offset, directory, i,
+  *symbols = malloc(sizeof(unsigned long) * (idx->header->recordCount + 1)),
+  *oldModules = malloc(sizeof(unsigned long) * (idx->header->moduleCount + 1)),
+  *newModules = malloc(sizeof(unsigned long) * (idx->header->moduleCount + 1));
+  char path[MAX_PATH + 16];
+  objectBuffer buf;
+  FILE *fp;
+
+  if (symbols == NULL || oldModules == NULL || newModules == NULL) {
+    printf("Cannot allocate memory\n");
+    exit(1);
+  }
+
+  while (buckets < idx->header->recordCount * 2) {
+    buckets *= 2;
+  }
+
+  objectInit(&buf);
+  objectReserve(&buf, sizeof(indexHeader));
+  directory = objectReserve(&buf, sizeof(unsigned int) * buckets);
+
+  for (offset = firstRecord(idx); offset < idx->header->fileSize; offset += recordSize(indexRecordAt(idx, offset))) {
+    indexRecord *record = indexRecordAt(idx, offset);
+
+    if (record->kind == MODULE_RECORD && modules < idx->header->moduleCount) {
+      oldModules[modules] = offset;
+      newModules[modules++] = copyRecord(&buf, record);
+    } else if (record->kind != MODULE_RECORD && count < idx->header->recordCount) {
+      symbols[count++] = offset;
+    }
+  }
+
+  sortIndex = *idx;
+  qsort(symbols, count, sizeof(unsigned long), compareRecords);
+
+  for (i = count; i > 0; i--) { /* Linked from the last one so every chain ends up in the sorted order */
+    indexRecord *record = indexRecordAt(idx, symbols[i - 1]);
+    unsigned long head = directory + sizeof(unsigned int) * (record->hash & (buckets - 1)), next;
+
+    next = buf.data[head] | buf.data[head + 1] << 8 | (unsigned long) buf.data[head + 2] << 16 | (unsigned long) buf.data[head + 3] << 24;
+    offset = copyRecord(&buf, record);
+    objectPut32(&buf, offset + offsetof(indexRecord, next), next);
+    objectPut32(&buf, offset + offsetof(indexRecord, module), findModule(oldModules, newModules, modules, record->module));
+    objectPut32(&buf, head, offset);
+  }
+
+  objectReserve(&buf, 0); /* Pads the last name so appended modules start aligned */
+  memcpy(buf.data, INDEX_MAGIC, sizeof(idx->header->magic));
+  objectPut16(&buf, offsetof(indexHeader, version), INDEX_VERSION);
+  objectPut16(&buf, offsetof(indexHeader, headerSize), sizeof(indexHeader));
+  objectPut32(&buf, offsetof(indexHeader, bucketCount), buckets);
+  objectPut32(&buf, offsetof(indexHeader, recordCount), count);
+  objectPut32(&buf, offsetof(indexHeader, moduleCount), modules);
+  objectPut32(&buf, offsetof(indexHeader, fileSize), buf.size);
+
+  sprintf(path, "%s.tmp", fileName);
+  if ((fp = fopen(path, "wb")) == NULL || fwrite(buf.data, 1, buf.size, fp) != buf.size || fclose(fp) != 0 ||
+      rename(path, fileName) != 0) {
+    printf("Cannot write to file %s\n", path);
+    objectFree(&buf);
+    return -1;
+  }
+
+  printf("Compacted %lu records of %lu modules into %lu buckets\n", count, modules, buckets);
+  objectFree(&buf);
+  free(symbols);
+  free(oldModules);
+  free(newModules);
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  indexFile idx;
+  int status = 0;
+
+  if (argc < 3 || (argv[1][0] == '-' && strcmp(argv[1], "-s") != 0 && strcmp(argv[1], "-c") != 0) ||
+      strlen(argv[argv[1][0] == '-' ? 2 : 1]) >= MAX_PATH) {
+    printf("USAGE: symidx INDEX NAME... | symidx -s INDEX | symidx -c INDEX\n");
+    return 1;
+  }
+
+  if (argv[1][0] != '-') {
+    if (indexMap(argv[1], &idx, 0) != 0) {
+      return 1;
+    }
+    lookupNames(&idx, argv + 2, argc - 2);
+  } else if (strcmp(argv[1], "-s") == 0) {
+    if (indexMap(argv[2], &idx, 0) != 0) {
+      return 1;
+    }
+    printStats(&idx);
+  } else {
+    if (indexMap(argv[2], &idx, 1) != 0) { /* Keeps appenders out until the new index replaces this one */
+      return 1;
+    }
+    status = compact(argv[2], &idx);
+  }
+
+  indexUnmap(&idx);
+  return status ? 1 : 0;
+}
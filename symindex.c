@@ -0,0 +1,250 @@
+#define _DEFAULT_SOURCE /* Required for flock */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "./symindex.h"
+
+/*
+  This file holds the functions that append to the symbol index and map it for lookups.
+  The layout of the index is described in symindex.h. The header and the directory are read and written in place
+  through a shared mapping, so the index is used on little endian machines like the binary object files.
+*/
+
+typedef char indexRecordSizeCheck[sizeof(indexRecord) == 20 && sizeof(indexHeader) == 24 ? 1 : -1]; /* The mapped structs require 16 and 32 bit shorts and ints */
+
+/*
+  Returns the FNV-1a hash of a name.
+*/
+unsigned long indexHash(char *name) {
+  unsigned long h = 2166136261UL;
+
+  while (*name) {
+    h = ((h ^ (unsigned char) *name++) * 16777619UL) & 0xffffffffUL;
+  }
+  return h;
+}
+
+/*
+  Opens the index for appending and takes its exclusive lock.
+  A compaction replaces the file with a new one, so after the lock is taken the file is checked to still be the one
+  at the path, otherwise the new one is opened.
+  Returns the file descriptor, or -1.
+*/
+static int lockIndex(char *fileName, struct stat *st) {
+  struct stat cur;
+  int fd;
+
+  for (;;) {
+    if ((fd = open(fileName, O_RDWR | O_CREAT, 0644)) < 0) {
+      printf("Cannot open file %s\n", fileName);
+      return -1;
+    }
+    if (flock(fd, LOCK_EX) != 0 || fstat(fd, st) != 0) {
+      printf("Cannot lock file %s\n", fileName);
+      close(fd);
+      return -1;
+    }
+    if (stat(fileName, &cur) == 0 && cur.st_ino == st->st_ino && cur.st_dev == st->st_dev) {
+      return fd;
+    }
+    close(fd);
+  }
+}
+
+/*
+  Writes the header and an empty directory to a new index.
+*/
+static int createIndex(int fd) {
+  indexHeader header;
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+  header.version = INDEX_VERSION;
+  header.headerSize = sizeof(indexHeader);
+  header.bucketCount = INDEX_BUCKETS;
+  header.fileSize = sizeof(indexHeader) + sizeof(unsigned int) * INDEX_BUCKETS;
+
+  if (ftruncate(fd, header.fileSize) != 0 || pwrite(fd, &header, sizeof(header), 0) != sizeof(header)) {
+    return -1;
+  }
+  return 0;
+}
+
+/*
+  Checks the header of an index, size is the size of the file.
+*/
+static int validHeader(indexHeader *header, unsigned long size) {
+  return memcmp(header->magic, INDEX_MAGIC, sizeof(header->magic)) == 0 && header->version == INDEX_VERSION &&
+         header->headerSize == sizeof(indexHeader) && header->bucketCount > 0 &&
+         (header->bucketCount & (header->bucketCount - 1)) == 0 &&
+         header->bucketCount <= (size - sizeof(indexHeader)) / sizeof(unsigned int) && header->fileSize <= size;
+}
+
+/*
+  Adds a record and its name to the buffer, returns its offset in the buffer.
+*/
+static unsigned long addRecord(objectBuffer *buf, char *name, unsigned long hash, unsigned long module, int address, int kind) {
+  unsigned long length = strlen(name), offset = objectReserve(buf, sizeof(indexRecord) + length + 1);
+
+  objectPut32(buf, offset + offsetof(indexRecord, hash), hash);
+  objectPut32(buf, offset + offsetof(indexRecord, module), module);
+  objectPut16(buf, offset + offsetof(indexRecord, address), address);
+  objectPut16(buf, offset + offsetof(indexRecord, length), length);
+  buf->data[offset + offsetof(indexRecord, kind)] = kind;
+  memcpy(buf->data + offset + sizeof(indexRecord), name, length + 1);
+  return offset;
+}
+
+/*
+  Accepts the name of the index file, the name of a module and its symbols.
+  Creates the index if it doesn't exist, takes its exclusive lock and appends a module record followed by a record for
+  each symbol, every symbol record is linked at the head of the chain of its bucket.
+  Returns 0 on success, prints a message and returns -1 otherwise.
+*/
+int indexAppend(char *fileName, char *module, indexSymbol *symbols, int count) {
+  struct stat st;
+  indexHeader *header;
+  unsigned int *directory;
+  unsigned long base, mapSize, moduleOffset;
+  objectBuffer buf;
+  int fd = lockIndex(fileName, &st), i, status = 0;
+
+  if (fd < 0) {
+    return -1;
+  }
+
+  if (st.st_size == 0 && createIndex(fd) != 0) {
+    printf("Cannot write to file %s\n", fileName);
+    close(fd);
+    return -1;
+  }
+  if (fstat(fd, &st) != 0 || st.st_size < sizeof(indexHeader)) {
+    printf("%s is not a symbol index\n", fileName);
+    close(fd);
+    return -1;
+  }
+
+  mapSize = st.st_size; /* Only the header and the directory are written through the mapping */
+  header = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (header == MAP_FAILED || !validHeader(header, mapSize)) {
+    printf("%s is not a symbol index\n", fileName);
+    if (header != MAP_FAILED) {
+      munmap(header, mapSize);
+    }
+    close(fd);
+    return -1;
+  }
+  directory = (unsigned int *) (header + 1);
+  base = header->fileSize; /* Always a multiple of 4, so the alignment of the buffer is the alignment in the file */
+
+  objectInit(&buf);
+  moduleOffset = base + addRecord(&buf, module, 0, 0, 0, MODULE_RECORD);
+
+  for (i = 0; i < count; i++) {
+    unsigned long hash = indexHash(symbols[i].name), offset;
+    unsigned int *head = &directory[hash & (header->bucketCount - 1)];
+
+    offset = addRecord(&buf, symbols[i].name, hash, moduleOffset, symbols[i].address, symbols[i].kind);
+    objectPut32(&buf, offset + offsetof(indexRecord, next), *head);
+    *head = base + offset;
+  }
+  objectReserve(&buf, 0); /* Pads the last name so the next module starts aligned */
+
+  if (pwrite(fd, buf.data, buf.size, base) != buf.size) {
+    printf("Cannot write to file %s\n", fileName);
+    status = -1;
+  } else {
+    header->fileSize = base + buf.size;
+    header->recordCount += count;
+    header->moduleCount++;
+  }
+
+  objectFree(&buf);
+  munmap(header, mapSize);
+  close(fd); /* Releases the lock */
+  return status;
+}
+
+/*
+  Accepts the name of an index file and a struct to fill.
+  Opens the index, takes its shared lock(or its exclusive lock when exclusive is true, to keep appenders out) and maps it
+  to memory read only, the lock is held until indexUnmap.
+  Prints a message and returns -1 if the index cannot be mapped or is not valid, returns 0 on success.
+*/
+int indexMap(char *fileName, indexFile *idx, int exclusive) {
+  struct stat st;
+  void *map;
+
+  if ((idx->fd = open(fileName, O_RDONLY)) < 0) {
+    printf("Cannot open file %s\n", fileName);
+    return -1;
+  }
+  if (flock(idx->fd, exclusive ? LOCK_EX : LOCK_SH) != 0 || fstat(idx->fd, &st) != 0 || st.st_size < sizeof(indexHeader)) {
+    printf("%s is not a symbol index\n", fileName);
+    close(idx->fd);
+    return -1;
+  }
+
+  map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, idx->fd, 0);
+  if (map == MAP_FAILED || !validHeader(map, st.st_size)) {
+    printf("%s is not a symbol index\n", fileName);
+    if (map != MAP_FAILED) {
+      munmap(map, st.st_size);
+    }
+    close(idx->fd);
+    return -1;
+  }
+
+  idx->header = map;
+  idx->directory = (unsigned int *) (idx->header + 1);
+  idx->size = st.st_size;
+  return 0;
+}
+
+/*
+  Unmaps an index that was mapped with indexMap and releases its lock.
+*/
+void indexUnmap(indexFile *idx) {
+  munmap(idx->header, idx->size);
+  close(idx->fd);
+  idx->header = NULL;
+}
+
+/*
+  Accepts a mapped index, an offset of a record in a chain, the name and its hash.
+  Follows the chain from the offset and returns the first record of the name, or NULL.
+*/
+static indexRecord *findRecord(indexFile *idx, unsigned long offset, char *name, unsigned long hash) {
+  while (offset != 0 && offset + sizeof(indexRecord) <= idx->header->fileSize) {
+    indexRecord *record = indexRecordAt(idx, offset);
+
+    if (record->hash == hash && strcmp(indexName(record), name) == 0) {
+      return record;
+    }
+    offset = record->next;
+  }
+  return NULL;
+}
+
+/*
+  Returns the first record of the name in the index, or NULL if the name is not in it.
+*/
+indexRecord *indexFirst(indexFile *idx, char *name) {
+  unsigned long hash = indexHash(name);
+
+  return findRecord(idx, idx->directory[hash & (idx->header->bucketCount - 1)], name, hash);
+}
+
+/*
+  Returns the record of the name that follows the given one, or NULL if it was the last one.
+*/
+indexRecord *indexNext(indexFile *idx, indexRecord *record, char *name) {
+  return findRecord(idx, record->next, name, record->hash);
+}
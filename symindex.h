@@ -0,0 +1,78 @@
+#ifndef SYMINDEX_H
+#define SYMINDEX_H
+
+/*
+  A project wide symbol index: one file that many runs of the assembler append the symbols of their modules to, and that
+  tools map to memory to find where a label is defined or used without reading any source or output file.
+
+  Layout, all fields little endian and every record starts at an offset that is a multiple of 4:
+  header      an indexHeader
+  directory   bucketCount 32 bit offsets, the first record of each hash bucket or 0
+  records     indexRecord's, each followed by its null terminated name. A module record holds the name of a module and
+              every symbol record points to the module record it belongs to. Symbol records of the same bucket are
+              chained through 'next'.
+
+  Appenders hold an exclusive lock(flock) on the file while they append the records of a module and link them into the
+  directory, readers hold a shared lock while the file is mapped, so runs of the assembler may append in parallel.
+  Appended records are linked at the head of their chains, 'symidx -c' rewrites the file with a directory sized to the
+  amount of records and every chain sorted by name.
+*/
+
+#include "./object.h"
+
+#define INDEX_MAGIC "ASIX" /* The first 4 bytes of every symbol index file */
+#define INDEX_VERSION 1
+#define INDEX_BUCKETS 262144 /* The amount of buckets of a new index, a power of 2 */
+
+enum INDEX_KIND /* Kinds of records */
+{
+  MODULE_RECORD, /* The name of a module */
+  DEFINED_RECORD, /* A label that is defined in a module, the address is the final address of the label */
+  ENTRY_RECORD, /* A label that is defined and exported(.entry) by a module */
+  USE_RECORD /* A use of an external, the address is the word that uses it */
+};
+
+typedef struct indexHeader {
+  char magic[4];
+  unsigned short version,
+  headerSize; /* The size of this struct, the directory starts after it */
+  unsigned int bucketCount,
+  recordCount, /* The amount of symbol records */
+  moduleCount,
+  fileSize; /* The end of the last record, appenders write from here */
+} indexHeader;
+
+typedef struct indexRecord {
+  unsigned int next, /* The offset of the next record in the same bucket, 0 ends the chain */
+  hash, /* The hash of the name, compared before the names are */
+  module; /* The offset of the module record, 0 for module records */
+  unsigned short address,
+  length; /* The length of the name */
+  unsigned char kind; /* enum INDEX_KIND */
+  unsigned char pad[3];
+} indexRecord;
+
+typedef struct indexSymbol { /* A symbol of a module that is appended to the index */
+  char *name;
+  int address;
+  int kind; /* enum INDEX_KIND */
+} indexSymbol;
+
+typedef struct indexFile { /* A symbol index that was mapped to memory */
+  indexHeader *header;
+  unsigned int *directory;
+  unsigned long size;
+  int fd; /* Holds the shared lock while the index is mapped */
+} indexFile;
+
+#define indexRecordAt(idx, offset) ((indexRecord *) ((char *) (idx)->header + (offset))) /* Returns the record at an offset of a mapped index */
+#define indexName(record) ((char *) ((record) + 1)) /* Returns the name that follows a record */
+
+unsigned long indexHash(char *name); /* Returns the hash the index uses for a name */
+int indexAppend(char *fileName, char *module, indexSymbol *symbols, int count); /* Appends a module and its symbols to the index, creates it if needed, returns 0 on success */
+int indexMap(char *fileName, indexFile *idx, int exclusive); /* Maps an index to memory with a shared(or exclusive) lock and validates it, returns 0 on success */
+void indexUnmap(indexFile *idx); /* Unmaps an index that was mapped with indexMap and releases its lock */
+indexRecord *indexFirst(indexFile *idx, char *name); /* Returns the first record of a name, or NULL */
+indexRecord *indexNext(indexFile *idx, indexRecord *record, char *name); /* Returns the next record of the same name, or NULL */
+
+#endif
@@ -8,23 +8,34 @@
 #include "./status.h"
 #include "./strings.h"
 #include "./files.h"
+#include "./profile.h"
 
 /*
   This file holds utilities functions used throught the program.
 */
 
+#define DIAGNOSTIC_MAX (LINE_MAX * 4) /* Enough for the message of an error or a warning and the parts of the line it formats */
+
+static void (*diagnosticHandler)(int, int, char *) = NULL; /* Receives the errors and the warnings instead of the standard output, see setDiagnosticHandler */
+
 /*
   A macro function constructor, it expects a head of a linked list and the type of each node
   Creates a function that takes a label(string) and searches if one of the nodes label matches
   the given parameter, and returns the node if matches, otherwise returns NULL.
+  When compiled with PROFILE each lookup and node visited(a string compare each) is counted.
 */
 #define get_node_by_label(head, type)             \
   type *type##ByLabel(char *label)                \
   {                                               \
     type *cur = head;                             \
                                                   \
-    while (cur && strcmp(label, cur->label) != 0) \
+    profileCount(SYMBOL_LOOKUPS, 1);              \
+    while (cur) {                                 \
+      profileCount(SYMBOL_PROBES, 1);             \
+      if (strcmp(label, cur->label) == 0)         \
+        break;                                    \
       cur = cur->next;                            \
+    }                                             \
                                                   \
     return cur;                                   \
 }
@@ -38,12 +49,15 @@ get_node_by_label(dataHead, dataNode) /* Search function for the data table, fun
   func_name with determine the name, if func_name is s then the result name will be salloc, concatenated with alloc.
   The amount of allocate space will be the sizeof the type inserted as the second argument multipled by 'size' argument.
   The resulted function expects no paramters
+  The last 2 arguments are the counters(enum COUNTER) of allocations and bytes that are updated when compiled with PROFILE.
 */
-#define create_malloc(func_name, type, size)  \
+#define create_malloc(func_name, type, size, allocs, bytes)  \
   type *func_name##alloc(void)                \
   {                                           \
     type *p;                                  \
     p = (type *)malloc(size * sizeof(type));  \
+    profileCount(allocs, 1);                  \
+    profileCount(bytes, size * sizeof(type)); \
                                               \
     if (p == NULL)                            \
     {                                         \
@@ -54,9 +68,9 @@ get_node_by_label(dataHead, dataNode) /* Search function for the data table, fun
     return p;                                 \
   }
 
-create_malloc(l, char, LINE_MAX * sizeof(char)) /* Creates lalloc, allocates enough memory for a source code line */
-create_malloc(s, symbolNode, 1) /* Creates salloc, allocates memory for a symbolNode */
-create_malloc(d, dataNode, 1) /* Creates dalloc, allocates memory for a dataNode */
+create_malloc(l, char, LINE_MAX * sizeof(char), LINE_ALLOCS, LINE_BYTES) /* Creates lalloc, allocates enough memory for a source code line */
+create_malloc(s, symbolNode, 1, NODE_ALLOCS, NODE_BYTES) /* Creates salloc, allocates memory for a symbolNode */
+create_malloc(d, dataNode, 1, NODE_ALLOCS, NODE_BYTES) /* Creates dalloc, allocates memory for a dataNode */
 
 /*
   A macro that expects the head of a linked list, a new node to be inserted, and the pointer to the type of the node.
@@ -127,7 +141,12 @@ void addDataNode(char *label, int val) {
     printe("Not enough memory in the hardware, maximum memory size is %d", 0, MEMORY_SIZE);
   }
 
-  add_node(dataHead, new, dataNodePtr) /* Adds the node to the list */
+  if (dataHead == NULL) { /* Adds the node after the last node instead of walking the list to it like add_node */
+    dataHead = new;
+  } else {
+    dataTail->next = new;
+  }
+  dataTail = new;
 }
 
 /*
@@ -182,13 +201,19 @@ void frees(int args, ...) {
 void printe(char *msg, int args, ...) {
   va_list ap;
 
-  printf(PRED "%s" ASSEMBLY_EXT ":%d: Error: " PRES "%s", fileName, lineIndex, line); /* PRED is used to color the "Error" part of the string in red, next the file name is written with its extension, next the line where there is an error, PRES is used to restart the text color to its normal color(not red) */
-
   va_start(ap, args);
 
-  vprintf(msg, ap); /* The first argument is a message explaning what is the error, we can format the error like we do in printf */
-  putchar('\n');
-  putchar('\n');
+  if (diagnosticHandler != NULL) { /* The message is sent to the handler instead */
+    char message[DIAGNOSTIC_MAX];
+
+    vsprintf(message, msg, ap);
+    diagnosticHandler(lineIndex, 1, message);
+  } else {
+    printf(PRED "%s" ASSEMBLY_EXT ":%d: Error: " PRES "%s", fileName, lineIndex, line); /* PRED is used to color the "Error" part of the string in red, next the file name is written with its extension, next the line where there is an error, PRES is used to restart the text color to its normal color(not red) */
+    vprintf(msg, ap); /* The first argument is a message explaning what is the error, we can format the error like we do in printf */
+    putchar('\n');
+    putchar('\n');
+  }
 
   vfrees(args, ap); /* Optionally free any arguments */
 
@@ -205,17 +230,32 @@ void printe(char *msg, int args, ...) {
 void warning(char *msg, ...) {
   va_list ap;
 
-  printf(PYEL "%s" ASSEMBLY_EXT ":%d: Warning: " PRES "%s", fileName, lineIndex, line);
-
   va_start(ap, msg);
 
-  vprintf(msg, ap);
-  putchar('\n');
-  putchar('\n');
+  if (diagnosticHandler != NULL) {
+    char message[DIAGNOSTIC_MAX];
+
+    vsprintf(message, msg, ap);
+    diagnosticHandler(lineIndex, 0, message);
+  } else {
+    printf(PYEL "%s" ASSEMBLY_EXT ":%d: Warning: " PRES "%s", fileName, lineIndex, line);
+    vprintf(msg, ap);
+    putchar('\n');
+    putchar('\n');
+  }
 
   va_end(ap);
 }
 
+/*
+  Accepts a function that receives the line index, wether it is an error(1) or a warning(0) and the message of each
+  error and warning, or NULL to print them again.
+  Used by the language server(see xref.h) that reports them to the editor.
+*/
+void setDiagnosticHandler(void handler(int number, int isError, char *message)) {
+  diagnosticHandler = handler;
+}
+
 /*
   This function is not used anywhere.
   I used it during development to print the symbol table.
@@ -30,6 +30,7 @@ void vfrees(int args, va_list ap); /* The pair of frees, Frees the memory of the
 void frees(int args, ...); /* The pair of vfrees, initializes the va_list and calls vfrees to handle the logic to free the memory */
 void printe(char *msg, int args, ...); /* Prints an error message with the line it happend, A message explainig the error, arguments count and arguments to be freed, The explaning message can be formatted just like printf, the arguemnts to format will be placed after the arguemnts to free */
 void warning(char *msg, ...); /* Prints a warning message of the current file and its line, and a message exaplning the warning, the next arguemnts are used to format the warning message */
+void setDiagnosticHandler(void handler(int number, int isError, char *message)); /* Sends the errors and warnings to a function instead of printing them, NULL prints them again */
 
 
 /*
@@ -0,0 +1,539 @@
+#define _POSIX_C_SOURCE 200809L /* Required for fork, poll, sigaction, clock_gettime and reading directories */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <poll.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/inotify.h>
+#include "./watch.h"
+#include "./compile.h"
+#include "./files.h"
+#include "./data.h"
+#include "./strings.h"
+#include "./status.h"
+
+/*
+  This file holds the watch mode of the assembler, see watch.h.
+*/
+
+#define EVENTS_SIZE 4096 /* The size of the buffer the inotify events are read to */
+
+typedef struct watchedFile *watchedFilePtr;
+typedef struct watchedFile { /* A source of the watched directory */
+  char *name; /* The path of the source without its .as extension, as the assembler is given it */
+  char *source; /* The content that was compiled last, NULL if it wasn't compiled yet */
+  long size;
+  int pending; /* It changed and waits to be compiled */
+  double changed, due; /* When its last change was seen and when it may be compiled, in milliseconds */
+  watchedFilePtr next;
+} watchedFile;
+
+typedef struct worker { /* A process that compiles the files it is sent one after the other */
+  pid_t pid;
+  int request, result; /* The pipe the names of the files are written to and the pipe the results are read from */
+  watchedFilePtr file; /* The file it compiles, NULL when it is idle */
+  double changed; /* When the change of the file it compiles was seen */
+} worker;
+
+typedef struct workerResult { /* What a worker writes back after it compiled a file, its messages follow it */
+  int status, changed; /* The status of the compilation and the amount of outputs that changed */
+  double time; /* The milliseconds the compilation took */
+  long logSize; /* The size of the messages */
+} workerResult;
+
+static watchedFilePtr files; /* The sources of the directory that were seen */
+static worker workers[WATCH_MAX_WORKERS];
+static int workerCount, events = -1; /* events is the inotify instance */
+static volatile sig_atomic_t stopping; /* Set when the assembler is interrupted */
+
+/*
+  Returns the time of the monotonic clock in milliseconds.
+*/
+static double now(void) {
+  struct timespec time;
+
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return time.tv_sec * 1e3 + time.tv_nsec / 1e6;
+}
+
+/*
+  Called on SIGINT and SIGTERM, the main loop stops after it.
+*/
+static void stop(int number) {
+  stopping = 1;
+}
+
+/*
+  Reads exactly size bytes from the file descriptor, returns 0 on success and -1 at its end or on error.
+*/
+static int readAll(int fd, void *buf, size_t size) {
+  size_t done = 0;
+  ssize_t n;
+
+  while (done < size) {
+    if ((n = read(fd, (char *) buf + done, size - done)) <= 0) {
+      return -1;
+    }
+    done += n;
+  }
+  return 0;
+}
+
+/*
+  Writes exactly size bytes to the file descriptor, returns 0 on success.
+*/
+static int writeAll(int fd, void *buf, size_t size) {
+  size_t done = 0;
+  ssize_t n;
+
+  while (done < size) {
+    if ((n = write(fd, (char *) buf + done, size - done)) <= 0) {
+      return -1;
+    }
+    done += n;
+  }
+  return 0;
+}
+
+/*
+  Accepts the name of a file in the directory.
+  Returns wether it is a source, the hidden files editors create next to it(eg: .#NAME.as) are not.
+*/
+static int isSource(char *name) {
+  size_t length = strlen(name);
+
+  return length > strlen(ASSEMBLY_EXT) && strcmp(name + length - strlen(ASSEMBLY_EXT), ASSEMBLY_EXT) == 0 &&
+         *name != '.' && *name != '#';
+}
+
+/*
+  Accepts the directory and the name of a source in it.
+  Returns the watched file of the source, it is added if it wasn't seen before.
+*/
+static watchedFilePtr findFile(char *dir, char *name) {
+  size_t length = strlen(dir) + strlen(name) - strlen(ASSEMBLY_EXT) + 1;
+  char *path = malloc(strlen(dir) + strlen(name) + 2);
+  watchedFilePtr file;
+
+  if (path == NULL) {
+    printf("Cannot allocate memory\n");
+    exit(0);
+  }
+  sprintf(path, "%s/%s", dir, name);
+  path[length] = '\0'; /* Removes the extension */
+
+  for (file = files; file != NULL; file = file->next) {
+    if (strcmp(file->name, path) == 0) {
+      free(path);
+      return file;
+    }
+  }
+
+  if ((file = calloc(1, sizeof(watchedFile))) == NULL) {
+    printf("Cannot allocate memory\n");
+    exit(0);
+  }
+  file->name = path;
+  file->next = files;
+  files = file;
+  return file;
+}
+
+/*
+  Accepts the directory, a time and the milliseconds to wait before compiling.
+  Marks every source of the directory as changed at the time, returns the amount of sources or -1 if the directory
+  can't be read.
+*/
+static int scanDirectory(char *dir, double time, int delay) {
+  DIR *dp = opendir(dir);
+  struct dirent *entry;
+  watchedFilePtr file;
+  int count = 0;
+
+  if (dp == NULL) {
+    printf("Cannot read the directory %s\n", dir);
+    return -1;
+  }
+  while ((entry = readdir(dp)) != NULL) {
+    if (isSource(entry->d_name)) {
+      file = findFile(dir, entry->d_name);
+      file->pending = 1;
+      file->changed = time;
+      file->due = time + delay;
+      count++;
+    }
+  }
+  closedir(dp);
+  return count;
+}
+
+/*
+  Accepts the end of the request pipe and the start of the result pipe.
+  The loop of a worker process: reads the name of a file from the request pipe, compiles it and writes the result and the
+  messages of the compilation to the result pipe, until the request pipe is closed.
+*/
+static void runWorker(int request, int result) {
+  char name[FILENAME_MAX + 2], *text;
+  FILE *in = fdopen(request, "r"), *log = tmpfile();
+  workerResult res;
+  double start;
+
+  if (in == NULL || log == NULL) {
+    exit(1);
+  }
+  fflush(stdout);
+  dup2(fileno(log), STDOUT_FILENO); /* The messages of the compilation are written to the log and sent back with the result */
+
+  while (fgets(name, sizeof(name), in) != NULL) {
+    name[strcspn(name, "\n")] = '\0';
+    lseek(STDOUT_FILENO, 0, SEEK_SET);
+    if (ftruncate(STDOUT_FILENO, 0) != 0) {
+      exit(1);
+    }
+
+    lineIndex = 0; /* The lines are counted like in a new run of the assembler */
+    changedOutputs = 0;
+    start = now();
+    res.status = compileFile(name);
+    res.time = now() - start;
+    res.changed = changedOutputs;
+
+    fflush(stdout);
+    res.logSize = lseek(STDOUT_FILENO, 0, SEEK_CUR);
+    lseek(STDOUT_FILENO, 0, SEEK_SET);
+    if ((text = malloc(res.logSize + 1)) == NULL || readAll(STDOUT_FILENO, text, res.logSize) != 0) {
+      exit(1);
+    }
+    if (writeAll(result, &res, sizeof(res)) != 0 || writeAll(result, text, res.logSize) != 0) {
+      exit(1);
+    }
+    free(text);
+  }
+  exit(0);
+}
+
+/*
+  Accepts the index of a worker and forks its process.
+  Returns 0 on success, prints a message and returns -1 otherwise.
+*/
+static int startWorker(int index) {
+  worker *w = &workers[index];
+  int request[2], result[2], i;
+
+  if (pipe(request) != 0) {
+    printf("Cannot create a pipe\n");
+    return -1;
+  }
+  if (pipe(result) != 0) {
+    printf("Cannot create a pipe\n");
+    close(request[0]);
+    close(request[1]);
+    return -1;
+  }
+
+  fflush(stdout);
+  if ((w->pid = fork()) < 0) {
+    printf("Cannot start a worker\n");
+    close(request[0]);
+    close(request[1]);
+    close(result[0]);
+    close(result[1]);
+    return -1;
+  }
+
+  if (w->pid == 0) {
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    signal(SIGPIPE, SIG_DFL);
+    close(events);
+    for (i = 0; i < workerCount; i++) { /* The pipes of the other workers are closed so they see their end */
+      if (i != index && workers[i].pid > 0) {
+        close(workers[i].request);
+        close(workers[i].result);
+      }
+    }
+    close(request[1]);
+    close(result[0]);
+    runWorker(request[0], result[1]);
+  }
+
+  close(request[0]);
+  close(result[1]);
+  w->request = request[1];
+  w->result = result[0];
+  w->file = NULL;
+  return 0;
+}
+
+/*
+  Accepts a worker, closes its pipes and waits for its process to end.
+*/
+static void stopWorker(worker *w) {
+  close(w->request);
+  close(w->result);
+  waitpid(w->pid, NULL, 0);
+  w->pid = 0;
+}
+
+/*
+  Accepts a watched file.
+  Reads its source, returns 1 if it differs from the source that was compiled last and keeps it, 0 otherwise.
+*/
+static int readSource(watchedFilePtr file) {
+  char *path = addExtension(file->name, ASSEMBLY_EXT), *text;
+  FILE *fp = fopen(path, "rb");
+  long size;
+
+  free(path);
+  if (fp == NULL) { /* It was removed after it changed */
+    return 0;
+  }
+  fseek(fp, 0, SEEK_END);
+  size = ftell(fp);
+  rewind(fp);
+  if ((text = malloc(size + 1)) == NULL) {
+    printf("Cannot allocate memory\n");
+    exit(0);
+  }
+  size = fread(text, 1, size, fp);
+  fclose(fp);
+
+  if (file->source != NULL && size == file->size && memcmp(text, file->source, size) == 0) { /* It was written again as it was */
+    free(text);
+    return 0;
+  }
+  free(file->source);
+  file->source = text;
+  file->size = size;
+  return 1;
+}
+
+/*
+  Accepts the current time.
+  Sends every file whose changes stopped for WATCH_DEBOUNCE milliseconds to an idle worker, a file that a worker still
+  compiles waits for it.
+*/
+static void dispatch(double time) {
+  watchedFilePtr file;
+  int i, busy;
+
+  for (file = files; file != NULL; file = file->next) {
+    if (!file->pending || file->due > time) {
+      continue;
+    }
+    for (i = 0, busy = 0; i < workerCount; i++) {
+      busy |= workers[i].file == file;
+    }
+    for (i = 0; i < workerCount && workers[i].file != NULL; i++)
+      ;
+    if (busy || i == workerCount) {
+      continue;
+    }
+
+    file->pending = 0;
+    if (!readSource(file)) {
+      continue;
+    }
+    if (writeAll(workers[i].request, file->name, strlen(file->name)) != 0 || writeAll(workers[i].request, "\n", 1) != 0) {
+      printf("[watch] The worker that was sent %s stopped\n", file->name);
+      free(file->source);
+      file->source = NULL;
+      file->pending = 1;
+      stopWorker(&workers[i]);
+      if (startWorker(i) != 0) {
+        stopping = 1;
+      }
+      return;
+    }
+    workers[i].file = file;
+    workers[i].changed = file->changed;
+  }
+}
+
+/*
+  Accepts the index of a worker that finished compiling a file and the current time.
+  Prints the messages of the compilation and its times, a worker that stopped while compiling is started again.
+*/
+static void receive(int index, double time) {
+  worker *w = &workers[index];
+  watchedFilePtr file = w->file;
+  workerResult res;
+  char *text = NULL;
+
+  w->file = NULL;
+  if (readAll(w->result, &res, sizeof(res)) != 0 || (text = malloc(res.logSize + 1)) == NULL ||
+      readAll(w->result, text, res.logSize) != 0) {
+    printf("[watch] %s: the worker stopped while it compiled it\n", file->name);
+    free(file->source); /* It is compiled again on its next change */
+    file->source = NULL;
+    free(text);
+    stopWorker(w);
+    if (startWorker(index) != 0) {
+      stopping = 1;
+    }
+    return;
+  }
+
+  fwrite(text, 1, res.logSize, stdout);
+  free(text);
+  printf("[watch] %s: %s in %.3f ms, %.3f ms after the change, %d output%s changed\n", file->name,
+         res.status == OK_STATUS ? "compiled" : "failed", res.time, time - w->changed, res.changed, res.changed == 1 ? "" : "s");
+}
+
+/*
+  Accepts the directory.
+  Reads the pending inotify events and marks the sources they changed, returns -1 if the directory was removed.
+*/
+static int readEvents(char *dir) {
+  static union { /* Aligned for the events */
+    struct inotify_event event;
+    char data[EVENTS_SIZE];
+  } buffer;
+  struct inotify_event *event;
+  watchedFilePtr file;
+  ssize_t size = read(events, buffer.data, EVENTS_SIZE);
+  char *p;
+
+  for (p = buffer.data; size > 0 && p < buffer.data + size; p += sizeof(struct inotify_event) + event->len) {
+    event = (struct inotify_event *) p;
+    if (event->mask & IN_IGNORED) {
+      printf("[watch] %s was removed\n", dir);
+      return -1;
+    }
+    if (event->mask & IN_Q_OVERFLOW) { /* Some events were lost */
+      scanDirectory(dir, now(), WATCH_DEBOUNCE);
+    } else if (event->len > 0 && isSource(event->name)) {
+      file = findFile(dir, event->name);
+      if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+        free(file->source); /* It is compiled again when it is back */
+        file->source = NULL;
+        file->pending = 0;
+      } else {
+        file->pending = 1;
+        file->changed = now();
+        file->due = file->changed + WATCH_DEBOUNCE;
+      }
+    }
+  }
+  return 0;
+}
+
+/*
+  Accepts the current time.
+  Returns the milliseconds poll should wait for, until the debounce of the next pending file passes(-1 for none).
+  The files whose debounce passed already wait for a worker, its result ends the poll.
+*/
+static int nextTimeout(double time) {
+  watchedFilePtr file;
+  double next = -1;
+
+  for (file = files; file != NULL; file = file->next) {
+    if (file->pending && file->due > time && (next < 0 || file->due < next)) {
+      next = file->due;
+    }
+  }
+  return next < 0 ? -1 : (int) (next - time) + 1;
+}
+
+/*
+  Accepts a directory.
+  Compiles all of its sources and then compiles the ones that change again, until SIGINT or SIGTERM.
+  Returns 0 when it was interrupted, prints a message and returns -1 if it couldn't start.
+*/
+int watchDirectory(char *dir) {
+  struct pollfd fds[WATCH_MAX_WORKERS + 1];
+  int owners[WATCH_MAX_WORKERS + 1], count, n, i, status = 0;
+  struct sigaction action;
+  watchedFilePtr file;
+  double start;
+  long processors = sysconf(_SC_NPROCESSORS_ONLN);
+
+  if ((events = inotify_init()) < 0 ||
+      inotify_add_watch(events, dir, IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_ONLYDIR) < 0) {
+    printf("Cannot watch the directory %s\n", dir);
+    if (events >= 0) {
+      close(events);
+    }
+    return -1;
+  }
+
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = stop; /* Without SA_RESTART, so poll returns */
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+  signal(SIGPIPE, SIG_IGN); /* A worker that stopped is seen when writing to it fails */
+
+  count = processors < 1 ? 1 : processors > WATCH_MAX_WORKERS ? WATCH_MAX_WORKERS : processors;
+  for (workerCount = 0; workerCount < count; workerCount++) {
+    if (startWorker(workerCount) != 0) {
+      status = -1;
+      stopping = 1;
+      break;
+    }
+  }
+
+  start = now();
+  if (!stopping && (count = scanDirectory(dir, start, 0)) < 0) {
+    status = -1;
+    stopping = 1;
+  } else if (!stopping) {
+    printf("[watch] Compiling the %d sources of %s with %d workers\n", count, dir, workerCount);
+  }
+
+  while (!stopping) {
+    double time = now();
+
+    dispatch(time);
+    for (i = 0, n = 1; i < workerCount; i++) {
+      if (workers[i].file != NULL) {
+        fds[n].fd = workers[i].result;
+        fds[n].events = POLLIN;
+        owners[n++] = i;
+      }
+    }
+    if (start >= 0 && n == 1 && nextTimeout(time) < 0) { /* The first build is done */
+      printf("[watch] Compiled the sources of %s in %.3f ms, watching it for changes\n", dir, time - start);
+      start = -1;
+    }
+    fflush(stdout);
+
+    fds[0].fd = events;
+    fds[0].events = POLLIN;
+    if (poll(fds, n, nextTimeout(time)) < 0) { /* Interrupted */
+      continue;
+    }
+    if ((fds[0].revents & POLLIN) && readEvents(dir) != 0) {
+      break;
+    }
+    for (i = 1; i < n; i++) {
+      if (fds[i].revents != 0) {
+        receive(owners[i], now());
+      }
+    }
+  }
+
+  for (i = 0; i < workerCount; i++) {
+    if (workers[i].pid > 0) {
+      stopWorker(&workers[i]);
+    }
+  }
+  close(events);
+  while (files != NULL) {
+    file = files;
+    files = files->next;
+    free(file->name);
+    free(file->source);
+    free(file);
+  }
+  if (status == 0) {
+    printf("[watch] Stopped\n");
+  }
+  return status;
+}
@@ -0,0 +1,22 @@
+#ifndef WATCH_H
+#define WATCH_H
+
+/*
+  Watch mode of the assembler(--watch DIR), it keeps compiling the .as files of a directory whenever they change.
+  All the sources of the directory are compiled when it starts, after that inotify reports the files that were written
+  or moved into the directory and only they are compiled again. A file is compiled once the changes to it stopped for
+  WATCH_DEBOUNCE milliseconds(an editor may write it a few times when it is saved), and not at all if its content is the
+  same as the content that was compiled last.
+  The files are compiled by a pool of worker processes that are forked once and kept for every rebuild(the assembler
+  keeps its tables in globals, so a file is compiled by a single process). A worker compiles a file the way the
+  assembler does, its messages are printed together with the time the compilation took and the time since the change.
+  The outputs are written only when their content changed(see files.h), a file that isn't changed is left as it is.
+  The subdirectories are not watched, it runs until it is interrupted.
+*/
+
+#define WATCH_DEBOUNCE 50 /* The milliseconds to wait after the last change of a file before compiling it */
+#define WATCH_MAX_WORKERS 8 /* The most workers that are started, there is one for every processor up to it */
+
+int watchDirectory(char *dir); /* Compiles the sources of a directory and compiles them again when they change, returns 0 when it was interrupted and -1 if it couldn't start */
+
+#endif
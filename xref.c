@@ -0,0 +1,409 @@
+#define _POSIX_C_SOURCE 200809L /* Required for fmemopen */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "./xref.h"
+#include "./compile.h"
+#include "./scan.h"
+#include "./data.h"
+#include "./utils.h"
+#include "./strings.h"
+#include "./status.h"
+#include "./files.h"
+
+/*
+  This file holds the cross reference index of the language server, see xref.h.
+*/
+
+#define LINES_CHUNK 256 /* The amount of lines the lines of a document grow by */
+#define NAMES_CHUNK 4 /* The amount of names the names of a line grow by */
+
+enum GUIDANCE_KIND /* The guidances whose names are definitions */
+{
+  OTHER_GUIDANCE,
+  DEFINE_GUIDANCE,
+  EXTERN_GUIDANCE
+};
+
+static xrefDocumentPtr documents; /* The open documents */
+static xrefDocumentPtr checked; /* The document that is checked, it receives the diagnostics */
+static int scannedLines; /* The amount of lines of the checked document the scans read */
+
+/*
+  Accepts a pointer that was allocated and its new size, reallocates it.
+  Exits when there is not enough memory, like the allocations of utils.c.
+*/
+static void *grow(void *ptr, size_t size) {
+  if ((ptr = realloc(ptr, size)) == NULL) {
+    printf("Cannot allocate memory\n");
+    exit(0);
+  }
+  return ptr;
+}
+
+/*
+  Accepts a line, the kind of a name and its columns, adds the name to the names of the line.
+*/
+static void addName(xrefLine *cur, int kind, int start, int end) {
+  xrefName *name;
+
+  if (cur->nameCount % NAMES_CHUNK == 0) {
+    cur->names = grow(cur->names, sizeof(xrefName) * (cur->nameCount + NAMES_CHUNK));
+  }
+  name = &cur->names[cur->nameCount++];
+  name->name = grow(NULL, end - start + 1);
+  strncpy(name->name, cur->text + start, end - start);
+  name->name[end - start] = '\0';
+  name->kind = kind;
+  name->start = start;
+  name->end = end;
+}
+
+/*
+  Frees the names of a line.
+*/
+static void freeNames(xrefLine *cur) {
+  int i;
+
+  for (i = 0; i < cur->nameCount; i++) {
+    free(cur->names[i].name);
+  }
+  free(cur->names);
+  cur->names = NULL;
+  cur->nameCount = 0;
+}
+
+/*
+  Splits a line to its names. The first word of the line is its label when it ends with ':', the next word is its
+  command or guidance and the names after them are the names it defines or uses. The characters of a string, the
+  numbers and the registers are not names.
+*/
+static void splitNames(xrefLine *cur) {
+  char *text = cur->text;
+  int i = 0, start, words = 0, guidance = OTHER_GUIDANCE, operands = 0;
+
+  freeNames(cur);
+  while (isspace(text[i])) {
+    i++;
+  }
+  if (text[i] == ';') { /* A comment */
+    return;
+  }
+
+  while (text[i] != '\0') {
+    if (text[i] == '"') { /* Skips a string */
+      for (i++; text[i] != '\0' && text[i] != '"'; i++)
+        ;
+      i += text[i] == '"';
+      continue;
+    }
+    if (!isalpha(text[i]) || (i > 0 && (isalnum(text[i - 1]) || text[i - 1] == '.'))) {
+      if (text[i] == '.' && words == 0) { /* A guidance, its name ends the label */
+        for (start = ++i; isalnum(text[i]); i++)
+          ;
+        guidance = strncmp(text + start, "define", i - start) == 0 && i - start == 6 ? DEFINE_GUIDANCE :
+                   strncmp(text + start, "extern", i - start) == 0 && i - start == 6 ? EXTERN_GUIDANCE : OTHER_GUIDANCE;
+        words++;
+      } else {
+        i++;
+      }
+      continue;
+    }
+
+    for (start = i; isalnum(text[i]); i++)
+      ;
+    if (words == 0 && text[i] == ':') { /* The label of the line */
+      addName(cur, XREF_LABEL, start, i++);
+    } else if (words++ == 0) { /* The command */
+      continue;
+    } else if (text[start] == 'r' && i - start > 1 && strspn(text + start + 1, "0123456789") == i - start - 1) { /* A register */
+      continue;
+    } else if (guidance == DEFINE_GUIDANCE) {
+      addName(cur, operands++ == 0 ? XREF_MACRO : XREF_USE, start, i);
+    } else {
+      addName(cur, guidance == EXTERN_GUIDANCE ? XREF_EXTERNAL : XREF_USE, start, i);
+    }
+  }
+}
+
+/*
+  Accepts a document, the index of a line and a text without new lines, inserts the line before the index.
+*/
+static void insertLine(xrefDocumentPtr doc, int index, char *text, int length) {
+  xrefLine *cur;
+
+  if (doc->lineCount == doc->lineCapacity) {
+    doc->lineCapacity += LINES_CHUNK;
+    doc->lines = grow(doc->lines, sizeof(xrefLine) * doc->lineCapacity);
+  }
+  memmove(&doc->lines[index + 1], &doc->lines[index], sizeof(xrefLine) * (doc->lineCount++ - index));
+  cur = &doc->lines[index];
+  cur->text = grow(NULL, length + 1);
+  strncpy(cur->text, text, length);
+  cur->text[length] = '\0';
+  cur->names = NULL;
+  cur->nameCount = 0;
+  splitNames(cur);
+}
+
+/*
+  Accepts a document and a range of its lines, frees them and removes them.
+*/
+static void removeLines(xrefDocumentPtr doc, int first, int count) {
+  int i;
+
+  for (i = first; i < first + count; i++) {
+    free(doc->lines[i].text);
+    freeNames(&doc->lines[i]);
+  }
+  memmove(&doc->lines[first], &doc->lines[first + count], sizeof(xrefLine) * (doc->lineCount - first - count));
+  doc->lineCount -= count;
+}
+
+/*
+  Accepts a document, replaces a range of its text with a new text. The lines of the range are split again, the
+  other lines keep their names. When startLine is negative the whole text is replaced.
+*/
+void xrefEdit(xrefDocumentPtr doc, int startLine, int startColumn, int endLine, int endColumn, char *text) {
+  char *combined, *part, *newLine;
+  int length;
+
+  if (startLine < 0 || doc->lineCount == 0) {
+    removeLines(doc, 0, doc->lineCount);
+    insertLine(doc, 0, "", 0);
+    startLine = startColumn = endLine = endColumn = 0;
+  }
+  /* Positions after the end of a line or of the document are moved to their end, like editors expect */
+  startLine = startLine >= doc->lineCount ? doc->lineCount - 1 : startLine;
+  endLine = endLine >= doc->lineCount ? doc->lineCount - 1 : endLine < startLine ? startLine : endLine;
+  startColumn = startColumn > strlen(doc->lines[startLine].text) ? strlen(doc->lines[startLine].text) : startColumn;
+  endColumn = endColumn > strlen(doc->lines[endLine].text) ? strlen(doc->lines[endLine].text) : endColumn;
+  if (endLine == startLine && endColumn < startColumn) {
+    endColumn = startColumn;
+  }
+
+  length = startColumn + strlen(text) + strlen(doc->lines[endLine].text + endColumn);
+  combined = grow(NULL, length + 1);
+  strncpy(combined, doc->lines[startLine].text, startColumn);
+  strcpy(combined + startColumn, text);
+  strcat(combined, doc->lines[endLine].text + endColumn);
+
+  removeLines(doc, startLine, endLine - startLine + 1);
+  for (part = combined; (newLine = strchr(part, '\n')) != NULL; part = newLine + 1) {
+    insertLine(doc, startLine++, part, newLine - part);
+  }
+  insertLine(doc, startLine, part, strlen(part));
+  free(combined);
+}
+
+/*
+  Receives the errors and the warnings of the scans of the checked document.
+  The second scan counts the lines of the document again after the lines of the first scan. The messages of the lines
+  of an included file are left out, the .include line reports them(see include.h).
+*/
+static void addDiagnostic(int number, int isError, char *message) {
+  xrefDiagnostic *cur;
+
+  if (fileName != checked->name) {
+    return;
+  }
+  if (checked->diagnosticCount == checked->diagnosticCapacity) {
+    checked->diagnosticCapacity += LINES_CHUNK;
+    checked->diagnostics = grow(checked->diagnostics, sizeof(xrefDiagnostic) * checked->diagnosticCapacity);
+  }
+  while (*message == '\n') {
+    message++;
+  }
+  cur = &checked->diagnostics[checked->diagnosticCount++];
+  cur->line = number - 1 - (scanCount == SECOND ? scannedLines : 0);
+  cur->isError = isError;
+  cur->message = copyString(message);
+}
+
+/*
+  Accepts a document, frees its symbols.
+*/
+static void freeSymbols(xrefDocumentPtr doc) {
+  int i;
+
+  for (i = 0; i < doc->symbolCount; i++) {
+    free(doc->symbols[i].label);
+  }
+  free(doc->symbols);
+  doc->symbols = NULL;
+  doc->symbolCount = 0;
+}
+
+/*
+  Accepts a document, frees its diagnostics.
+*/
+static void freeDiagnostics(xrefDocumentPtr doc) {
+  int i;
+
+  for (i = 0; i < doc->diagnosticCount; i++) {
+    free(doc->diagnostics[i].message);
+  }
+  doc->diagnosticCount = 0;
+}
+
+/*
+  Accepts a document and scans it with both scans, like the assembler compiles a file but without the outputs.
+  Keeps the errors and the warnings of the scans, and the symbol table unless the first scan failed(the addresses of
+  the labels of the data are only known after it).
+*/
+void xrefCheck(xrefDocumentPtr doc) {
+  char *text;
+  size_t size = 0;
+  symbolNodePtr node;
+  FILE *fp;
+  int i;
+
+  freeDiagnostics(doc);
+  for (i = 0; i < doc->lineCount; i++) {
+    size += strlen(doc->lines[i].text) + 1;
+  }
+  text = grow(NULL, size);
+  for (i = 0, size = 0; i < doc->lineCount; i++) { /* Every line ends with a new line as the scans expect, but an empty last line is left out */
+    strcpy(text + size, doc->lines[i].text);
+    size += strlen(doc->lines[i].text);
+    text[size++] = '\n';
+  }
+  scannedLines = doc->lineCount - (*doc->lines[doc->lineCount - 1].text == '\0');
+  size -= scannedLines < doc->lineCount;
+
+  if ((fp = size > 0 ? fmemopen(text, size, "r") : tmpfile()) == NULL) {
+    printf("Cannot allocate memory\n");
+    exit(0);
+  }
+
+  checked = doc;
+  lineIndex = 0;
+  setDiagnosticHandler(addDiagnostic);
+  doc->compiled = checkSource(doc->name, fp, scanFirst, scanSecond) == OK_STATUS;
+  setDiagnosticHandler(NULL);
+  fclose(fp);
+  free(text);
+
+  if (error == FIRST) { /* Keeps the symbols of the last check whose first scan succeeded */
+    return;
+  }
+  freeSymbols(doc);
+  for (node = symbolHead; node != NULL; node = node->next) {
+    doc->symbolCount++;
+  }
+  doc->symbols = grow(NULL, sizeof(xrefSymbol) * (doc->symbolCount + 1));
+  for (node = symbolHead, i = 0; node != NULL; node = node->next, i++) {
+    doc->symbols[i].label = copyString(node->label);
+    doc->symbols[i].val = node->val;
+    doc->symbols[i].type = node->type;
+  }
+}
+
+/*
+  Accepts the uri of a document and its text.
+  Opens the document and checks it, returns it.
+*/
+xrefDocumentPtr xrefOpen(char *uri, char *text) {
+  xrefDocumentPtr doc = grow(NULL, sizeof(xrefDocument));
+  char *name = strrchr(uri, '/') != NULL ? strrchr(uri, '/') + 1 : uri;
+
+  memset(doc, 0, sizeof(xrefDocument));
+  doc->uri = copyString(uri);
+  doc->name = copyString(name);
+  if (strlen(name) > strlen(ASSEMBLY_EXT) && strcmp(name + strlen(name) - strlen(ASSEMBLY_EXT), ASSEMBLY_EXT) == 0) {
+    doc->name[strlen(name) - strlen(ASSEMBLY_EXT)] = '\0'; /* The scans add the extension to their messages */
+  }
+
+  xrefEdit(doc, -1, 0, 0, 0, text);
+  xrefCheck(doc);
+  doc->next = documents;
+  documents = doc;
+  return doc;
+}
+
+/*
+  Accepts the uri of a document, returns the document if it is open and NULL otherwise.
+*/
+xrefDocumentPtr xrefFind(char *uri) {
+  xrefDocumentPtr doc;
+
+  for (doc = documents; doc != NULL && strcmp(doc->uri, uri) != 0; doc = doc->next)
+    ;
+  return doc;
+}
+
+/*
+  Accepts a document and a position.
+  Returns the name at the position, the position may also be right after the name. NULL if there is no name there.
+*/
+xrefName *xrefNameAt(xrefDocumentPtr doc, int line, int column) {
+  int i;
+
+  if (line < 0 || line >= doc->lineCount) {
+    return NULL;
+  }
+  for (i = 0; i < doc->lines[line].nameCount; i++) {
+    if (column >= doc->lines[line].names[i].start && column <= doc->lines[line].names[i].end) {
+      return &doc->lines[line].names[i];
+    }
+  }
+  return NULL;
+}
+
+/*
+  Accepts a document and a name.
+  Returns the first label, macro or external of the name in the document and sets line to its line, NULL if the name
+  isn't defined.
+*/
+xrefName *xrefDefinition(xrefDocumentPtr doc, char *name, int *line) {
+  int i, j;
+
+  for (i = 0; i < doc->lineCount; i++) {
+    for (j = 0; j < doc->lines[i].nameCount; j++) {
+      if (doc->lines[i].names[j].kind != XREF_USE && strcmp(doc->lines[i].names[j].name, name) == 0) {
+        *line = i;
+        return &doc->lines[i].names[j];
+      }
+    }
+  }
+  return NULL;
+}
+
+/*
+  Accepts a document and a name, returns the symbol of the name from the last check, NULL if it has none.
+*/
+xrefSymbol *xrefSymbolOf(xrefDocumentPtr doc, char *name) {
+  int i;
+
+  for (i = 0; i < doc->symbolCount; i++) {
+    if (strcmp(doc->symbols[i].label, name) == 0) {
+      return &doc->symbols[i];
+    }
+  }
+  return NULL;
+}
+
+/*
+  Accepts a document, closes it and frees its memory.
+*/
+void xrefClose(xrefDocumentPtr doc) {
+  xrefDocumentPtr *link = &documents;
+
+  while (*link != NULL && *link != doc) {
+    link = &(*link)->next;
+  }
+  if (*link != NULL) {
+    *link = doc->next;
+  }
+
+  removeLines(doc, 0, doc->lineCount);
+  freeSymbols(doc);
+  freeDiagnostics(doc);
+  free(doc->lines);
+  free(doc->diagnostics);
+  free(doc->uri);
+  free(doc->name);
+  free(doc);
+}
@@ -0,0 +1,64 @@
+#ifndef XREF_H
+#define XREF_H
+
+/*
+  The cross reference index of the source documents the language server keeps open, see oblsp.c.
+  A document is kept as its lines. Each line is split to its names once, when it is added or changed: the label it
+  defines, the macro of a .define, the externals of an .extern and the names its operands use(and .entry), each with
+  the columns it takes. After every change the whole document is scanned again by both scans without writing outputs
+  (see checkSource), the errors and the warnings they report are kept in the document with its symbol table.
+  Lines and columns are counted from 0, the end of a name is the column after it.
+*/
+
+enum XREF_KIND /* The kinds of the names in a line */
+{
+  XREF_LABEL, /* The label a line defines */
+  XREF_MACRO, /* The macro a .define defines */
+  XREF_EXTERNAL, /* An external an .extern defines */
+  XREF_USE /* A name an operand, a .data or an .entry uses */
+};
+
+typedef struct xrefName {
+  char *name;
+  int kind, start, end; /* enum XREF_KIND and the columns of the name */
+} xrefName;
+
+typedef struct xrefLine {
+  char *text; /* The line without its new line */
+  xrefName *names;
+  int nameCount;
+} xrefLine;
+
+typedef struct xrefSymbol { /* A copy of a node of the symbol table */
+  char *label;
+  int val, type; /* enum SYMBOL_TYPE */
+} xrefSymbol;
+
+typedef struct xrefDiagnostic {
+  int line, isError; /* A warning when isError is 0 */
+  char *message;
+} xrefDiagnostic;
+
+typedef struct xrefDocument *xrefDocumentPtr;
+typedef struct xrefDocument {
+  char *uri, *name; /* The name is the name of the file without its directory and its .as extension */
+  xrefLine *lines;
+  int lineCount, lineCapacity;
+  xrefSymbol *symbols; /* The symbol table of the last check whose first scan succeeded */
+  int symbolCount;
+  xrefDiagnostic *diagnostics; /* The errors and the warnings of the last check */
+  int diagnosticCount, diagnosticCapacity;
+  int compiled; /* Both scans of the last check succeeded */
+  xrefDocumentPtr next;
+} xrefDocument;
+
+xrefDocumentPtr xrefOpen(char *uri, char *text); /* Opens a document with its text and checks it */
+xrefDocumentPtr xrefFind(char *uri); /* Returns the open document of a uri, NULL if it isn't open */
+void xrefEdit(xrefDocumentPtr doc, int startLine, int startColumn, int endLine, int endColumn, char *text); /* Replaces a range of the text(the whole text when startLine is negative) without checking the document */
+void xrefCheck(xrefDocumentPtr doc); /* Scans the document again and keeps its symbol table and diagnostics */
+xrefName *xrefNameAt(xrefDocumentPtr doc, int line, int column); /* Returns the name at a position, NULL if there is none */
+xrefName *xrefDefinition(xrefDocumentPtr doc, char *name, int *line); /* Returns the name that defines a name and sets its line, NULL if it isn't defined */
+xrefSymbol *xrefSymbolOf(xrefDocumentPtr doc, char *name); /* Returns the symbol of a name, NULL if it has none */
+void xrefClose(xrefDocumentPtr doc); /* Closes a document and frees it */
+
+#endif